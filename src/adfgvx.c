@@ -0,0 +1,3830 @@
+/**
+ * Biblioteca: Cifra ADFGVX
+ *
+ * Licença: MIT License.
+ *
+ * Implementação da biblioteca declarada em adfgvx.h: tabelas Polybius, caminho original com matriz de
+ * colunas, escrita/leitura direta de cada símbolo, kernels SIMD com escolha em tempo de execução,
+ * arena e contexto reutilizável, escalonamentos de chave com cache LRU, e a API
+ * adfgvx_encrypt/adfgvx_decrypt (e variantes batch e com escalonamento).
+ *
+ * Não faz E/S (exceto read_file, usada pelo programa e pelos testes) nem alocações dinâmicas.
+ */
+
+#include "adfgvx_internal.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef ADFGVX_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// Transposição em blocos: linhas e colunas por bloco, tamanho da janela de símbolos (na pilha) dos
+// caminhos diretos e comprimento de chave a partir do qual eles passam a usar a janela em blocos
+#define TRANSPOSE_TILE_ROWS 64
+#define TRANSPOSE_TILE_COLUMNS 64
+#define BLOCKED_WINDOW_SYMBOLS 65536
+#define BLOCKED_KEY_LENGTH 32
+// Caminhos paralelos: quantidade mínima de bytes (ou símbolos) por thread; mensagens menores usam menos threads
+#define PARALLEL_MIN_BYTES ((size_t)1 << 16)
+// Transposição no lugar: bit que marca os símbolos já colocados na posição final (símbolos ADFGVX são ASCII)
+#define IN_PLACE_MARK ((char)0x80)
+
+const char symbols[6] = {'A', 'D', 'F', 'G', 'V', 'X'};
+const char square[6][6] = {
+    {'A', 'B', 'C', 'D', 'E', 'F'},
+    {'G', 'H', 'I', 'J', 'K', 'L'},
+    {'M', 'N', 'O', 'P', 'Q', 'R'},
+    {'S', 'T', 'U', 'V', 'W', 'X'},
+    {'Y', 'Z', ' ', ',', '.', '1'},
+    {'2', '3', '4', '5', '6', '7'}};
+
+const unsigned short polybius_forward[256] = {
+    ['A'] = POLYBIUS_PAIR('A', 'A'), ['B'] = POLYBIUS_PAIR('A', 'D'), ['C'] = POLYBIUS_PAIR('A', 'F'), ['D'] = POLYBIUS_PAIR('A', 'G'), ['E'] = POLYBIUS_PAIR('A', 'V'), ['F'] = POLYBIUS_PAIR('A', 'X'),
+    ['G'] = POLYBIUS_PAIR('D', 'A'), ['H'] = POLYBIUS_PAIR('D', 'D'), ['I'] = POLYBIUS_PAIR('D', 'F'), ['J'] = POLYBIUS_PAIR('D', 'G'), ['K'] = POLYBIUS_PAIR('D', 'V'), ['L'] = POLYBIUS_PAIR('D', 'X'),
+    ['M'] = POLYBIUS_PAIR('F', 'A'), ['N'] = POLYBIUS_PAIR('F', 'D'), ['O'] = POLYBIUS_PAIR('F', 'F'), ['P'] = POLYBIUS_PAIR('F', 'G'), ['Q'] = POLYBIUS_PAIR('F', 'V'), ['R'] = POLYBIUS_PAIR('F', 'X'),
+    ['S'] = POLYBIUS_PAIR('G', 'A'), ['T'] = POLYBIUS_PAIR('G', 'D'), ['U'] = POLYBIUS_PAIR('G', 'F'), ['V'] = POLYBIUS_PAIR('G', 'G'), ['W'] = POLYBIUS_PAIR('G', 'V'), ['X'] = POLYBIUS_PAIR('G', 'X'),
+    ['Y'] = POLYBIUS_PAIR('V', 'A'), ['Z'] = POLYBIUS_PAIR('V', 'D'), [' '] = POLYBIUS_PAIR('V', 'F'), [','] = POLYBIUS_PAIR('V', 'G'), ['.'] = POLYBIUS_PAIR('V', 'V'), ['1'] = POLYBIUS_PAIR('V', 'X'),
+    ['2'] = POLYBIUS_PAIR('X', 'A'), ['3'] = POLYBIUS_PAIR('X', 'D'), ['4'] = POLYBIUS_PAIR('X', 'F'), ['5'] = POLYBIUS_PAIR('X', 'G'), ['6'] = POLYBIUS_PAIR('X', 'V'), ['7'] = POLYBIUS_PAIR('X', 'X')};
+
+// Mesma tabela com índices (0 a 5) dos símbolos no lugar das letras: posição p da matriz -> (p / 6, p % 6)
+#define INDEX_PAIR(cell) POLYBIUS_PAIR((cell) / 6, (cell) % 6)
+const unsigned short polybius_forward_indices[256] = {
+    ['A'] = INDEX_PAIR(0), ['B'] = INDEX_PAIR(1), ['C'] = INDEX_PAIR(2), ['D'] = INDEX_PAIR(3), ['E'] = INDEX_PAIR(4), ['F'] = INDEX_PAIR(5),
+    ['G'] = INDEX_PAIR(6), ['H'] = INDEX_PAIR(7), ['I'] = INDEX_PAIR(8), ['J'] = INDEX_PAIR(9), ['K'] = INDEX_PAIR(10), ['L'] = INDEX_PAIR(11),
+    ['M'] = INDEX_PAIR(12), ['N'] = INDEX_PAIR(13), ['O'] = INDEX_PAIR(14), ['P'] = INDEX_PAIR(15), ['Q'] = INDEX_PAIR(16), ['R'] = INDEX_PAIR(17),
+    ['S'] = INDEX_PAIR(18), ['T'] = INDEX_PAIR(19), ['U'] = INDEX_PAIR(20), ['V'] = INDEX_PAIR(21), ['W'] = INDEX_PAIR(22), ['X'] = INDEX_PAIR(23),
+    ['Y'] = INDEX_PAIR(24), ['Z'] = INDEX_PAIR(25), [' '] = INDEX_PAIR(26), [','] = INDEX_PAIR(27), ['.'] = INDEX_PAIR(28), ['1'] = INDEX_PAIR(29),
+    ['2'] = INDEX_PAIR(30), ['3'] = INDEX_PAIR(31), ['4'] = INDEX_PAIR(32), ['5'] = INDEX_PAIR(33), ['6'] = INDEX_PAIR(34), ['7'] = INDEX_PAIR(35)};
+
+// Tabelas inversas: symbol_rank[s] é o índice do símbolo s em `symbols` mais 1 (0 para símbolos inválidos)
+// e polybius_reverse[rank_linha][rank_coluna] é o caractere do par, ou '\0' se algum símbolo for inválido.
+const unsigned char symbol_rank[256] = {['A'] = 1, ['D'] = 2, ['F'] = 3, ['G'] = 4, ['V'] = 5, ['X'] = 6};
+const char polybius_reverse[7][7] = {
+    {'\0', '\0', '\0', '\0', '\0', '\0', '\0'},
+    {'\0', 'A', 'B', 'C', 'D', 'E', 'F'},
+    {'\0', 'G', 'H', 'I', 'J', 'K', 'L'},
+    {'\0', 'M', 'N', 'O', 'P', 'Q', 'R'},
+    {'\0', 'S', 'T', 'U', 'V', 'W', 'X'},
+    {'\0', 'Y', 'Z', ' ', ',', '.', '1'},
+    {'\0', '2', '3', '4', '5', '6', '7'}};
+
+// Matriz padrão linha a linha, com folga para as leituras vetoriais de 16 bytes dos kernels
+static const char default_cells[POLYBIUS_CELLS_PADDED] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ ,.1234567";
+// Símbolos de linha e de coluna de cada posição da matriz padrão (usados pelos kernels vetoriais)
+static const char default_row_symbols[POLYBIUS_CELLS_PADDED] = "AAAAAADDDDDDFFFFFFGGGGGGVVVVVVXXXXXX";
+static const char default_col_symbols[POLYBIUS_CELLS_PADDED] = "ADFGVXADFGVXADFGVXADFGVXADFGVXADFGVX";
+// Índices de linha e de coluna de cada posição da matriz padrão (kernels vetoriais com polybius_square_index_view)
+static const char default_row_indices[POLYBIUS_CELLS_PADDED] = {0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2,
+                                                                3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5};
+static const char default_col_indices[POLYBIUS_CELLS_PADDED] = {0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5,
+                                                                0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5};
+const polybius_square polybius_default_square = {polybius_forward, polybius_reverse, default_cells, default_row_symbols, default_col_symbols, 1,
+                                                 polybius_forward_indices, default_row_indices, default_col_indices};
+
+/**
+ * @brief Lê o conteúdo de um arquivo em um buffer.
+ *
+ * @param filename Caminho para o arquivo a ser lido.
+ * @param buffer Buffer onde o conteúdo será armazenado.
+ * @param max_length Tamanho máximo permitido do buffer.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int read_file(const char *filename, char *buffer, int max_length)
+{
+  FILE *file = fopen(filename, "r");
+  if (file == NULL)
+  {
+    return 1;
+  }
+
+  fgets(buffer, max_length, file);
+
+  fclose(file);
+  return 0;
+}
+
+/**
+ * @brief Encontra os símbolos ADFGVX correspondentes a um caractere.
+ *
+ * @param c Caractere a ser cifrado.
+ * @param row Ponteiro para armazenar o símbolo da linha.
+ * @param col Ponteiro para armazenar o símbolo da coluna.
+ * @return int Retorna 1 se o caractere foi encontrado, 0 caso contrário.
+ */
+int get_adfgvx_symbols(char c, char *row, char *col)
+{
+  unsigned short pair = polybius_forward[(unsigned char)c];
+
+  if (!(pair & POLYBIUS_VALID))
+  {
+    return 0;
+  }
+
+  *row = POLYBIUS_ROW(pair);
+  *col = POLYBIUS_COL(pair);
+  return 1;
+}
+
+/**
+ * @brief Insere um símbolo ADFGVX na matriz de colunas.
+ * @param key_length Comprimento da chave.
+ * @param max_per_column Número máximo de posições em cada coluna
+ * @param symbol Símbolo a ser inserido (row ou col).
+ * @param symbol_count Contador global de símbolos (será incrementado).
+ * @param encoded_symbol_matrix Matriz de saída contendo os símbolos organizados por coluna.
+ * @param symbols_per_column Vetor com a quantidade de símbolos por coluna (será atualizado).
+ */
+void insert_symbol_to_column(int key_length, int max_per_column, char symbol, int *symbol_count, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+{
+  int col_index = (*symbol_count) % key_length;
+  int write_pos = symbols_per_column[col_index];
+
+  encoded_symbol_matrix[col_index][write_pos] = symbol;
+  symbols_per_column[col_index]++;
+  (*symbol_count)++;
+}
+
+/**
+ * @brief Converte a mensagem em colunas de símbolos ADFGVX para cifra por transposição.
+ * @param key_length Comprimento da chave.
+ * @param max_per_column Número máximo de posições em cada coluna
+ * @param message Mensagem original a ser cifrada.
+ * @param encoded_symbol_matrix Matriz onde os símbolos cifrados serão armazenados por coluna.
+ * @param symbols_per_column Vetor que armazena o número de elementos em cada coluna.
+ */
+void polybius_encode_to_columns(int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+{
+  int i, symbol_count = 0;
+
+  for (i = 0; message[i] != '\0'; i++)
+  {
+    // Uma única consulta na tabela substitui a busca nas 36 posições da matriz
+    unsigned short pair = polybius_forward[(unsigned char)message[i]];
+
+    // Ignora caracteres que não estão na matriz Polybius
+    if (!(pair & POLYBIUS_VALID))
+    {
+      continue;
+    }
+
+    insert_symbol_to_column(key_length, max_per_column, POLYBIUS_ROW(pair), &symbol_count, encoded_symbol_matrix, symbols_per_column);
+    insert_symbol_to_column(key_length, max_per_column, POLYBIUS_COL(pair), &symbol_count, encoded_symbol_matrix, symbols_per_column);
+  }
+}
+
+/**
+ * @brief Reorganiza as colunas da matriz com base na ordem alfabética da chave.
+ * @param key A chave usada na transposição (array de caracteres).
+ * @param key_length Comprimento da chave.
+ * @param max_per_column Número máximo de posições em cada coluna
+ * @param encoded_symbol_matrix Matriz com os dados cifrados por colunas.
+ * @param symbols_per_column Vetor com o número de elementos em cada coluna.
+ */
+void transpose_columns_by_key_order(char key[], int key_length, int max_per_column, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+{
+  int i, j, k;
+  char sorted_key[key_length];
+  int temp_count;
+
+  // Copia a chave original para preservar sua ordem
+  for (i = 0; i < key_length; i++)
+  {
+    sorted_key[i] = key[i];
+  }
+
+  // Ordenação da chave e reorganização das colunas
+  for (i = 0; i < key_length - 1; i++)
+  {
+    for (j = 0; j < key_length - i - 1; j++)
+    {
+      if (sorted_key[j] > sorted_key[j + 1])
+      {
+        // Troca os caracteres da chave ordenada
+        char tmp = sorted_key[j];
+        sorted_key[j] = sorted_key[j + 1];
+        sorted_key[j + 1] = tmp;
+
+        // Troca símbolo por símbolo das colunas associadas (até max_per_column)
+        for (k = 0; k < max_per_column; k++)
+        {
+          char temp = encoded_symbol_matrix[j][k];
+          encoded_symbol_matrix[j][k] = encoded_symbol_matrix[j + 1][k];
+          encoded_symbol_matrix[j + 1][k] = temp;
+        }
+
+        // Troca o contador de elementos de cada coluna
+        temp_count = symbols_per_column[j];
+        symbols_per_column[j] = symbols_per_column[j + 1];
+        symbols_per_column[j + 1] = temp_count;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Aplica a cifra ADFGVX: codifica os símbolos e faz a transposição das colunas.
+ * @param key A chave usada na transposição (array de caracteres).
+ * @param key_length Comprimento da chave.
+ * @param max_per_column Número máximo de posições em cada coluna
+ * @param message Mensagem de entrada.
+ * @param encoded_symbol_matrix Matriz onde os símbolos codificados serão armazenados.
+ * @param symbols_per_column Vetor com a contagem de elementos em cada coluna.
+ */
+void cipher_adfgvx(char key[], int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+{
+  polybius_encode_to_columns(key_length, max_per_column, message, encoded_symbol_matrix, symbols_per_column);
+  transpose_columns_by_key_order(key, key_length, max_per_column, encoded_symbol_matrix, symbols_per_column);
+}
+
+/**
+ * @brief Calcula a ordem de leitura das colunas segundo a ordem alfabética da chave.
+ *
+ * Ordenação por contagem, O(k + 256): conta cada letra, acumula as posições iniciais e distribui os
+ * índices em ordem crescente. É estável, então letras repetidas mantêm a ordem original, o mesmo
+ * desempate do bubble sort de transpose_columns_by_key_order (a comparação é feita como char, com
+ * o mesmo sinal da comparação original).
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param order Vetor de saída: order[i] é o índice original da i-ésima coluna na ordem alfabética.
+ */
+void compute_column_order(const char key[], int key_length, int order[])
+{
+  int start[256] = {0};
+
+  for (int i = 0; i < key_length; i++)
+  {
+    start[key[i] - CHAR_MIN]++;
+  }
+
+  for (int c = 0, offset = 0; c < 256; c++)
+  {
+    int count = start[c];
+    start[c] = offset;
+    offset += count;
+  }
+
+  for (int i = 0; i < key_length; i++)
+  {
+    order[start[key[i] - CHAR_MIN]++] = i;
+  }
+}
+
+/**
+ * @brief Calcula a posição inicial de cada coluna no texto cifrado final.
+ *
+ * Com symbol_count símbolos distribuídos em key_length colunas, a coluna c recebe
+ * symbol_count / key_length símbolos, mais um se c < symbol_count % key_length.
+ *
+ * @param key_length Comprimento da chave.
+ * @param order Ordem das colunas (ver compute_column_order).
+ * @param symbol_count Quantidade total de símbolos ADFGVX.
+ * @param column_start Vetor de saída, indexado pela coluna original.
+ */
+void compute_column_offsets(int key_length, const int order[], size_t symbol_count, size_t column_start[])
+{
+  size_t rows = symbol_count / key_length;
+  size_t extra = symbol_count % key_length;
+  size_t offset = 0;
+
+  for (int i = 0; i < key_length; i++)
+  {
+    int col_index = order[i];
+    column_start[col_index] = offset;
+    offset += rows + ((size_t)col_index < extra ? 1 : 0);
+  }
+}
+
+/**
+ * @brief Conta os caracteres da mensagem que estão na matriz Polybius.
+ *
+ * @param message Mensagem de entrada (não precisa terminar em '\0').
+ * @param message_length Quantidade de bytes da mensagem.
+ * @return size_t Quantidade de caracteres válidos (cada um gera dois símbolos).
+ */
+size_t count_valid_characters(const char message[], size_t message_length)
+{
+  return polybius_count_valid(&polybius_default_square, message, message_length);
+}
+
+/**
+ * @brief Conta os caracteres da mensagem que estão em uma matriz Polybius qualquer.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param message Mensagem de entrada (não precisa terminar em '\0').
+ * @param message_length Quantidade de bytes da mensagem.
+ * @return size_t Quantidade de caracteres válidos (cada um gera dois símbolos).
+ */
+size_t polybius_count_valid(const polybius_square *polybius, const char message[], size_t message_length)
+{
+  const unsigned short *forward = polybius->forward;
+  size_t count = 0;
+
+  for (size_t i = 0; i < message_length; i++)
+  {
+    count += (forward[(unsigned char)message[i]] & POLYBIUS_VALID) != 0;
+  }
+  return count;
+}
+
+// Núcleo de scatter_symbols a partir de uma coluna qualquer (a coluna do primeiro símbolo do trecho)
+static void scatter_symbols_from(const polybius_square *polybius, int key_length, int col_index, const char message[], size_t message_length, size_t cursor[], char output[])
+{
+  const unsigned short *forward = polybius->forward;
+
+  for (size_t i = 0; i < message_length; i++)
+  {
+    unsigned short pair = forward[(unsigned char)message[i]];
+
+    // Ignora caracteres que não estão na matriz Polybius
+    if (!(pair & POLYBIUS_VALID))
+    {
+      continue;
+    }
+
+    output[cursor[col_index]++] = POLYBIUS_ROW(pair);
+    if (++col_index == key_length)
+      col_index = 0;
+
+    output[cursor[col_index]++] = POLYBIUS_COL(pair);
+    if (++col_index == key_length)
+      col_index = 0;
+  }
+}
+
+/**
+ * @brief Codifica a mensagem e grava cada símbolo no cursor da sua coluna.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key_length Comprimento da chave.
+ * @param message Mensagem de entrada.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param cursor Posição de escrita de cada coluna (ver compute_column_offsets), será avançada.
+ * @param output Buffer do texto cifrado.
+ */
+void scatter_symbols(const polybius_square *polybius, int key_length, const char message[], size_t message_length, size_t cursor[], char output[])
+{
+  scatter_symbols_from(polybius, key_length, 0, message, message_length, cursor, output);
+}
+
+/**
+ * @brief Aplica a cifra ADFGVX escrevendo cada símbolo direto na sua posição final.
+ *
+ * Primeiro conta os caracteres válidos, o que fixa o tamanho e a posição inicial de cada coluna.
+ * Depois codifica a mensagem e grava cada símbolo no cursor da sua coluna, sem matriz de colunas
+ * e sem trocas durante a ordenação. O resultado é idêntico ao de cipher_adfgvx linearizado.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param message Mensagem de entrada terminada em '\0'.
+ * @param output Buffer de saída com pelo menos 2 * strlen(message) + 1 posições.
+ * @return int Quantidade de símbolos escritos em output (terminado em '\0').
+ */
+int cipher_adfgvx_direct(const char key[], int key_length, const char message[], char output[])
+{
+  int order[key_length];
+  size_t cursor[key_length];
+  size_t message_length = strlen(message);
+  int symbol_count = 2 * count_valid_characters(message, message_length);
+
+  compute_column_order(key, key_length, order);
+  compute_column_offsets(key_length, order, symbol_count, cursor);
+  scatter_symbols(&polybius_default_square, key_length, message, message_length, cursor, output);
+
+  output[symbol_count] = '\0';
+  return symbol_count;
+}
+
+// Núcleo de gather_decode_symbols a partir de uma coluna qualquer (a coluna do primeiro símbolo do trecho)
+static size_t gather_decode_from(const polybius_square *polybius, int key_length, int col_index, const char ciphertext[], size_t symbol_count, size_t cursor[], char output[])
+{
+  const char(*reverse)[7] = polybius->reverse;
+  size_t length = 0;
+
+  for (size_t i = 0; i + 1 < symbol_count; i += 2)
+  {
+    unsigned char row = ciphertext[cursor[col_index]++];
+    if (++col_index == key_length)
+      col_index = 0;
+
+    unsigned char col = ciphertext[cursor[col_index]++];
+    if (++col_index == key_length)
+      col_index = 0;
+
+    // Sempre grava e só avança para pares válidos, como nos kernels de decodificação
+    char c = reverse[symbol_rank[row]][symbol_rank[col]];
+    output[length] = c;
+    length += c != '\0';
+  }
+  return length;
+}
+
+/**
+ * @brief Lê os símbolos do texto cifrado linha a linha e decodifica cada par em uma única passada.
+ *
+ * Operação inversa de scatter_symbols: o k-ésimo símbolo da sequência original está na coluna
+ * k % key_length, na posição indicada pelo cursor dessa coluna. Os pares são decodificados assim
+ * que lidos, sem matriz de colunas e sem buffer intermediário. Pares com algum símbolo inválido
+ * são descartados e um símbolo final sem par é ignorado.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key_length Comprimento da chave.
+ * @param ciphertext Texto cifrado (não precisa terminar em '\0').
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param cursor Posição inicial de cada coluna (ver compute_column_offsets), será avançada.
+ * @param output Buffer da mensagem com pelo menos symbol_count / 2 posições.
+ * @return size_t Quantidade de caracteres escritos em output.
+ */
+size_t gather_decode_symbols(const polybius_square *polybius, int key_length, const char ciphertext[], size_t symbol_count, size_t cursor[], char output[])
+{
+  return gather_decode_from(polybius, key_length, 0, ciphertext, symbol_count, cursor, output);
+}
+
+/**
+ * @brief Cifra um trecho da mensagem cujo primeiro símbolo tem índice global `first`.
+ *
+ * A posição final de cada símbolo depende só do seu índice global, da ordem da chave e do total de
+ * símbolos (column_start), então trechos diferentes podem ser cifrados de forma independente. Com
+ * chaves curtas cada símbolo é escrito direto no cursor da sua coluna; com BLOCKED_KEY_LENGTH colunas
+ * ou mais, o trecho é codificado em janelas pelo kernel e cada janela é gravada com gather_columns.
+ */
+static void encrypt_range(const polybius_square *polybius, int key_length, const size_t column_start[], size_t first, const char *message, size_t message_length, char *output)
+{
+  if (key_length < BLOCKED_KEY_LENGTH)
+  {
+    size_t cursor[key_length];
+
+    for (int c = 0; c < key_length; c++)
+    {
+      cursor[c] = column_start[c] + first / key_length + ((size_t)c < first % key_length);
+    }
+    scatter_symbols_from(polybius, key_length, (int)(first % key_length), message, message_length, cursor, output);
+    return;
+  }
+
+  // Chaves longas: codifica uma janela de símbolos por vez com o kernel e grava a janela em blocos
+  const polybius_kernel *kernel = polybius_select_kernel();
+  char window[BLOCKED_WINDOW_SYMBOLS];
+
+  for (size_t i = 0; i < message_length; i += BLOCKED_WINDOW_SYMBOLS / 2)
+  {
+    size_t chunk = message_length - i < BLOCKED_WINDOW_SYMBOLS / 2 ? message_length - i : BLOCKED_WINDOW_SYMBOLS / 2;
+    int count = kernel->encode(polybius, message + i, (int)chunk, window);
+
+    gather_columns(window, first, count, key_length, column_start, output);
+    first += count;
+  }
+}
+
+/**
+ * @brief Decifra os símbolos [first, first + count) da sequência original (first par) e devolve a
+ * quantidade de caracteres escritos em output.
+ *
+ * Operação inversa de encrypt_range: com chaves curtas os pares são lidos direto das colunas; com
+ * BLOCKED_KEY_LENGTH colunas ou mais, são reagrupados em janelas com scatter_columns (em blocos) e
+ * decodificados pelo kernel escolhido para a CPU.
+ */
+static size_t decrypt_range(const polybius_square *polybius, int key_length, const size_t column_start[], size_t first, size_t count, const char ciphertext[], char output[])
+{
+  if (key_length < BLOCKED_KEY_LENGTH)
+  {
+    size_t cursor[key_length];
+
+    for (int c = 0; c < key_length; c++)
+    {
+      cursor[c] = column_start[c] + first / key_length + ((size_t)c < first % key_length);
+    }
+    return gather_decode_from(polybius, key_length, (int)(first % key_length), ciphertext, count, cursor, output);
+  }
+
+  // Chaves longas: reagrupa uma janela de símbolos por vez com a transposição em blocos e decodifica com o kernel
+  const polybius_kernel *kernel = polybius_select_kernel();
+  char window[BLOCKED_WINDOW_SYMBOLS];
+  size_t end = first + count, length = 0;
+
+  for (; first + 1 < end; first += BLOCKED_WINDOW_SYMBOLS)
+  {
+    size_t window_count = end - first < BLOCKED_WINDOW_SYMBOLS ? (end - first) & ~(size_t)1 : BLOCKED_WINDOW_SYMBOLS;
+
+    scatter_columns(ciphertext, first, window_count, key_length, column_start, window);
+    length += kernel->decode(polybius, window, window_count / 2, output + length);
+  }
+  return length;
+}
+
+/**
+ * @brief Decifra um texto ADFGVX lendo cada símbolo direto da sua posição no texto cifrado.
+ *
+ * O tamanho do texto cifrado e a ordem da chave fixam a posição inicial de cada coluna; a partir
+ * delas os pares são reagrupados linha a linha e decodificados em uma única passada. Com chaves de
+ * BLOCKED_KEY_LENGTH colunas ou mais, cada linha tem poucos símbolos por coluna e a leitura coluna a
+ * coluna perde a cache; os símbolos são então reagrupados em janelas com scatter_columns (em blocos)
+ * e decodificados pelo kernel escolhido para a CPU.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param order Ordem das colunas (ver compute_column_order ou adfgvx_key_schedule).
+ * @param key_length Comprimento da chave.
+ * @param ciphertext Texto cifrado.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída com pelo menos symbol_count / 2 + 1 posições.
+ * @return size_t Quantidade de caracteres escritos em output (terminado em '\0').
+ */
+size_t decipher_adfgvx_ordered(const polybius_square *polybius, const int order[], int key_length, const char ciphertext[], size_t symbol_count, char output[])
+{
+  size_t column_start[key_length];
+
+  compute_column_offsets(key_length, order, symbol_count, column_start);
+
+  size_t length = decrypt_range(polybius, key_length, column_start, 0, symbol_count, ciphertext, output);
+  output[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief Decifra um texto ADFGVX calculando a ordem das colunas a partir da chave.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param ciphertext Texto cifrado.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída com pelo menos symbol_count / 2 + 1 posições.
+ * @return size_t Quantidade de caracteres escritos em output (terminado em '\0').
+ */
+size_t decipher_adfgvx_direct(const char key[], int key_length, const char ciphertext[], size_t symbol_count, char output[])
+{
+  int order[key_length];
+
+  compute_column_order(key, key_length, order);
+  return decipher_adfgvx_ordered(&polybius_default_square, order, key_length, ciphertext, symbol_count, output);
+}
+
+/**
+ * @brief Cifra uma mensagem inteira de tamanho arbitrário direto para o buffer de saída.
+ *
+ * O texto cifrado tem exatamente 2 símbolos por caractere válido, então a contagem fixa o tamanho da
+ * saída e a posição de cada coluna, e cada símbolo é escrito direto na sua posição final. Com chaves
+ * de BLOCKED_KEY_LENGTH colunas ou mais, a mensagem é codificada em janelas pelo kernel e cada janela
+ * é gravada com gather_columns (em blocos), em vez de um símbolo por coluna a cada linha.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param order Ordem das colunas (ver compute_column_order ou adfgvx_key_schedule).
+ * @param key_length Comprimento da chave.
+ * @param message Mensagem de entrada (por exemplo, um arquivo mapeado em memória).
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param symbol_count Quantidade de símbolos, obtida com 2 * count_valid_characters.
+ * @param output Buffer de saída com symbol_count posições (por exemplo, um arquivo mapeado).
+ */
+void cipher_adfgvx_ordered(const polybius_square *polybius, const int order[], int key_length, const char *message, size_t message_length, size_t symbol_count, char *output)
+{
+  size_t column_start[key_length];
+
+  compute_column_offsets(key_length, order, symbol_count, column_start);
+  encrypt_range(polybius, key_length, column_start, 0, message, message_length, output);
+}
+
+/**
+ * @brief Cifra uma mensagem inteira direto para o buffer de saída, calculando a ordem das colunas a partir da chave.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param message Mensagem de entrada.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param symbol_count Quantidade de símbolos, obtida com 2 * count_valid_characters.
+ * @param output Buffer de saída com symbol_count posições.
+ */
+void cipher_adfgvx_buffer(const char key[], int key_length, const char *message, size_t message_length, size_t symbol_count, char *output)
+{
+  int order[key_length];
+
+  compute_column_order(key, key_length, order);
+  cipher_adfgvx_ordered(&polybius_default_square, order, key_length, message, message_length, symbol_count, output);
+}
+
+/**
+ * @brief Codifica a mensagem em pares de símbolos no próprio buffer da mensagem.
+ *
+ * Primeiro os caracteres válidos são compactados no início do buffer (a escrita nunca passa da
+ * leitura); depois cada caractere j é expandido, de trás para frente, para as posições 2j e 2j+1,
+ * que ficam sempre à frente do que ainda falta ler. Nenhum buffer auxiliar é usado.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param buffer Mensagem na entrada e símbolos na saída; precisa de 2 * message_length posições.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @return size_t Quantidade de símbolos (2 por caractere válido).
+ */
+size_t polybius_encode_in_place(const polybius_square *polybius, char buffer[], size_t message_length)
+{
+  const unsigned short *forward = polybius->forward;
+  size_t count = 0;
+
+  for (size_t i = 0; i < message_length; i++)
+  {
+    buffer[count] = buffer[i];
+    count += (forward[(unsigned char)buffer[i]] & POLYBIUS_VALID) != 0;
+  }
+
+  for (size_t j = count; j-- > 0;)
+  {
+    unsigned short pair = forward[(unsigned char)buffer[j]];
+
+    buffer[2 * j] = POLYBIUS_ROW(pair);
+    buffer[2 * j + 1] = POLYBIUS_COL(pair);
+  }
+  return 2 * count;
+}
+
+/**
+ * @brief Aplica a transposição das colunas no próprio buffer de símbolos, seguindo os ciclos da permutação.
+ *
+ * O símbolo i da sequência linear vai para column_start[i % key_length] + i / key_length. Cada ciclo
+ * é percorrido uma única vez: o símbolo carregado desloca o que está na sua posição final, que passa
+ * a ser o carregado, até voltar ao início. Os símbolos ADFGVX são ASCII, então o bit 7 de cada um
+ * marca as posições já preenchidas; uma última passada apaga as marcas. Assim a memória extra é só
+ * column_start (O(key_length)) e cada símbolo é movido uma vez.
+ *
+ * @param symbols Símbolos em sequência linear na entrada, já transpostos na saída.
+ * @param symbol_count Quantidade de símbolos.
+ * @param key_length Comprimento da chave.
+ * @param column_start Posição inicial de cada coluna (ver compute_column_offsets).
+ */
+void transpose_symbols_in_place(char symbols[], size_t symbol_count, int key_length, const size_t column_start[])
+{
+  for (size_t start = 0; start < symbol_count; start++)
+  {
+    if (symbols[start] & IN_PLACE_MARK)
+      continue;
+
+    char carried = symbols[start];
+    size_t next = column_start[start % key_length] + start / key_length;
+
+    while (next != start)
+    {
+      char displaced = symbols[next];
+      symbols[next] = carried | IN_PLACE_MARK;
+      carried = displaced;
+      next = column_start[next % key_length] + next / key_length;
+    }
+    symbols[start] = carried | IN_PLACE_MARK;
+  }
+
+  for (size_t i = 0; i < symbol_count; i++)
+    symbols[i] &= ~IN_PLACE_MARK;
+}
+
+/**
+ * @brief Cifra uma mensagem no próprio buffer: codificação e transposição no lugar, sem matriz de
+ * colunas e sem um segundo buffer.
+ *
+ * Para alvos com pouca RAM: além do buffer (2 * message_length + 1 posições), só column_start
+ * (O(key_length)) é usado. Os acessos seguem os ciclos da permutação, fora de ordem, então é mais
+ * lenta que cipher_adfgvx_ordered, que escreve em um buffer separado.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param order Ordem das colunas (ver compute_column_order).
+ * @param key_length Comprimento da chave.
+ * @param buffer Mensagem na entrada e texto cifrado (terminado em '\0') na saída.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @return size_t Quantidade de símbolos do texto cifrado.
+ */
+size_t cipher_adfgvx_in_place(const polybius_square *polybius, const int order[], int key_length, char buffer[], size_t message_length)
+{
+  size_t column_start[key_length];
+  size_t symbol_count = polybius_encode_in_place(polybius, buffer, message_length);
+
+  compute_column_offsets(key_length, order, symbol_count, column_start);
+  transpose_symbols_in_place(buffer, symbol_count, key_length, column_start);
+  buffer[symbol_count] = '\0';
+  return symbol_count;
+}
+
+/**
+ * @brief Kernel escalar de codificação: converte a mensagem em pares de símbolos, em sequência linear.
+ *
+ * Sempre grava o par e avança o cursor apenas para caracteres válidos, evitando desvios no laço.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param message Mensagem de entrada.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param symbols_out Buffer com pelo menos 2 * message_length posições.
+ * @return int Quantidade de símbolos escritos (2 por caractere válido).
+ */
+int polybius_encode_scalar(const polybius_square *polybius, const char message[], int message_length, char symbols_out[])
+{
+  const unsigned short *forward = polybius->forward;
+  int count = 0;
+
+  for (int i = 0; i < message_length; i++)
+  {
+    unsigned short pair = forward[(unsigned char)message[i]];
+
+    symbols_out[count] = POLYBIUS_ROW(pair);
+    symbols_out[count + 1] = POLYBIUS_COL(pair);
+    count += (pair >> 14) & 2; // 2 se POLYBIUS_VALID estiver ligado, 0 caso contrário
+  }
+  return count;
+}
+
+/**
+ * @brief Kernel escalar de decodificação: converte pares de símbolos em caracteres.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param pairs Sequência de pares de símbolos ADFGVX.
+ * @param pair_count Quantidade de pares.
+ * @param message Buffer com pelo menos pair_count posições.
+ * @return int Quantidade de caracteres escritos (pares inválidos são descartados).
+ */
+int polybius_decode_scalar(const polybius_square *polybius, const char pairs[], int pair_count, char message[])
+{
+  const char(*reverse)[7] = polybius->reverse;
+  int count = 0;
+
+  for (int i = 0; i < pair_count; i++)
+  {
+    char c = reverse[symbol_rank[(unsigned char)pairs[2 * i]]][symbol_rank[(unsigned char)pairs[2 * i + 1]]];
+
+    message[count] = c;
+    count += c != '\0';
+  }
+  return count;
+}
+
+/**
+ * @brief Kernel escalar de compactação: cada par de símbolos consecutivos vira um byte 6 * a + b (0 a 35).
+ *
+ * Com quantidade ímpar de símbolos, o último byte guarda só o primeiro símbolo (b = 0); o cabeçalho
+ * do formato compactado informa a quantidade exata.
+ *
+ * @param symbols Símbolos ADFGVX.
+ * @param symbol_count Quantidade de símbolos.
+ * @param packed Buffer com pelo menos (symbol_count + 1) / 2 posições.
+ * @return int Quantidade de bytes escritos, ou -1 se houver algum símbolo fora de ADFGVX.
+ */
+int polybius_pack_scalar(const char symbols[], int symbol_count, unsigned char packed[])
+{
+  int invalid = 0, i = 0;
+
+  for (; i + 1 < symbol_count; i += 2)
+  {
+    // symbol_rank vai de 1 a 6 (0 para símbolos inválidos)
+    int a = symbol_rank[(unsigned char)symbols[i]], b = symbol_rank[(unsigned char)symbols[i + 1]];
+
+    invalid |= a == 0 || b == 0;
+    packed[i / 2] = (unsigned char)(6 * (a - 1) + b - 1);
+  }
+  if (i < symbol_count)
+  {
+    int a = symbol_rank[(unsigned char)symbols[i]];
+
+    invalid |= a == 0;
+    packed[i / 2] = (unsigned char)(6 * (a - 1));
+  }
+  return invalid ? -1 : (symbol_count + 1) / 2;
+}
+
+/**
+ * @brief Kernel escalar de descompactação: operação inversa de polybius_pack_scalar.
+ *
+ * O byte v volta a ser os símbolos de linha e de coluna da posição v da matriz padrão
+ * (default_row_symbols e default_col_symbols), que são exatamente v / 6 e v % 6.
+ *
+ * @param packed Bytes compactados.
+ * @param symbol_count Quantidade de símbolos a reconstruir.
+ * @param symbols Buffer com pelo menos symbol_count posições.
+ * @return int symbol_count, ou -1 se houver algum byte acima de 35.
+ */
+int polybius_unpack_scalar(const unsigned char packed[], int symbol_count, char symbols[])
+{
+  int i = 0;
+
+  for (; i + 1 < symbol_count; i += 2)
+  {
+    unsigned char v = packed[i / 2];
+
+    if (v >= POLYBIUS_CELLS)
+      return -1;
+    symbols[i] = default_row_symbols[v];
+    symbols[i + 1] = default_col_symbols[v];
+  }
+  if (i < symbol_count)
+  {
+    if (packed[i / 2] >= POLYBIUS_CELLS)
+      return -1;
+    symbols[i] = default_row_symbols[packed[i / 2]];
+  }
+  return symbol_count;
+}
+
+/**
+ * @brief Kernel escalar de decodificação de pares de índices (0 a 5): o caractere é cells[6 * linha + coluna].
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param pairs Sequência de pares de índices de símbolo.
+ * @param pair_count Quantidade de pares.
+ * @param message Buffer com pelo menos pair_count posições.
+ * @return int Quantidade de caracteres escritos (pares com índice acima de 5 são descartados).
+ */
+int polybius_decode_indices_scalar(const polybius_square *polybius, const char pairs[], int pair_count, char message[])
+{
+  const char *cells = polybius->cells;
+  int count = 0;
+
+  for (int i = 0; i < pair_count; i++)
+  {
+    unsigned char row = pairs[2 * i], col = pairs[2 * i + 1];
+    char c = row < 6 && col < 6 ? cells[6 * row + col] : '\0';
+
+    message[count] = c;
+    count += c != '\0';
+  }
+  return count;
+}
+
+#ifdef ADFGVX_X86_SIMD
+// compact_pairs[m]: máscara do pshufb que junta, em ordem, os pares (2 bytes) dos caracteres válidos
+// entre 8 caracteres, sendo m a máscara de validade desses 8 caracteres
+static unsigned char compact_pairs[256][16];
+
+/**
+ * @brief Preenche a tabela de compactação usada pelos kernels vetoriais.
+ */
+static void init_compact_pairs(void)
+{
+  for (int mask = 0; mask < 256; mask++)
+  {
+    int pos = 0;
+
+    for (int j = 0; j < 8; j++)
+    {
+      if (mask & (1 << j))
+      {
+        compact_pairs[mask][pos++] = 2 * j;
+        compact_pairs[mask][pos++] = 2 * j + 1;
+      }
+    }
+    while (pos < 16)
+    {
+      compact_pairs[mask][pos++] = 0x80;
+    }
+  }
+}
+
+/**
+ * @brief Grava os pares válidos de 8 caracteres (16 bytes intercalados linha/coluna) e avança a saída.
+ */
+__attribute__((target("sse4.1"))) static inline int store_compacted_pairs(char *out, __m128i pairs, int mask)
+{
+  __m128i shuffle = _mm_loadu_si128((const __m128i *)compact_pairs[mask]);
+
+  _mm_storeu_si128((__m128i *)out, _mm_shuffle_epi8(pairs, shuffle));
+  return 2 * __builtin_popcount(mask);
+}
+
+/**
+ * @brief Consulta uma tabela de 36 posições (carregada em três registradores de 16 bytes) com pshufb.
+ */
+__attribute__((target("sse4.1"))) static inline __m128i lookup36_sse41(__m128i t0, __m128i t16, __m128i t32, __m128i index)
+{
+  __m128i r = _mm_shuffle_epi8(t0, index);
+  r = _mm_blendv_epi8(r, _mm_shuffle_epi8(t16, _mm_sub_epi8(index, _mm_set1_epi8(16))), _mm_cmpgt_epi8(index, _mm_set1_epi8(15)));
+  return _mm_blendv_epi8(r, _mm_shuffle_epi8(t32, _mm_sub_epi8(index, _mm_set1_epi8(32))), _mm_cmpgt_epi8(index, _mm_set1_epi8(31)));
+}
+
+/**
+ * @brief Versão AVX2 de lookup36_sse41 (a tabela é repetida nas duas metades de 128 bits).
+ */
+__attribute__((target("avx2"))) static inline __m256i lookup36_avx2(__m256i t0, __m256i t16, __m256i t32, __m256i index)
+{
+  __m256i r = _mm256_shuffle_epi8(t0, index);
+  r = _mm256_blendv_epi8(r, _mm256_shuffle_epi8(t16, _mm256_sub_epi8(index, _mm256_set1_epi8(16))), _mm256_cmpgt_epi8(index, _mm256_set1_epi8(15)));
+  return _mm256_blendv_epi8(r, _mm256_shuffle_epi8(t32, _mm256_sub_epi8(index, _mm256_set1_epi8(32))), _mm256_cmpgt_epi8(index, _mm256_set1_epi8(31)));
+}
+
+/**
+ * @brief Kernel SSE4.1 de codificação: classifica e converte 16 caracteres por iteração.
+ *
+ * A posição do caractere na matriz padrão é calculada por comparações (letras, dígitos 1-7, espaço,
+ * vírgula e ponto) e os símbolos de linha e de coluna saem das tabelas row_symbols e col_symbols da
+ * matriz (36 posições, três pshufb cada), então a matriz padrão e qualquer matriz própria com os
+ * mesmos caracteres usam exatamente o mesmo código. Caracteres inválidos são removidos com a tabela
+ * de compactação. Matrizes com outros caracteres usam o kernel escalar, que consulta a tabela da matriz.
+ */
+__attribute__((target("sse4.1"))) int polybius_encode_sse41(const polybius_square *polybius, const char message[], int message_length, char symbols_out[])
+{
+  if (!polybius->default_alphabet)
+  {
+    return polybius_encode_scalar(polybius, message, message_length, symbols_out);
+  }
+
+  const __m128i rows_0 = _mm_loadu_si128((const __m128i *)polybius->row_symbols);
+  const __m128i rows_16 = _mm_loadu_si128((const __m128i *)(polybius->row_symbols + 16));
+  const __m128i rows_32 = _mm_loadu_si128((const __m128i *)(polybius->row_symbols + 32));
+  const __m128i cols_0 = _mm_loadu_si128((const __m128i *)polybius->col_symbols);
+  const __m128i cols_16 = _mm_loadu_si128((const __m128i *)(polybius->col_symbols + 16));
+  const __m128i cols_32 = _mm_loadu_si128((const __m128i *)(polybius->col_symbols + 32));
+  int count = 0, i = 0;
+
+  for (; i + 16 <= message_length; i += 16)
+  {
+    __m128i c = _mm_loadu_si128((const __m128i *)(message + i));
+
+    // Classificação (comparações com sinal: bytes >= 0x80 ficam fora de todos os intervalos)
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0')), _mm_cmplt_epi8(c, _mm_set1_epi8('8')));
+    __m128i space = _mm_cmpeq_epi8(c, _mm_set1_epi8(' '));
+    __m128i comma = _mm_cmpeq_epi8(c, _mm_set1_epi8(','));
+    __m128i dot = _mm_cmpeq_epi8(c, _mm_set1_epi8('.'));
+    __m128i valid = _mm_or_si128(_mm_or_si128(letter, digit), _mm_or_si128(space, _mm_or_si128(comma, dot)));
+
+    // Posição na matriz padrão (0 a 35): A-Z -> 0-25, ' ' -> 26, ',' -> 27, '.' -> 28, '1'-'7' -> 29-35
+    __m128i cell = _mm_or_si128(_mm_and_si128(letter, _mm_sub_epi8(c, _mm_set1_epi8('A'))),
+                                _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('1' - 29))));
+    cell = _mm_or_si128(cell, _mm_and_si128(space, _mm_set1_epi8(26)));
+    cell = _mm_or_si128(cell, _mm_and_si128(comma, _mm_set1_epi8(27)));
+    cell = _mm_or_si128(cell, _mm_and_si128(dot, _mm_set1_epi8(28)));
+
+    // Símbolos de linha e de coluna do caractere na matriz usada (padrão ou própria)
+    __m128i row_symbols = lookup36_sse41(rows_0, rows_16, rows_32, cell);
+    __m128i col_symbols = lookup36_sse41(cols_0, cols_16, cols_32, cell);
+    __m128i pairs_lo = _mm_unpacklo_epi8(row_symbols, col_symbols); // caracteres 0-7
+    __m128i pairs_hi = _mm_unpackhi_epi8(row_symbols, col_symbols); // caracteres 8-15
+    int mask = _mm_movemask_epi8(valid);
+
+    if (mask == 0xFFFF)
+    {
+      _mm_storeu_si128((__m128i *)(symbols_out + count), pairs_lo);
+      _mm_storeu_si128((__m128i *)(symbols_out + count + 16), pairs_hi);
+      count += 32;
+      continue;
+    }
+
+    count += store_compacted_pairs(symbols_out + count, pairs_lo, mask & 0xFF);
+    count += store_compacted_pairs(symbols_out + count, pairs_hi, mask >> 8);
+  }
+
+  return count + polybius_encode_scalar(polybius, message + i, message_length - i, symbols_out + count);
+}
+
+/**
+ * @brief Kernel AVX2 de codificação: mesma lógica do kernel SSE4.1, com 32 caracteres por iteração.
+ */
+__attribute__((target("avx2"))) int polybius_encode_avx2(const polybius_square *polybius, const char message[], int message_length, char symbols_out[])
+{
+  if (!polybius->default_alphabet)
+  {
+    return polybius_encode_scalar(polybius, message, message_length, symbols_out);
+  }
+
+  const __m256i rows_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)polybius->row_symbols));
+  const __m256i rows_16 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->row_symbols + 16)));
+  const __m256i rows_32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->row_symbols + 32)));
+  const __m256i cols_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)polybius->col_symbols));
+  const __m256i cols_16 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->col_symbols + 16)));
+  const __m256i cols_32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->col_symbols + 32)));
+  int count = 0, i = 0;
+
+  for (; i + 32 <= message_length; i += 32)
+  {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(message + i));
+
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), c));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0')), _mm256_cmpgt_epi8(_mm256_set1_epi8('8'), c));
+    __m256i space = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' '));
+    __m256i comma = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(','));
+    __m256i dot = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'));
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(letter, digit), _mm256_or_si256(space, _mm256_or_si256(comma, dot)));
+
+    __m256i cell = _mm256_or_si256(_mm256_and_si256(letter, _mm256_sub_epi8(c, _mm256_set1_epi8('A'))),
+                                   _mm256_and_si256(digit, _mm256_sub_epi8(c, _mm256_set1_epi8('1' - 29))));
+    cell = _mm256_or_si256(cell, _mm256_and_si256(space, _mm256_set1_epi8(26)));
+    cell = _mm256_or_si256(cell, _mm256_and_si256(comma, _mm256_set1_epi8(27)));
+    cell = _mm256_or_si256(cell, _mm256_and_si256(dot, _mm256_set1_epi8(28)));
+
+    __m256i row_symbols = lookup36_avx2(rows_0, rows_16, rows_32, cell);
+    __m256i col_symbols = lookup36_avx2(cols_0, cols_16, cols_32, cell);
+    __m256i pairs_lo = _mm256_unpacklo_epi8(row_symbols, col_symbols); // caracteres 0-7 e 16-23
+    __m256i pairs_hi = _mm256_unpackhi_epi8(row_symbols, col_symbols); // caracteres 8-15 e 24-31
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(valid);
+
+    if (mask == 0xFFFFFFFFu)
+    {
+      _mm256_storeu_si256((__m256i *)(symbols_out + count), _mm256_permute2x128_si256(pairs_lo, pairs_hi, 0x20));
+      _mm256_storeu_si256((__m256i *)(symbols_out + count + 32), _mm256_permute2x128_si256(pairs_lo, pairs_hi, 0x31));
+      count += 64;
+      continue;
+    }
+
+    count += store_compacted_pairs(symbols_out + count, _mm256_castsi256_si128(pairs_lo), mask & 0xFF);
+    count += store_compacted_pairs(symbols_out + count, _mm256_castsi256_si128(pairs_hi), (mask >> 8) & 0xFF);
+    count += store_compacted_pairs(symbols_out + count, _mm256_extracti128_si256(pairs_lo, 1), (mask >> 16) & 0xFF);
+    count += store_compacted_pairs(symbols_out + count, _mm256_extracti128_si256(pairs_hi, 1), mask >> 24);
+  }
+
+  return count + polybius_encode_scalar(polybius, message + i, message_length - i, symbols_out + count);
+}
+
+/**
+ * @brief Kernel SSE4.1 de decodificação: converte 16 pares por iteração.
+ *
+ * Separa símbolos de linha e de coluna com pshufb, obtém o índice de cada símbolo por comparação
+ * e consulta a matriz (36 posições, padrão ou própria) com três pshufb de 16 entradas. Blocos com
+ * algum símbolo inválido são tratados pelo kernel escalar, que descarta os pares inválidos.
+ */
+__attribute__((target("sse4.1"))) int polybius_decode_sse41(const polybius_square *polybius, const char pairs[], int pair_count, char message[])
+{
+  const __m128i deinterleave = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  const __m128i cells_0 = _mm_loadu_si128((const __m128i *)polybius->cells);
+  const __m128i cells_16 = _mm_loadu_si128((const __m128i *)(polybius->cells + 16));
+  const __m128i cells_32 = _mm_loadu_si128((const __m128i *)(polybius->cells + 32));
+  int count = 0, i = 0;
+
+  for (; i + 16 <= pair_count; i += 16)
+  {
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pairs + 2 * i)), deinterleave);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pairs + 2 * i + 16)), deinterleave);
+    __m128i rows = _mm_unpacklo_epi64(a, b);
+    __m128i cols = _mm_unpackhi_epi64(a, b);
+    __m128i index[2], valid = _mm_set1_epi8(-1);
+
+    for (int k = 0; k < 2; k++)
+    {
+      __m128i s = k == 0 ? rows : cols;
+      __m128i is_a = _mm_cmpeq_epi8(s, _mm_set1_epi8('A'));
+      __m128i is_d = _mm_cmpeq_epi8(s, _mm_set1_epi8('D'));
+      __m128i is_f = _mm_cmpeq_epi8(s, _mm_set1_epi8('F'));
+      __m128i is_g = _mm_cmpeq_epi8(s, _mm_set1_epi8('G'));
+      __m128i is_v = _mm_cmpeq_epi8(s, _mm_set1_epi8('V'));
+      __m128i is_x = _mm_cmpeq_epi8(s, _mm_set1_epi8('X'));
+
+      index[k] = _mm_or_si128(_mm_or_si128(_mm_and_si128(is_d, _mm_set1_epi8(1)), _mm_and_si128(is_f, _mm_set1_epi8(2))),
+                              _mm_or_si128(_mm_or_si128(_mm_and_si128(is_g, _mm_set1_epi8(3)), _mm_and_si128(is_v, _mm_set1_epi8(4))),
+                                           _mm_and_si128(is_x, _mm_set1_epi8(5))));
+      valid = _mm_and_si128(valid, _mm_or_si128(_mm_or_si128(_mm_or_si128(is_a, is_d), _mm_or_si128(is_f, is_g)), _mm_or_si128(is_v, is_x)));
+    }
+
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+    {
+      count += polybius_decode_scalar(polybius, pairs + 2 * i, 16, message + count);
+      continue;
+    }
+
+    __m128i row3 = _mm_add_epi8(_mm_add_epi8(index[0], index[0]), index[0]);
+    __m128i cell = _mm_add_epi8(_mm_add_epi8(row3, row3), index[1]);
+    __m128i chars = lookup36_sse41(cells_0, cells_16, cells_32, cell);
+
+    _mm_storeu_si128((__m128i *)(message + count), chars);
+    count += 16;
+  }
+
+  return count + polybius_decode_scalar(polybius, pairs + 2 * i, pair_count - i, message + count);
+}
+
+/**
+ * @brief Kernel AVX2 de decodificação: mesma lógica do kernel SSE4.1, com 32 pares por iteração.
+ */
+__attribute__((target("avx2"))) int polybius_decode_avx2(const polybius_square *polybius, const char pairs[], int pair_count, char message[])
+{
+  const __m256i deinterleave = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                                0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  const __m256i cells_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)polybius->cells));
+  const __m256i cells_16 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->cells + 16)));
+  const __m256i cells_32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->cells + 32)));
+  int count = 0, i = 0;
+
+  for (; i + 32 <= pair_count; i += 32)
+  {
+    // Cada registrador fica com [linhas | colunas] de 16 pares após o pshufb e o permute
+    __m256i a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(pairs + 2 * i)), deinterleave), 0xD8);
+    __m256i b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(pairs + 2 * i + 32)), deinterleave), 0xD8);
+    __m256i rows = _mm256_permute2x128_si256(a, b, 0x20);
+    __m256i cols = _mm256_permute2x128_si256(a, b, 0x31);
+    __m256i index[2], valid = _mm256_set1_epi8(-1);
+
+    for (int k = 0; k < 2; k++)
+    {
+      __m256i s = k == 0 ? rows : cols;
+      __m256i is_a = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('A'));
+      __m256i is_d = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('D'));
+      __m256i is_f = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('F'));
+      __m256i is_g = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('G'));
+      __m256i is_v = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('V'));
+      __m256i is_x = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('X'));
+
+      index[k] = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(is_d, _mm256_set1_epi8(1)), _mm256_and_si256(is_f, _mm256_set1_epi8(2))),
+                                 _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(is_g, _mm256_set1_epi8(3)), _mm256_and_si256(is_v, _mm256_set1_epi8(4))),
+                                                 _mm256_and_si256(is_x, _mm256_set1_epi8(5))));
+      valid = _mm256_and_si256(valid, _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(is_a, is_d), _mm256_or_si256(is_f, is_g)), _mm256_or_si256(is_v, is_x)));
+    }
+
+    if ((unsigned int)_mm256_movemask_epi8(valid) != 0xFFFFFFFFu)
+    {
+      count += polybius_decode_scalar(polybius, pairs + 2 * i, 32, message + count);
+      continue;
+    }
+
+    __m256i row3 = _mm256_add_epi8(_mm256_add_epi8(index[0], index[0]), index[0]);
+    __m256i cell = _mm256_add_epi8(_mm256_add_epi8(row3, row3), index[1]);
+    __m256i chars = lookup36_avx2(cells_0, cells_16, cells_32, cell);
+
+    _mm256_storeu_si256((__m256i *)(message + count), chars);
+    count += 32;
+  }
+
+  return count + polybius_decode_scalar(polybius, pairs + 2 * i, pair_count - i, message + count);
+}
+
+/**
+ * @brief Índice (0 a 5) de 16 símbolos ADFGVX por comparação; zera em `valid` as posições inválidas.
+ */
+__attribute__((target("sse4.1"))) static inline __m128i symbol_index_sse41(__m128i s, __m128i *valid)
+{
+  __m128i is_a = _mm_cmpeq_epi8(s, _mm_set1_epi8('A'));
+  __m128i is_d = _mm_cmpeq_epi8(s, _mm_set1_epi8('D'));
+  __m128i is_f = _mm_cmpeq_epi8(s, _mm_set1_epi8('F'));
+  __m128i is_g = _mm_cmpeq_epi8(s, _mm_set1_epi8('G'));
+  __m128i is_v = _mm_cmpeq_epi8(s, _mm_set1_epi8('V'));
+  __m128i is_x = _mm_cmpeq_epi8(s, _mm_set1_epi8('X'));
+
+  *valid = _mm_and_si128(*valid, _mm_or_si128(_mm_or_si128(_mm_or_si128(is_a, is_d), _mm_or_si128(is_f, is_g)), _mm_or_si128(is_v, is_x)));
+  return _mm_or_si128(_mm_or_si128(_mm_and_si128(is_d, _mm_set1_epi8(1)), _mm_and_si128(is_f, _mm_set1_epi8(2))),
+                      _mm_or_si128(_mm_or_si128(_mm_and_si128(is_g, _mm_set1_epi8(3)), _mm_and_si128(is_v, _mm_set1_epi8(4))),
+                                   _mm_and_si128(is_x, _mm_set1_epi8(5))));
+}
+
+/**
+ * @brief Versão AVX2 de symbol_index_sse41, com 32 símbolos.
+ */
+__attribute__((target("avx2"))) static inline __m256i symbol_index_avx2(__m256i s, __m256i *valid)
+{
+  __m256i is_a = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('A'));
+  __m256i is_d = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('D'));
+  __m256i is_f = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('F'));
+  __m256i is_g = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('G'));
+  __m256i is_v = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('V'));
+  __m256i is_x = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('X'));
+
+  *valid = _mm256_and_si256(*valid, _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(is_a, is_d), _mm256_or_si256(is_f, is_g)), _mm256_or_si256(is_v, is_x)));
+  return _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(is_d, _mm256_set1_epi8(1)), _mm256_and_si256(is_f, _mm256_set1_epi8(2))),
+                         _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(is_g, _mm256_set1_epi8(3)), _mm256_and_si256(is_v, _mm256_set1_epi8(4))),
+                                         _mm256_and_si256(is_x, _mm256_set1_epi8(5))));
+}
+
+/**
+ * @brief Kernel SSE4.1 de compactação: 32 símbolos (16 bytes) por iteração.
+ *
+ * Converte os símbolos em índices por comparação e junta cada par com pmaddubsw (pesos 6 e 1) e
+ * packuswb.
+ */
+__attribute__((target("sse4.1"))) int polybius_pack_sse41(const char symbols[], int symbol_count, unsigned char packed[])
+{
+  const __m128i weights = _mm_set1_epi16(0x0106);
+  int i = 0;
+
+  for (; i + 32 <= symbol_count; i += 32)
+  {
+    __m128i valid = _mm_set1_epi8(-1);
+    __m128i a = symbol_index_sse41(_mm_loadu_si128((const __m128i *)(symbols + i)), &valid);
+    __m128i b = symbol_index_sse41(_mm_loadu_si128((const __m128i *)(symbols + i + 16)), &valid);
+
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+      return -1;
+    _mm_storeu_si128((__m128i *)(packed + i / 2), _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights)));
+  }
+
+  int tail = polybius_pack_scalar(symbols + i, symbol_count - i, packed + i / 2);
+  return tail < 0 ? -1 : i / 2 + tail;
+}
+
+/**
+ * @brief Kernel AVX2 de compactação: mesma lógica do kernel SSE4.1, com 64 símbolos por iteração.
+ */
+__attribute__((target("avx2"))) int polybius_pack_avx2(const char symbols[], int symbol_count, unsigned char packed[])
+{
+  const __m256i weights = _mm256_set1_epi16(0x0106);
+  int i = 0;
+
+  for (; i + 64 <= symbol_count; i += 64)
+  {
+    __m256i valid = _mm256_set1_epi8(-1);
+    __m256i a = symbol_index_avx2(_mm256_loadu_si256((const __m256i *)(symbols + i)), &valid);
+    __m256i b = symbol_index_avx2(_mm256_loadu_si256((const __m256i *)(symbols + i + 32)), &valid);
+
+    if ((unsigned int)_mm256_movemask_epi8(valid) != 0xFFFFFFFFu)
+      return -1;
+
+    // packus junta por metade de 128 bits; o permute devolve os bytes à ordem original
+    __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+    _mm256_storeu_si256((__m256i *)(packed + i / 2), _mm256_permute4x64_epi64(bytes, 0xD8));
+  }
+
+  int tail = polybius_pack_scalar(symbols + i, symbol_count - i, packed + i / 2);
+  return tail < 0 ? -1 : i / 2 + tail;
+}
+
+/**
+ * @brief Kernel SSE4.1 de descompactação: 16 bytes (32 símbolos) por iteração.
+ *
+ * Os símbolos de linha e de coluna de cada byte saem das tabelas default_row_symbols e
+ * default_col_symbols (36 posições, três pshufb cada) e são intercalados.
+ */
+__attribute__((target("sse4.1"))) int polybius_unpack_sse41(const unsigned char packed[], int symbol_count, char symbols[])
+{
+  const __m128i rows_0 = _mm_loadu_si128((const __m128i *)default_row_symbols);
+  const __m128i rows_16 = _mm_loadu_si128((const __m128i *)(default_row_symbols + 16));
+  const __m128i rows_32 = _mm_loadu_si128((const __m128i *)(default_row_symbols + 32));
+  const __m128i cols_0 = _mm_loadu_si128((const __m128i *)default_col_symbols);
+  const __m128i cols_16 = _mm_loadu_si128((const __m128i *)(default_col_symbols + 16));
+  const __m128i cols_32 = _mm_loadu_si128((const __m128i *)(default_col_symbols + 32));
+  int i = 0;
+
+  for (; i + 32 <= symbol_count; i += 32)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(packed + i / 2));
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(POLYBIUS_CELLS - 1)), v)) != 0xFFFF)
+      return -1;
+
+    __m128i rows = lookup36_sse41(rows_0, rows_16, rows_32, v);
+    __m128i cols = lookup36_sse41(cols_0, cols_16, cols_32, v);
+    _mm_storeu_si128((__m128i *)(symbols + i), _mm_unpacklo_epi8(rows, cols));
+    _mm_storeu_si128((__m128i *)(symbols + i + 16), _mm_unpackhi_epi8(rows, cols));
+  }
+
+  return polybius_unpack_scalar(packed + i / 2, symbol_count - i, symbols + i) < 0 ? -1 : symbol_count;
+}
+
+/**
+ * @brief Kernel AVX2 de descompactação: mesma lógica do kernel SSE4.1, com 32 bytes por iteração.
+ */
+__attribute__((target("avx2"))) int polybius_unpack_avx2(const unsigned char packed[], int symbol_count, char symbols[])
+{
+  const __m256i rows_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)default_row_symbols));
+  const __m256i rows_16 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(default_row_symbols + 16)));
+  const __m256i rows_32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(default_row_symbols + 32)));
+  const __m256i cols_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)default_col_symbols));
+  const __m256i cols_16 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(default_col_symbols + 16)));
+  const __m256i cols_32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(default_col_symbols + 32)));
+  int i = 0;
+
+  for (; i + 64 <= symbol_count; i += 64)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(packed + i / 2));
+
+    if ((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(POLYBIUS_CELLS - 1)), v)) != 0xFFFFFFFFu)
+      return -1;
+
+    __m256i rows = lookup36_avx2(rows_0, rows_16, rows_32, v);
+    __m256i cols = lookup36_avx2(cols_0, cols_16, cols_32, v);
+    __m256i low = _mm256_unpacklo_epi8(rows, cols), high = _mm256_unpackhi_epi8(rows, cols);
+
+    // unpack intercala por metade de 128 bits; o permute devolve os símbolos à ordem original
+    _mm256_storeu_si256((__m256i *)(symbols + i), _mm256_permute2x128_si256(low, high, 0x20));
+    _mm256_storeu_si256((__m256i *)(symbols + i + 32), _mm256_permute2x128_si256(low, high, 0x31));
+  }
+
+  return polybius_unpack_scalar(packed + i / 2, symbol_count - i, symbols + i) < 0 ? -1 : symbol_count;
+}
+
+/**
+ * @brief Kernel SSE4.1 de decodificação de pares de índices: 16 pares por iteração.
+ *
+ * Sem a comparação com as seis letras dos kernels de decodificação: a posição na matriz é 6 * linha +
+ * coluna direto dos índices, consultada com três pshufb. Blocos com algum índice acima de 5 são
+ * tratados pelo kernel escalar.
+ */
+__attribute__((target("sse4.1"))) int polybius_decode_indices_sse41(const polybius_square *polybius, const char pairs[], int pair_count, char message[])
+{
+  const __m128i deinterleave = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  const __m128i cells_0 = _mm_loadu_si128((const __m128i *)polybius->cells);
+  const __m128i cells_16 = _mm_loadu_si128((const __m128i *)(polybius->cells + 16));
+  const __m128i cells_32 = _mm_loadu_si128((const __m128i *)(polybius->cells + 32));
+  const __m128i five = _mm_set1_epi8(5);
+  int count = 0, i = 0;
+
+  for (; i + 16 <= pair_count; i += 16)
+  {
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pairs + 2 * i)), deinterleave);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pairs + 2 * i + 16)), deinterleave);
+    __m128i rows = _mm_unpacklo_epi64(a, b);
+    __m128i cols = _mm_unpackhi_epi64(a, b);
+    __m128i valid = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(rows, five), rows), _mm_cmpeq_epi8(_mm_min_epu8(cols, five), cols));
+
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+    {
+      count += polybius_decode_indices_scalar(polybius, pairs + 2 * i, 16, message + count);
+      continue;
+    }
+
+    __m128i row3 = _mm_add_epi8(_mm_add_epi8(rows, rows), rows);
+    __m128i cell = _mm_add_epi8(_mm_add_epi8(row3, row3), cols);
+    _mm_storeu_si128((__m128i *)(message + count), lookup36_sse41(cells_0, cells_16, cells_32, cell));
+    count += 16;
+  }
+
+  return count + polybius_decode_indices_scalar(polybius, pairs + 2 * i, pair_count - i, message + count);
+}
+
+/**
+ * @brief Versão AVX2 de polybius_decode_indices_sse41, com 32 pares por iteração.
+ */
+__attribute__((target("avx2"))) int polybius_decode_indices_avx2(const polybius_square *polybius, const char pairs[], int pair_count, char message[])
+{
+  const __m256i deinterleave = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                                0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  const __m256i cells_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)polybius->cells));
+  const __m256i cells_16 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->cells + 16)));
+  const __m256i cells_32 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(polybius->cells + 32)));
+  const __m256i five = _mm256_set1_epi8(5);
+  int count = 0, i = 0;
+
+  for (; i + 32 <= pair_count; i += 32)
+  {
+    __m256i a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(pairs + 2 * i)), deinterleave), 0xD8);
+    __m256i b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(pairs + 2 * i + 32)), deinterleave), 0xD8);
+    __m256i rows = _mm256_permute2x128_si256(a, b, 0x20);
+    __m256i cols = _mm256_permute2x128_si256(a, b, 0x31);
+    __m256i valid = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(rows, five), rows), _mm256_cmpeq_epi8(_mm256_min_epu8(cols, five), cols));
+
+    if ((unsigned int)_mm256_movemask_epi8(valid) != 0xFFFFFFFFu)
+    {
+      count += polybius_decode_indices_scalar(polybius, pairs + 2 * i, 32, message + count);
+      continue;
+    }
+
+    __m256i row3 = _mm256_add_epi8(_mm256_add_epi8(rows, rows), rows);
+    __m256i cell = _mm256_add_epi8(_mm256_add_epi8(row3, row3), cols);
+    _mm256_storeu_si256((__m256i *)(message + count), lookup36_avx2(cells_0, cells_16, cells_32, cell));
+    count += 32;
+  }
+
+  return count + polybius_decode_indices_scalar(polybius, pairs + 2 * i, pair_count - i, message + count);
+}
+#endif
+
+// Kernels disponíveis, do mais simples ao mais rápido; o escalar funciona em qualquer plataforma
+const polybius_kernel polybius_kernels[] = {
+    {"scalar", polybius_encode_scalar, polybius_decode_scalar, polybius_pack_scalar, polybius_unpack_scalar, polybius_decode_indices_scalar},
+#ifdef ADFGVX_X86_SIMD
+    {"sse4.1", polybius_encode_sse41, polybius_decode_sse41, polybius_pack_sse41, polybius_unpack_sse41, polybius_decode_indices_sse41},
+    {"avx2", polybius_encode_avx2, polybius_decode_avx2, polybius_pack_avx2, polybius_unpack_avx2, polybius_decode_indices_avx2},
+#endif
+};
+const int polybius_kernel_count = sizeof(polybius_kernels) / sizeof(polybius_kernels[0]);
+
+// Inicialização única (pthread_once): tabela do pshufb dos kernels vetoriais e kernel escolhido para a CPU
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+static const polybius_kernel *selected_kernel = NULL;
+
+// Consulta a CPU sem passar pela inicialização (usada por ela)
+static int kernel_cpu_supported(const polybius_kernel *kernel)
+{
+#ifdef ADFGVX_X86_SIMD
+  if (strcmp(kernel->name, "sse4.1") == 0)
+    return __builtin_cpu_supports("sse4.1");
+  if (strcmp(kernel->name, "avx2") == 0)
+    return __builtin_cpu_supports("avx2");
+#endif
+  return strcmp(kernel->name, "scalar") == 0;
+}
+
+// Executada uma única vez; pthread_once publica compact_pairs e selected_kernel para todas as threads
+static void init_kernels(void)
+{
+#ifdef ADFGVX_X86_SIMD
+  init_compact_pairs();
+#endif
+  for (int i = polybius_kernel_count - 1; i >= 0 && selected_kernel == NULL; i--)
+  {
+    if (kernel_cpu_supported(&polybius_kernels[i]))
+      selected_kernel = &polybius_kernels[i];
+  }
+}
+
+/**
+ * @brief Verifica se a CPU atual suporta o conjunto de instruções de um kernel.
+ *
+ * Pode ser chamada de várias threads: a primeira chamada (desta função ou de polybius_select_kernel)
+ * inicializa as tabelas dos kernels com pthread_once.
+ *
+ * @param kernel Kernel de polybius_kernels.
+ * @return int 1 se o kernel pode ser usado, 0 caso contrário.
+ */
+int polybius_kernel_supported(const polybius_kernel *kernel)
+{
+  pthread_once(&kernel_once, init_kernels);
+  return kernel_cpu_supported(kernel);
+}
+
+/**
+ * @brief Escolhe, em tempo de execução, o kernel mais rápido suportado pela CPU.
+ *
+ * A escolha é feita uma única vez (pthread_once) e é segura com várias threads.
+ *
+ * @return const polybius_kernel* Kernel escolhido (nunca NULL: o escalar é sempre suportado).
+ */
+const polybius_kernel *polybius_select_kernel(void)
+{
+  pthread_once(&kernel_once, init_kernels);
+  return selected_kernel;
+}
+
+/**
+ * @brief Lineariza os símbolos (em ordem de escrita) lendo as colunas na ordem alfabética da chave.
+ *
+ * O símbolo de índice global s vai para a coluna s % key_length, linha s / key_length. A cópia é
+ * feita em blocos de TRANSPOSE_TILE_ROWS linhas por TRANSPOSE_TILE_COLUMNS colunas: as linhas de um
+ * bloco ficam na cache enquanto cada coluna recebe um trecho contíguo, mesmo com milhares de colunas.
+ *
+ * @param symbols Janela de símbolos na ordem em que foram gerados pela codificação.
+ * @param first Índice global do primeiro símbolo da janela (0 para a mensagem inteira).
+ * @param count Quantidade de símbolos da janela.
+ * @param key_length Comprimento da chave.
+ * @param column_start Posição inicial de cada coluna no texto cifrado (ver compute_column_offsets).
+ * @param output Buffer do texto cifrado.
+ */
+void gather_columns(const char symbols[], size_t first, size_t count, int key_length, const size_t column_start[], char output[])
+{
+  size_t end = first + count;
+  size_t row_end = (end + key_length - 1) / key_length;
+
+  for (size_t r0 = first / key_length; r0 < row_end; r0 += TRANSPOSE_TILE_ROWS)
+  {
+    size_t r1 = r0 + TRANSPOSE_TILE_ROWS < row_end ? r0 + TRANSPOSE_TILE_ROWS : row_end;
+
+    for (int c0 = 0; c0 < key_length; c0 += TRANSPOSE_TILE_COLUMNS)
+    {
+      int c1 = c0 + TRANSPOSE_TILE_COLUMNS < key_length ? c0 + TRANSPOSE_TILE_COLUMNS : key_length;
+
+      for (int c = c0; c < c1; c++)
+      {
+        // Só a primeira e a última linha da janela podem estar incompletas
+        size_t r = r0 * key_length + c < first ? r0 + 1 : r0;
+        size_t stop = r1 > r && (r1 - 1) * key_length + c >= end ? r1 - 1 : r1;
+        const char *src = symbols + (r * key_length + c - first);
+        char *dst = output + column_start[c] + r;
+
+        for (; r < stop; r++, src += key_length)
+        {
+          *dst++ = *src;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Operação inversa de gather_columns: reconstrói a sequência de símbolos a partir das colunas.
+ *
+ * @param ciphertext Texto cifrado.
+ * @param first Índice global do primeiro símbolo da janela.
+ * @param count Quantidade de símbolos da janela.
+ * @param key_length Comprimento da chave.
+ * @param column_start Posição inicial de cada coluna no texto cifrado (ver compute_column_offsets).
+ * @param symbols Janela de saída, com os símbolos na ordem original.
+ */
+void scatter_columns(const char ciphertext[], size_t first, size_t count, int key_length, const size_t column_start[], char symbols[])
+{
+  size_t end = first + count;
+  size_t row_end = (end + key_length - 1) / key_length;
+
+  for (size_t r0 = first / key_length; r0 < row_end; r0 += TRANSPOSE_TILE_ROWS)
+  {
+    size_t r1 = r0 + TRANSPOSE_TILE_ROWS < row_end ? r0 + TRANSPOSE_TILE_ROWS : row_end;
+
+    for (int c0 = 0; c0 < key_length; c0 += TRANSPOSE_TILE_COLUMNS)
+    {
+      int c1 = c0 + TRANSPOSE_TILE_COLUMNS < key_length ? c0 + TRANSPOSE_TILE_COLUMNS : key_length;
+
+      // Linha a linha dentro do bloco: a janela é escrita em trechos contíguos
+      for (size_t r = r0; r < r1; r++)
+      {
+        size_t base = r * key_length;
+        int from = base + c0 < first ? (int)(first - base) : c0;
+        int to = base + c1 > end ? (int)(end - base) : c1;
+
+        for (int c = from; c < to; c++)
+        {
+          symbols[base + c - first] = ciphertext[column_start[c] + r];
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Deriva uma matriz Polybius de uma palavra-chave.
+ *
+ * Os caracteres da palavra-chave que estão na matriz padrão entram primeiro, sem repetição, seguidos
+ * dos demais caracteres da matriz padrão na ordem original. O resultado tem sempre os mesmos 36
+ * caracteres da matriz padrão, então os kernels vetoriais de codificação continuam valendo.
+ *
+ * @param keyword Palavra-chave (caracteres fora da matriz padrão são ignorados).
+ * @param keyword_length Comprimento da palavra-chave.
+ * @param cells Matriz de saída, linha a linha.
+ */
+void polybius_square_from_keyword(const char keyword[], int keyword_length, char cells[POLYBIUS_CELLS])
+{
+  unsigned char used[256] = {0};
+  int count = 0;
+
+  for (int i = 0; i < keyword_length; i++)
+  {
+    unsigned char c = keyword[i];
+
+    if ((polybius_forward[c] & POLYBIUS_VALID) && !used[c])
+    {
+      used[c] = 1;
+      cells[count++] = c;
+    }
+  }
+
+  for (int i = 0; i < POLYBIUS_CELLS; i++)
+  {
+    unsigned char c = default_cells[i];
+
+    if (!used[c])
+    {
+      cells[count++] = c;
+    }
+  }
+}
+
+/**
+ * @brief Compila uma matriz Polybius própria nas tabelas de consulta usadas pelos kernels.
+ *
+ * Gera as tabelas direta (caractere -> par de símbolos) e inversa (par -> caractere), uma cópia da
+ * matriz com folga para leituras vetoriais e, quando a matriz usa os mesmos caracteres da padrão, os
+ * símbolos de linha e de coluna de cada caractere indexados pela sua posição na matriz padrão, que
+ * permitem aos kernels vetoriais de codificação reaproveitarem a classificação da matriz padrão.
+ *
+ * @param polybius Matriz compilada (saída), que aponta para as tabelas.
+ * @param tables Memória das tabelas; precisa continuar válida enquanto polybius for usada.
+ * @param cells Matriz com POLYBIUS_CELLS caracteres distintos e diferentes de '\0', linha a linha.
+ * @return int 0 em caso de sucesso, 1 se a matriz tiver '\0' ou caracteres repetidos.
+ */
+int polybius_square_compile(polybius_square *polybius, polybius_square_tables *tables, const char cells[POLYBIUS_CELLS])
+{
+  int default_alphabet = 1;
+
+  memset(tables, 0, sizeof(*tables));
+
+  for (int cell = 0; cell < POLYBIUS_CELLS; cell++)
+  {
+    unsigned char c = cells[cell];
+
+    if (c == '\0' || tables->forward[c] != 0)
+    {
+      return 1;
+    }
+
+    tables->forward[c] = POLYBIUS_PAIR(symbols[cell / 6], symbols[cell % 6]);
+    tables->forward_indices[c] = INDEX_PAIR(cell);
+    tables->reverse[cell / 6 + 1][cell % 6 + 1] = c;
+    tables->cells[cell] = c;
+    default_alphabet &= (polybius_forward[c] & POLYBIUS_VALID) != 0;
+  }
+
+  // Posição p da matriz padrão -> símbolos, nesta matriz, do caractere que está em p
+  for (int p = 0; default_alphabet && p < POLYBIUS_CELLS; p++)
+  {
+    unsigned short pair = tables->forward[(unsigned char)default_cells[p]];
+
+    tables->row_symbols[p] = POLYBIUS_ROW(pair);
+    tables->col_symbols[p] = POLYBIUS_COL(pair);
+    tables->row_indices[p] = symbol_rank[(unsigned char)POLYBIUS_ROW(pair)] - 1;
+    tables->col_indices[p] = symbol_rank[(unsigned char)POLYBIUS_COL(pair)] - 1;
+  }
+
+  polybius->forward = tables->forward;
+  polybius->reverse = (const char(*)[7])tables->reverse;
+  polybius->cells = tables->cells;
+  polybius->row_symbols = tables->row_symbols;
+  polybius->col_symbols = tables->col_symbols;
+  polybius->default_alphabet = default_alphabet;
+  polybius->forward_indices = tables->forward_indices;
+  polybius->row_indices = tables->row_indices;
+  polybius->col_indices = tables->col_indices;
+  return 0;
+}
+
+/**
+ * @brief Inicializa uma arena sobre uma região de memória fornecida pelo chamador.
+ *
+ * @param arena Arena a ser inicializada.
+ * @param memory Região de memória (estática, da pilha ou alocada uma única vez).
+ * @param size Tamanho da região em bytes.
+ */
+void adfgvx_arena_init(adfgvx_arena *arena, void *memory, size_t size)
+{
+  arena->base = memory;
+  arena->size = size;
+  arena->used = 0;
+}
+
+/**
+ * @brief Reserva um bloco da arena, alinhado em ARENA_ALIGNMENT bytes.
+ *
+ * @param arena Arena de onde o bloco será reservado.
+ * @param size Tamanho do bloco em bytes.
+ * @return void* Ponteiro para o bloco, ou NULL se a arena não tiver espaço.
+ */
+void *adfgvx_arena_alloc(adfgvx_arena *arena, size_t size)
+{
+  size_t start = (arena->used + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+  if (start > arena->size || size > arena->size - start)
+  {
+    return NULL;
+  }
+
+  arena->used = start + size;
+  return arena->base + start;
+}
+
+/**
+ * @brief Calcula quantos bytes de arena um adfgvx_ctx precisa para as capacidades informadas.
+ *
+ * @param message_capacity Quantidade máxima de caracteres por mensagem.
+ * @param key_capacity Comprimento máximo da chave.
+ * @return size_t Tamanho da arena em bytes (já considerando o alinhamento de cada bloco).
+ */
+size_t adfgvx_ctx_arena_size(int message_capacity, int key_capacity)
+{
+  size_t size = 0;
+
+  size += 2 * (sizeof(size_t) * key_capacity + ARENA_ALIGNMENT);     // order e cursor
+  size += (size_t)message_capacity + 1 + ARENA_ALIGNMENT;            // message
+  size += 2 * ((size_t)2 * message_capacity + 1 + ARENA_ALIGNMENT); // output e symbols
+  return size;
+}
+
+/**
+ * @brief Inicializa um contexto de cifra reservando todos os seus buffers na arena.
+ *
+ * Depois da inicialização o contexto pode ser reutilizado para qualquer quantidade de mensagens
+ * (com adfgvx_ctx_reset entre elas) sem nenhuma nova alocação.
+ *
+ * @param ctx Contexto a ser inicializado.
+ * @param arena Arena com pelo menos adfgvx_ctx_arena_size(message_capacity, key_capacity) bytes livres.
+ * @param message_capacity Quantidade máxima de caracteres por mensagem.
+ * @param key_capacity Comprimento máximo da chave.
+ * @return int 0 em caso de sucesso, 1 se a arena não tiver espaço suficiente.
+ */
+int adfgvx_ctx_init(adfgvx_ctx *ctx, adfgvx_arena *arena, int message_capacity, int key_capacity)
+{
+  if (message_capacity <= 0 || key_capacity <= 0)
+  {
+    return 1;
+  }
+
+  ctx->message_capacity = message_capacity;
+  ctx->key_capacity = key_capacity;
+  ctx->order = adfgvx_arena_alloc(arena, sizeof(int) * key_capacity);
+  ctx->cursor = adfgvx_arena_alloc(arena, sizeof(size_t) * key_capacity);
+  ctx->message = adfgvx_arena_alloc(arena, (size_t)message_capacity + 1);
+  ctx->output = adfgvx_arena_alloc(arena, (size_t)2 * message_capacity + 1);
+  ctx->symbols = adfgvx_arena_alloc(arena, (size_t)2 * message_capacity + 1);
+
+  if (ctx->order == NULL || ctx->cursor == NULL || ctx->message == NULL || ctx->output == NULL || ctx->symbols == NULL)
+  {
+    return 1;
+  }
+
+  ctx->kernel = polybius_select_kernel();
+  ctx->polybius = &polybius_default_square;
+  ctx->stats = NULL;
+  adfgvx_ctx_reset(ctx);
+  return 0;
+}
+
+/**
+ * @brief Prepara o contexto para a próxima mensagem, sem liberar nem realocar os buffers.
+ *
+ * @param ctx Contexto inicializado com adfgvx_ctx_init.
+ */
+void adfgvx_ctx_reset(adfgvx_ctx *ctx)
+{
+  ctx->message_length = 0;
+  ctx->symbol_count = 0;
+  ctx->message[0] = '\0';
+  ctx->output[0] = '\0';
+}
+
+// Parte comum de adfgvx_ctx_encrypt e adfgvx_ctx_encrypt_scheduled, a partir da ordem das colunas
+static int ctx_encrypt_ordered(adfgvx_ctx *ctx, const polybius_square *polybius, const int order[], int key_length, const char message[], int message_length, char output[], int output_capacity)
+{
+  if (message_length < 0 || message_length > ctx->message_capacity)
+  {
+    return -1;
+  }
+
+  adfgvx_stats_mark mark;
+  if (ADFGVX_STATS_ON(ctx->stats))
+    adfgvx_stats_start(&mark);
+
+  int symbol_count = ctx->kernel->encode(polybius, message, message_length, ctx->symbols);
+  if (symbol_count >= output_capacity)
+  {
+    return -1;
+  }
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_ENCODE, &mark);
+    adfgvx_stats_start(&mark);
+  }
+
+  compute_column_offsets(key_length, order, symbol_count, ctx->cursor);
+  gather_columns(ctx->symbols, 0, symbol_count, key_length, ctx->cursor, output);
+
+  output[symbol_count] = '\0';
+  ctx->symbol_count = symbol_count;
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_TRANSPOSE, &mark);
+    ctx->stats->bytes_in += message_length;
+    ctx->stats->bytes_out += symbol_count;
+    ctx->stats->invalid_dropped += message_length - symbol_count / 2;
+  }
+  return symbol_count;
+}
+
+// Parte comum de adfgvx_ctx_decrypt e adfgvx_ctx_decrypt_scheduled, a partir da ordem das colunas
+static int ctx_decrypt_ordered(adfgvx_ctx *ctx, const polybius_square *polybius, const int order[], int key_length, const char ciphertext[], int symbol_count, char output[], int output_capacity)
+{
+  if (symbol_count < 0 || symbol_count > 2 * ctx->message_capacity || symbol_count / 2 >= output_capacity)
+  {
+    return -1;
+  }
+
+  adfgvx_stats_mark mark;
+  if (ADFGVX_STATS_ON(ctx->stats))
+    adfgvx_stats_start(&mark);
+
+  compute_column_offsets(key_length, order, symbol_count, ctx->cursor);
+  scatter_columns(ciphertext, 0, symbol_count - symbol_count % 2, key_length, ctx->cursor, ctx->symbols);
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_TRANSPOSE, &mark);
+    adfgvx_stats_start(&mark);
+  }
+
+  int length = ctx->kernel->decode(polybius, ctx->symbols, symbol_count / 2, output);
+
+  output[length] = '\0';
+  ctx->message_length = length;
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_DECODE, &mark);
+    ctx->stats->bytes_in += symbol_count;
+    ctx->stats->bytes_out += length;
+    ctx->stats->invalid_dropped += symbol_count / 2 - length;
+  }
+  return length;
+}
+
+/**
+ * @brief Cifra uma mensagem usando os buffers do contexto, escrevendo no buffer do chamador.
+ *
+ * Codifica a mensagem em sequência linear no buffer auxiliar com o kernel escolhido para a CPU
+ * (ctx->kernel) e a matriz do contexto (ctx->polybius) e lineariza as colunas na ordem da chave com
+ * gather_columns. Bytes fora da matriz Polybius (inclusive '\0') são ignorados.
+ *
+ * @param ctx Contexto inicializado com adfgvx_ctx_init.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave (no máximo ctx->key_capacity).
+ * @param message Mensagem de entrada (no máximo ctx->message_capacity bytes).
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer de saída fornecido pelo chamador (pode ser ctx->output).
+ * @param output_capacity Tamanho de output; precisa comportar os símbolos e o '\0' final.
+ * @return int Quantidade de símbolos escritos, ou -1 se alguma capacidade for excedida.
+ */
+int adfgvx_ctx_encrypt(adfgvx_ctx *ctx, const char key[], int key_length, const char message[], int message_length, char output[], int output_capacity)
+{
+  if (key_length <= 0 || key_length > ctx->key_capacity)
+  {
+    return -1;
+  }
+
+  compute_column_order(key, key_length, ctx->order);
+  return ctx_encrypt_ordered(ctx, ctx->polybius, ctx->order, key_length, message, message_length, output, output_capacity);
+}
+
+/**
+ * @brief Decifra um texto usando os buffers do contexto, escrevendo no buffer do chamador.
+ *
+ * Calcula a posição inicial de cada coluna a partir do tamanho do texto cifrado e da ordem da chave,
+ * reconstrói a sequência de símbolos no buffer auxiliar com scatter_columns (em blocos) e decodifica
+ * os pares com o kernel escolhido para a CPU (ctx->kernel), sem matriz de colunas.
+ *
+ * @param ctx Contexto inicializado com adfgvx_ctx_init.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave (no máximo ctx->key_capacity).
+ * @param ciphertext Texto cifrado (no máximo 2 * ctx->message_capacity símbolos).
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída fornecido pelo chamador (pode ser ctx->message).
+ * @param output_capacity Tamanho de output; precisa comportar a mensagem e o '\0' final.
+ * @return int Quantidade de caracteres escritos, ou -1 se alguma capacidade for excedida.
+ */
+int adfgvx_ctx_decrypt(adfgvx_ctx *ctx, const char key[], int key_length, const char ciphertext[], int symbol_count, char output[], int output_capacity)
+{
+  if (key_length <= 0 || key_length > ctx->key_capacity)
+  {
+    return -1;
+  }
+
+  compute_column_order(key, key_length, ctx->order);
+  return ctx_decrypt_ordered(ctx, ctx->polybius, ctx->order, key_length, ciphertext, symbol_count, output, output_capacity);
+}
+
+/**
+ * @brief Cifra uma mensagem usando os buffers do contexto e um escalonamento de chave já compilado.
+ *
+ * Igual a adfgvx_ctx_encrypt, mas sem nenhum trabalho sobre a chave: a ordem das colunas e a matriz
+ * Polybius vêm do escalonamento (por exemplo, obtido de um adfgvx_schedule_cache).
+ *
+ * @param ctx Contexto inicializado com adfgvx_ctx_init.
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param message Mensagem de entrada (no máximo ctx->message_capacity bytes).
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer de saída fornecido pelo chamador (pode ser ctx->output).
+ * @param output_capacity Tamanho de output; precisa comportar os símbolos e o '\0' final.
+ * @return int Quantidade de símbolos escritos, ou -1 se alguma capacidade for excedida.
+ */
+int adfgvx_ctx_encrypt_scheduled(adfgvx_ctx *ctx, const adfgvx_key_schedule *schedule, const char message[], int message_length, char output[], int output_capacity)
+{
+  if (schedule->key_length > ctx->key_capacity)
+  {
+    return -1;
+  }
+
+  return ctx_encrypt_ordered(ctx, &schedule->polybius, schedule->order, schedule->key_length, message, message_length, output, output_capacity);
+}
+
+/**
+ * @brief Decifra um texto usando os buffers do contexto e um escalonamento de chave já compilado.
+ *
+ * @param ctx Contexto inicializado com adfgvx_ctx_init.
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param ciphertext Texto cifrado (no máximo 2 * ctx->message_capacity símbolos).
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída fornecido pelo chamador (pode ser ctx->message).
+ * @param output_capacity Tamanho de output; precisa comportar a mensagem e o '\0' final.
+ * @return int Quantidade de caracteres escritos, ou -1 se alguma capacidade for excedida.
+ */
+int adfgvx_ctx_decrypt_scheduled(adfgvx_ctx *ctx, const adfgvx_key_schedule *schedule, const char ciphertext[], int symbol_count, char output[], int output_capacity)
+{
+  if (schedule->key_length > ctx->key_capacity)
+  {
+    return -1;
+  }
+
+  return ctx_decrypt_ordered(ctx, &schedule->polybius, schedule->order, schedule->key_length, ciphertext, symbol_count, output, output_capacity);
+}
+
+/**
+ * @brief Calcula o tamanho do texto cifrado de uma mensagem (2 símbolos por caractere válido).
+ *
+ * @param message Mensagem de entrada (não precisa terminar em '\0').
+ * @param message_length Quantidade de bytes da mensagem.
+ * @return size_t Quantidade de símbolos que adfgvx_encrypt vai produzir (sem o '\0' final).
+ */
+size_t adfgvx_encrypted_length(const char message[], size_t message_length)
+{
+  return 2 * count_valid_characters(message, message_length);
+}
+
+/**
+ * @brief Cifra uma mensagem em memória, sem alocações e sem E/S.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param message Mensagem de entrada (não precisa terminar em '\0'); bytes fora da matriz são ignorados.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer do texto cifrado.
+ * @param output_capacity Tamanho de output; precisa comportar os símbolos e o '\0' final.
+ * @param output_length Quantidade de símbolos escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se a chave for inválida ou output for pequeno demais.
+ */
+int adfgvx_encrypt(const char key[], int key_length, const char message[], size_t message_length, char output[], size_t output_capacity, size_t *output_length)
+{
+  size_t symbol_count = adfgvx_encrypted_length(message, message_length);
+
+  if (key_length <= 0 || symbol_count >= output_capacity)
+  {
+    return 1;
+  }
+
+  cipher_adfgvx_buffer(key, key_length, message, message_length, symbol_count, output);
+  output[symbol_count] = '\0';
+  if (output_length != NULL)
+    *output_length = symbol_count;
+  return 0;
+}
+
+/**
+ * @brief Decifra um texto ADFGVX em memória, em uma única passada, sem alocações e sem E/S.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param ciphertext Texto cifrado (não precisa terminar em '\0').
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer da mensagem decifrada.
+ * @param output_capacity Tamanho de output; precisa comportar symbol_count / 2 caracteres e o '\0' final.
+ * @param output_length Quantidade de caracteres escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se a chave for inválida ou output for pequeno demais.
+ */
+int adfgvx_decrypt(const char key[], int key_length, const char ciphertext[], size_t symbol_count, char output[], size_t output_capacity, size_t *output_length)
+{
+  if (key_length <= 0 || symbol_count / 2 >= output_capacity)
+  {
+    return 1;
+  }
+
+  size_t length = decipher_adfgvx_direct(key, key_length, ciphertext, symbol_count, output);
+  if (output_length != NULL)
+    *output_length = length;
+  return 0;
+}
+
+/**
+ * @brief Cifra várias mensagens com a mesma chave, calculando a ordem das colunas uma única vez.
+ *
+ * Mensagens cujo buffer de saída é pequeno demais não são cifradas e ficam com output_lengths[i] = 0.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param count Quantidade de mensagens.
+ * @param messages Mensagens de entrada.
+ * @param message_lengths Quantidade de bytes de cada mensagem.
+ * @param outputs Buffers dos textos cifrados.
+ * @param output_capacities Tamanho de cada buffer de saída (símbolos e '\0' final).
+ * @param output_lengths Quantidade de símbolos escritos em cada saída.
+ * @return int Quantidade de mensagens que não foram cifradas (0 se todas foram), ou -1 se a chave for inválida.
+ */
+int adfgvx_encrypt_batch(const char key[], int key_length, size_t count, const char *const messages[], const size_t message_lengths[], char *const outputs[], const size_t output_capacities[], size_t output_lengths[])
+{
+  if (key_length <= 0)
+  {
+    return -1;
+  }
+
+  int order[key_length];
+  int failures = 0;
+
+  compute_column_order(key, key_length, order);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    size_t symbol_count = adfgvx_encrypted_length(messages[i], message_lengths[i]);
+
+    output_lengths[i] = 0;
+    if (symbol_count >= output_capacities[i])
+    {
+      failures++;
+      continue;
+    }
+
+    cipher_adfgvx_ordered(&polybius_default_square, order, key_length, messages[i], message_lengths[i], symbol_count, outputs[i]);
+    outputs[i][symbol_count] = '\0';
+    output_lengths[i] = symbol_count;
+  }
+  return failures;
+}
+
+/**
+ * @brief Decifra vários textos com a mesma chave, calculando a ordem das colunas uma única vez.
+ *
+ * Textos cujo buffer de saída é pequeno demais não são decifrados e ficam com output_lengths[i] = 0.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param count Quantidade de textos cifrados.
+ * @param ciphertexts Textos cifrados.
+ * @param symbol_counts Quantidade de símbolos de cada texto cifrado.
+ * @param outputs Buffers das mensagens decifradas.
+ * @param output_capacities Tamanho de cada buffer de saída (caracteres e '\0' final).
+ * @param output_lengths Quantidade de caracteres escritos em cada saída.
+ * @return int Quantidade de textos que não foram decifrados (0 se todos foram), ou -1 se a chave for inválida.
+ */
+int adfgvx_decrypt_batch(const char key[], int key_length, size_t count, const char *const ciphertexts[], const size_t symbol_counts[], char *const outputs[], const size_t output_capacities[], size_t output_lengths[])
+{
+  if (key_length <= 0)
+  {
+    return -1;
+  }
+
+  int order[key_length];
+  int failures = 0;
+
+  compute_column_order(key, key_length, order);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    output_lengths[i] = 0;
+    if (symbol_counts[i] / 2 >= output_capacities[i])
+    {
+      failures++;
+      continue;
+    }
+
+    output_lengths[i] = decipher_adfgvx_ordered(&polybius_default_square, order, key_length, ciphertexts[i], symbol_counts[i], outputs[i]);
+  }
+  return failures;
+}
+
+/**
+ * @brief Cifra uma mensagem em memória com um escalonamento de chave já compilado.
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param message Mensagem de entrada (não precisa terminar em '\0'); bytes fora da matriz são ignorados.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer do texto cifrado.
+ * @param output_capacity Tamanho de output; precisa comportar os símbolos e o '\0' final.
+ * @param output_length Quantidade de símbolos escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se output for pequeno demais.
+ */
+int adfgvx_encrypt_scheduled(const adfgvx_key_schedule *schedule, const char message[], size_t message_length, char output[], size_t output_capacity, size_t *output_length)
+{
+  size_t symbol_count = 2 * polybius_count_valid(&schedule->polybius, message, message_length);
+
+  if (symbol_count >= output_capacity)
+  {
+    return 1;
+  }
+
+  cipher_adfgvx_ordered(&schedule->polybius, schedule->order, schedule->key_length, message, message_length, symbol_count, output);
+  output[symbol_count] = '\0';
+  if (output_length != NULL)
+    *output_length = symbol_count;
+  return 0;
+}
+
+/**
+ * @brief Decifra um texto ADFGVX em memória com um escalonamento de chave já compilado.
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param ciphertext Texto cifrado (não precisa terminar em '\0').
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer da mensagem decifrada.
+ * @param output_capacity Tamanho de output; precisa comportar symbol_count / 2 caracteres e o '\0' final.
+ * @param output_length Quantidade de caracteres escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se output for pequeno demais.
+ */
+int adfgvx_decrypt_scheduled(const adfgvx_key_schedule *schedule, const char ciphertext[], size_t symbol_count, char output[], size_t output_capacity, size_t *output_length)
+{
+  if (symbol_count / 2 >= output_capacity)
+  {
+    return 1;
+  }
+
+  size_t length = decipher_adfgvx_ordered(&schedule->polybius, schedule->order, schedule->key_length, ciphertext, symbol_count, output);
+  if (output_length != NULL)
+    *output_length = length;
+  return 0;
+}
+
+/**
+ * @brief Calcula quantos bytes de arena um escalonamento de chave precisa.
+ *
+ * @param key_capacity Comprimento máximo da chave.
+ * @return size_t Tamanho da arena em bytes (já considerando o alinhamento de cada bloco).
+ */
+size_t adfgvx_key_schedule_arena_size(int key_capacity)
+{
+  size_t size = (size_t)key_capacity + ARENA_ALIGNMENT + 2 * (sizeof(int) * key_capacity + ARENA_ALIGNMENT); // key, order e rank
+
+  return size + sizeof(polybius_square_tables) + ARENA_ALIGNMENT; // tabelas de uma matriz própria
+}
+
+/**
+ * @brief Inicializa um escalonamento vazio reservando seus vetores na arena.
+ *
+ * @param schedule Escalonamento a ser inicializado.
+ * @param arena Arena com pelo menos adfgvx_key_schedule_arena_size(key_capacity) bytes livres.
+ * @param key_capacity Comprimento máximo da chave.
+ * @return int 0 em caso de sucesso, 1 se a arena não tiver espaço suficiente.
+ */
+int adfgvx_key_schedule_init(adfgvx_key_schedule *schedule, adfgvx_arena *arena, int key_capacity)
+{
+  if (key_capacity <= 0)
+  {
+    return 1;
+  }
+
+  memset(schedule, 0, sizeof(*schedule));
+  schedule->key_capacity = key_capacity;
+  schedule->key = adfgvx_arena_alloc(arena, (size_t)key_capacity);
+  schedule->order = adfgvx_arena_alloc(arena, sizeof(int) * key_capacity);
+  schedule->rank = adfgvx_arena_alloc(arena, sizeof(int) * key_capacity);
+  schedule->tables = adfgvx_arena_alloc(arena, sizeof(polybius_square_tables));
+  schedule->polybius = polybius_default_square;
+
+  return schedule->key == NULL || schedule->order == NULL || schedule->rank == NULL || schedule->tables == NULL;
+}
+
+// Hash FNV-1a dos bytes da chave (e da matriz própria, se houver), usado para descartar rapidamente
+// as entradas do cache que não batem
+static unsigned int key_hash(const char key[], int key_length, const char cells[])
+{
+  unsigned int hash = 2166136261u;
+
+  for (int i = 0; i < key_length; i++)
+  {
+    hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+  }
+  for (int i = 0; cells != NULL && i < POLYBIUS_CELLS; i++)
+  {
+    hash = (hash ^ (unsigned char)cells[i]) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief Compila uma chave com a matriz Polybius padrão (ver adfgvx_key_schedule_compile_square).
+ *
+ * @param schedule Escalonamento inicializado com adfgvx_key_schedule_init.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave (no máximo schedule->key_capacity).
+ * @return int 0 em caso de sucesso, 1 se a chave for vazia ou longa demais.
+ */
+int adfgvx_key_schedule_compile(adfgvx_key_schedule *schedule, const char key[], int key_length)
+{
+  return adfgvx_key_schedule_compile_square(schedule, key, key_length, NULL);
+}
+
+/**
+ * @brief Compila uma chave e uma matriz Polybius: guarda uma cópia dos bytes, a permutação das
+ * colunas, a sua inversa e as tabelas da matriz.
+ *
+ * Depois de compilado, o escalonamento contém todo o trabalho que depende só da chave; cifrar ou
+ * decifrar uma mensagem precisa apenas das posições iniciais das colunas, que saem em O(key_length) de
+ * compute_column_offsets (a coluna c tem symbol_count / key_length símbolos, mais um se
+ * c < symbol_count % key_length).
+ *
+ * A matriz padrão usa as tabelas de tempo de compilação; uma matriz própria é compilada nas tabelas
+ * do escalonamento, então cifrar com ela custa o mesmo que com a padrão.
+ *
+ * @param schedule Escalonamento inicializado com adfgvx_key_schedule_init.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave (no máximo schedule->key_capacity).
+ * @param cells Matriz com POLYBIUS_CELLS caracteres, linha a linha, ou NULL para a matriz padrão.
+ * @return int 0 em caso de sucesso, 1 se a chave for vazia ou longa demais, ou se a matriz for inválida.
+ */
+int adfgvx_key_schedule_compile_square(adfgvx_key_schedule *schedule, const char key[], int key_length, const char cells[])
+{
+  if (key_length <= 0 || key_length > schedule->key_capacity)
+  {
+    return 1;
+  }
+
+  if (cells == NULL || memcmp(cells, default_cells, POLYBIUS_CELLS) == 0)
+  {
+    schedule->polybius = polybius_default_square;
+  }
+  else if (polybius_square_compile(&schedule->polybius, schedule->tables, cells) != 0)
+  {
+    schedule->key_length = 0;
+    return 1;
+  }
+
+  memcpy(schedule->key, key, (size_t)key_length);
+  schedule->key_length = key_length;
+  schedule->hash = key_hash(key, key_length, schedule->polybius.cells != default_cells ? schedule->polybius.cells : NULL);
+  compute_column_order(key, key_length, schedule->order);
+
+  for (int i = 0; i < key_length; i++)
+  {
+    schedule->rank[schedule->order[i]] = i;
+  }
+  return 0;
+}
+
+/**
+ * @brief Quantidade de símbolos da coluna `column` (na ordem original da chave) de um texto cifrado.
+ *
+ * @param schedule Escalonamento compilado.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param column Índice da coluna na chave original.
+ * @return size_t Quantidade de símbolos da coluna.
+ */
+size_t adfgvx_key_schedule_column_length(const adfgvx_key_schedule *schedule, size_t symbol_count, int column)
+{
+  size_t k = (size_t)schedule->key_length;
+
+  return symbol_count / k + ((size_t)column < symbol_count % k);
+}
+
+/**
+ * @brief Calcula quantos bytes de arena um cache de escalonamentos precisa.
+ *
+ * @param entry_count Quantidade máxima de chaves no cache.
+ * @param key_capacity Comprimento máximo de cada chave.
+ * @return size_t Tamanho da arena em bytes.
+ */
+size_t adfgvx_schedule_cache_arena_size(int entry_count, int key_capacity)
+{
+  return sizeof(adfgvx_key_schedule) * entry_count + ARENA_ALIGNMENT + (size_t)entry_count * adfgvx_key_schedule_arena_size(key_capacity);
+}
+
+/**
+ * @brief Inicializa um cache LRU de escalonamentos com todas as entradas reservadas na arena.
+ *
+ * O cache nunca aloca depois da inicialização: uma chave nova reaproveita a entrada usada há mais
+ * tempo que não esteja em uso (refcount 0). É seguro para várias threads.
+ *
+ * @param cache Cache a ser inicializado.
+ * @param arena Arena com pelo menos adfgvx_schedule_cache_arena_size(entry_count, key_capacity) bytes livres.
+ * @param entry_count Quantidade máxima de chaves no cache.
+ * @param key_capacity Comprimento máximo de cada chave.
+ * @return int 0 em caso de sucesso, 1 se a arena não tiver espaço suficiente.
+ */
+int adfgvx_schedule_cache_init(adfgvx_schedule_cache *cache, adfgvx_arena *arena, int entry_count, int key_capacity)
+{
+  if (entry_count <= 0 || key_capacity <= 0)
+  {
+    return 1;
+  }
+
+  cache->entries = adfgvx_arena_alloc(arena, sizeof(adfgvx_key_schedule) * entry_count);
+  if (cache->entries == NULL)
+  {
+    return 1;
+  }
+
+  cache->entry_count = entry_count;
+  cache->key_capacity = key_capacity;
+  cache->head = NULL;
+  cache->tail = NULL;
+  cache->hits = 0;
+  cache->misses = 0;
+
+  // Todas as entradas começam vazias (key_length 0) na lista, da mais recente para a mais antiga
+  for (int i = 0; i < entry_count; i++)
+  {
+    adfgvx_key_schedule *entry = &cache->entries[i];
+
+    if (adfgvx_key_schedule_init(entry, arena, key_capacity))
+    {
+      return 1;
+    }
+    entry->prev = cache->tail;
+    entry->next = NULL;
+    if (cache->tail != NULL)
+      cache->tail->next = entry;
+    else
+      cache->head = entry;
+    cache->tail = entry;
+  }
+
+  pthread_mutex_init(&cache->lock, NULL);
+  return 0;
+}
+
+/**
+ * @brief Libera o mutex do cache (a memória das entradas pertence à arena).
+ *
+ * @param cache Cache inicializado com adfgvx_schedule_cache_init.
+ */
+void adfgvx_schedule_cache_destroy(adfgvx_schedule_cache *cache)
+{
+  pthread_mutex_destroy(&cache->lock);
+}
+
+// Move uma entrada para o início da lista (usada mais recentemente). Chamada com o mutex travado.
+static void schedule_cache_touch(adfgvx_schedule_cache *cache, adfgvx_key_schedule *entry)
+{
+  if (cache->head == entry)
+  {
+    return;
+  }
+
+  entry->prev->next = entry->next;
+  if (entry->next != NULL)
+    entry->next->prev = entry->prev;
+  else
+    cache->tail = entry->prev;
+
+  entry->prev = NULL;
+  entry->next = cache->head;
+  cache->head->prev = entry;
+  cache->head = entry;
+}
+
+/**
+ * @brief Obtém o escalonamento compilado de uma chave com a matriz padrão (ver adfgvx_schedule_acquire_square).
+ *
+ * @param cache Cache inicializado com adfgvx_schedule_cache_init.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @return const adfgvx_key_schedule* Escalonamento da chave, ou NULL (ver adfgvx_schedule_acquire_square).
+ */
+const adfgvx_key_schedule *adfgvx_schedule_acquire(adfgvx_schedule_cache *cache, const char key[], int key_length)
+{
+  return adfgvx_schedule_acquire_square(cache, key, key_length, NULL);
+}
+
+/**
+ * @brief Obtém o escalonamento compilado de uma chave e de uma matriz Polybius, compilando-o apenas se
+ * o par não estiver no cache.
+ *
+ * A entrada devolvida fica reservada (refcount) até adfgvx_schedule_release e não é reaproveitada
+ * enquanto isso, então pode ser usada fora do mutex.
+ *
+ * @param cache Cache inicializado com adfgvx_schedule_cache_init.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param cells Matriz com POLYBIUS_CELLS caracteres, linha a linha, ou NULL para a matriz padrão.
+ * @return const adfgvx_key_schedule* Escalonamento da chave, ou NULL se a chave ou a matriz forem
+ * inválidas, se a chave for longa demais, ou se todas as entradas estiverem em uso.
+ */
+const adfgvx_key_schedule *adfgvx_schedule_acquire_square(adfgvx_schedule_cache *cache, const char key[], int key_length, const char cells[])
+{
+  if (key_length <= 0 || key_length > cache->key_capacity)
+  {
+    return NULL;
+  }
+
+  if (cells != NULL && memcmp(cells, default_cells, POLYBIUS_CELLS) == 0)
+  {
+    cells = NULL;
+  }
+
+  unsigned int hash = key_hash(key, key_length, cells);
+  adfgvx_key_schedule *entry;
+
+  pthread_mutex_lock(&cache->lock);
+
+  for (entry = cache->head; entry != NULL; entry = entry->next)
+  {
+    int custom = entry->polybius.cells != default_cells;
+
+    if (entry->hash == hash && entry->key_length == key_length && memcmp(entry->key, key, (size_t)key_length) == 0 &&
+        custom == (cells != NULL) && (!custom || memcmp(entry->polybius.cells, cells, POLYBIUS_CELLS) == 0))
+    {
+      break;
+    }
+  }
+
+  if (entry != NULL)
+  {
+    cache->hits++;
+  }
+  else
+  {
+    // Reaproveita a entrada usada há mais tempo que não esteja reservada
+    for (entry = cache->tail; entry != NULL && entry->refcount > 0; entry = entry->prev)
+      ;
+
+    if (entry == NULL)
+    {
+      pthread_mutex_unlock(&cache->lock);
+      return NULL;
+    }
+
+    cache->misses++;
+    if (adfgvx_key_schedule_compile_square(entry, key, key_length, cells) != 0)
+    {
+      pthread_mutex_unlock(&cache->lock);
+      return NULL;
+    }
+  }
+
+  entry->refcount++;
+  schedule_cache_touch(cache, entry);
+  pthread_mutex_unlock(&cache->lock);
+  return entry;
+}
+
+/**
+ * @brief Devolve ao cache um escalonamento obtido com adfgvx_schedule_acquire.
+ *
+ * @param cache Cache de onde o escalonamento foi obtido.
+ * @param schedule Escalonamento a ser devolvido.
+ */
+void adfgvx_schedule_release(adfgvx_schedule_cache *cache, const adfgvx_key_schedule *schedule)
+{
+  pthread_mutex_lock(&cache->lock);
+  ((adfgvx_key_schedule *)schedule)->refcount--;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * @brief Trecho de uma mensagem (ou de um texto cifrado) processado por uma thread dos caminhos paralelos.
+ */
+typedef struct
+{
+  const adfgvx_key_schedule *schedule;
+  const size_t *column_start; // Posição inicial de cada coluna no texto cifrado completo
+  const char *input;          // Mensagem ou texto cifrado completo
+  size_t begin;               // Início do trecho (bytes da mensagem ou símbolos do texto cifrado)
+  size_t end;                 // Fim do trecho (exclusivo)
+  size_t first;               // Índice global do primeiro símbolo do trecho
+  char *output;
+  size_t result;
+} parallel_task;
+
+// Contagem dos caracteres válidos de um trecho da mensagem
+static void *parallel_count_task(void *arg)
+{
+  parallel_task *task = arg;
+
+  task->result = polybius_count_valid(&task->schedule->polybius, task->input + task->begin, task->end - task->begin);
+  return NULL;
+}
+
+// Cifragem de um trecho da mensagem direto para as posições finais dos seus símbolos
+static void *parallel_encrypt_task(void *arg)
+{
+  parallel_task *task = arg;
+
+  encrypt_range(&task->schedule->polybius, task->schedule->key_length, task->column_start, task->first,
+                task->input + task->begin, task->end - task->begin, task->output);
+  return NULL;
+}
+
+// Decifragem de um trecho de símbolos da sequência original, escrita a partir de output + begin / 2
+static void *parallel_decrypt_task(void *arg)
+{
+  parallel_task *task = arg;
+
+  task->result = decrypt_range(&task->schedule->polybius, task->schedule->key_length, task->column_start, task->begin,
+                               task->end - task->begin, task->input, task->output + task->begin / 2);
+  return NULL;
+}
+
+/**
+ * @brief Executa uma tarefa por trecho: a primeira na thread atual e as demais em threads novas (ou na
+ * thread atual, se não for possível criá-las).
+ */
+static void run_parallel(parallel_task tasks[], int count, void *(*work)(void *))
+{
+  pthread_t threads[ADFGVX_MAX_THREADS];
+  int started[ADFGVX_MAX_THREADS] = {0};
+
+  for (int t = 1; t < count; t++)
+  {
+    started[t] = pthread_create(&threads[t], NULL, work, &tasks[t]) == 0;
+  }
+
+  work(&tasks[0]);
+
+  for (int t = 1; t < count; t++)
+  {
+    if (started[t])
+      pthread_join(threads[t], NULL);
+    else
+      work(&tasks[t]);
+  }
+}
+
+// Quantidade de threads usada para `size` bytes (ou símbolos): no máximo uma a cada PARALLEL_MIN_BYTES
+static int parallel_thread_count(size_t size, int thread_count)
+{
+  size_t limit = size / PARALLEL_MIN_BYTES + 1;
+
+  if (thread_count > ADFGVX_MAX_THREADS)
+    thread_count = ADFGVX_MAX_THREADS;
+  if (thread_count < 1)
+    thread_count = 1;
+  return (size_t)thread_count < limit ? thread_count : (int)limit;
+}
+
+/**
+ * @brief Primeira fase da cifragem paralela: divide a mensagem em trechos e conta, em paralelo, os
+ * caracteres válidos de cada um.
+ *
+ * A soma de prefixos das contagens dá o índice global do primeiro símbolo de cada trecho e o tamanho
+ * exato do texto cifrado, que o chamador usa para preparar a saída (por exemplo, um arquivo mapeado)
+ * antes de adfgvx_parallel_encrypt.
+ *
+ * @param plan Plano de saída.
+ * @param schedule Escalonamento compilado (a matriz Polybius define quais caracteres são válidos).
+ * @param message Mensagem de entrada.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param thread_count Quantidade máxima de threads (limitada a ADFGVX_MAX_THREADS e ao tamanho da mensagem).
+ * @return size_t Quantidade total de símbolos do texto cifrado.
+ */
+size_t adfgvx_parallel_count(adfgvx_parallel_plan *plan, const adfgvx_key_schedule *schedule, const char message[], size_t message_length, int thread_count)
+{
+  parallel_task tasks[ADFGVX_MAX_THREADS];
+  int count = parallel_thread_count(message_length, thread_count);
+
+  plan->thread_count = count;
+  for (int t = 0; t <= count; t++)
+  {
+    plan->message_start[t] = message_length / count * t + (message_length % count) * t / count;
+  }
+
+  for (int t = 0; t < count; t++)
+  {
+    tasks[t] = (parallel_task){.schedule = schedule, .input = message, .begin = plan->message_start[t], .end = plan->message_start[t + 1]};
+  }
+  run_parallel(tasks, count, parallel_count_task);
+
+  plan->symbol_start[0] = 0;
+  for (int t = 0; t < count; t++)
+  {
+    plan->symbol_start[t + 1] = plan->symbol_start[t] + 2 * tasks[t].result;
+  }
+  return plan->symbol_start[count];
+}
+
+/**
+ * @brief Segunda fase da cifragem paralela: cada thread cifra o seu trecho direto para as posições
+ * finais dos seus símbolos.
+ *
+ * O resultado é idêntico ao de cipher_adfgvx_ordered (cada símbolo vai para a mesma posição), então
+ * não depende da quantidade de threads.
+ *
+ * @param plan Plano obtido com adfgvx_parallel_count para a mesma mensagem e escalonamento.
+ * @param schedule Escalonamento compilado.
+ * @param message Mensagem de entrada.
+ * @param output Buffer de saída com plan->symbol_start[plan->thread_count] posições.
+ */
+void adfgvx_parallel_encrypt(const adfgvx_parallel_plan *plan, const adfgvx_key_schedule *schedule, const char message[], char output[])
+{
+  parallel_task tasks[ADFGVX_MAX_THREADS];
+  size_t column_start[schedule->key_length];
+
+  compute_column_offsets(schedule->key_length, schedule->order, plan->symbol_start[plan->thread_count], column_start);
+
+  for (int t = 0; t < plan->thread_count; t++)
+  {
+    tasks[t] = (parallel_task){.schedule = schedule, .column_start = column_start, .input = message, .begin = plan->message_start[t],
+                               .end = plan->message_start[t + 1], .first = plan->symbol_start[t], .output = output};
+  }
+  run_parallel(tasks, plan->thread_count, parallel_encrypt_task);
+}
+
+/**
+ * @brief Decifra um texto ADFGVX dividindo a sequência original de símbolos em faixas de pares, uma
+ * por thread.
+ *
+ * Cada thread decodifica a sua faixa a partir da posição output + begin / 2; como pares inválidos
+ * são descartados, as faixas são depois aproximadas com memmove, na ordem (nenhuma cópia quando o
+ * texto cifrado é todo válido). O resultado é idêntico ao de decipher_adfgvx_ordered.
+ *
+ * @param schedule Escalonamento compilado.
+ * @param ciphertext Texto cifrado.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída com pelo menos symbol_count / 2 + 1 posições.
+ * @param thread_count Quantidade máxima de threads.
+ * @return size_t Quantidade de caracteres escritos em output (terminado em '\0').
+ */
+size_t adfgvx_parallel_decrypt(const adfgvx_key_schedule *schedule, const char ciphertext[], size_t symbol_count, char output[], int thread_count)
+{
+  parallel_task tasks[ADFGVX_MAX_THREADS];
+  size_t column_start[schedule->key_length];
+  int count = parallel_thread_count(symbol_count, thread_count);
+  size_t length = 0;
+
+  compute_column_offsets(schedule->key_length, schedule->order, symbol_count, column_start);
+
+  // Faixas com quantidade par de símbolos; só a última pode terminar em um símbolo sem par
+  for (int t = 0; t < count; t++)
+  {
+    size_t begin = (symbol_count / count * t + (symbol_count % count) * t / count) & ~(size_t)1;
+    size_t end = t + 1 == count ? symbol_count : (symbol_count / count * (t + 1) + (symbol_count % count) * (t + 1) / count) & ~(size_t)1;
+
+    tasks[t] = (parallel_task){.schedule = schedule, .column_start = column_start, .input = ciphertext, .begin = begin, .end = end, .output = output};
+  }
+  run_parallel(tasks, count, parallel_decrypt_task);
+
+  for (int t = 0; t < count; t++)
+  {
+    if (length != tasks[t].begin / 2)
+      memmove(output + length, output + tasks[t].begin / 2, tasks[t].result);
+    length += tasks[t].result;
+  }
+
+  output[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief Cifra uma mensagem em memória com várias threads (contagem e escrita paralelas).
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param message Mensagem de entrada; bytes fora da matriz são ignorados.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer do texto cifrado.
+ * @param output_capacity Tamanho de output; precisa comportar os símbolos e o '\0' final.
+ * @param output_length Quantidade de símbolos escritos (saída, pode ser NULL).
+ * @param thread_count Quantidade máxima de threads.
+ * @return int 0 em caso de sucesso, 1 se output for pequeno demais.
+ */
+int adfgvx_encrypt_parallel(const adfgvx_key_schedule *schedule, const char message[], size_t message_length, char output[], size_t output_capacity, size_t *output_length, int thread_count)
+{
+  adfgvx_parallel_plan plan;
+  size_t symbol_count = adfgvx_parallel_count(&plan, schedule, message, message_length, thread_count);
+
+  if (symbol_count >= output_capacity)
+  {
+    return 1;
+  }
+
+  adfgvx_parallel_encrypt(&plan, schedule, message, output);
+  output[symbol_count] = '\0';
+  if (output_length != NULL)
+    *output_length = symbol_count;
+  return 0;
+}
+
+/**
+ * @brief Decifra um texto ADFGVX em memória com várias threads.
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param ciphertext Texto cifrado.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer da mensagem decifrada.
+ * @param output_capacity Tamanho de output; precisa comportar symbol_count / 2 caracteres e o '\0' final.
+ * @param output_length Quantidade de caracteres escritos (saída, pode ser NULL).
+ * @param thread_count Quantidade máxima de threads.
+ * @return int 0 em caso de sucesso, 1 se output for pequeno demais.
+ */
+int adfgvx_decrypt_parallel(const adfgvx_key_schedule *schedule, const char ciphertext[], size_t symbol_count, char output[], size_t output_capacity, size_t *output_length, int thread_count)
+{
+  if (symbol_count / 2 >= output_capacity)
+  {
+    return 1;
+  }
+
+  size_t length = adfgvx_parallel_decrypt(schedule, ciphertext, symbol_count, output, thread_count);
+  if (output_length != NULL)
+    *output_length = length;
+  return 0;
+}
+
+/**
+ * @brief Marca o início de uma etapa: tempo de um relógio monotônico e contador de ciclos.
+ *
+ * @param mark Marca de início, usada depois por adfgvx_stats_stop.
+ */
+void adfgvx_stats_start(adfgvx_stats_mark *mark)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  mark->seconds = now.tv_sec + now.tv_nsec / 1e9;
+#ifdef ADFGVX_X86_SIMD
+  mark->cycles = __rdtsc();
+#else
+  mark->cycles = 0;
+#endif
+}
+
+/**
+ * @brief Soma à etapa o tempo e os ciclos decorridos desde a marca.
+ *
+ * @param stats Instrumentação.
+ * @param stage Etapa medida.
+ * @param mark Marca obtida com adfgvx_stats_start.
+ */
+void adfgvx_stats_stop(adfgvx_stats *stats, adfgvx_stage stage, const adfgvx_stats_mark *mark)
+{
+  adfgvx_stats_mark now;
+
+  adfgvx_stats_start(&now);
+  stats->seconds[stage] += now.seconds - mark->seconds;
+  stats->cycles[stage] += now.cycles - mark->cycles;
+  stats->calls[stage]++;
+}
+
+/**
+ * @brief Informa a soma dos buffers em uso no momento; guarda o maior valor informado.
+ *
+ * @param stats Instrumentação.
+ * @param bytes Bytes de buffers em uso.
+ */
+void adfgvx_stats_buffer(adfgvx_stats *stats, size_t bytes)
+{
+  if (bytes > stats->peak_buffer_bytes)
+    stats->peak_buffer_bytes = bytes;
+}
+
+// Padrão escrito na região de pilha preenchida por adfgvx_stats_stack_paint
+#define STACK_PAINT_BYTE 0xA5
+
+/**
+ * @brief Preenche com um padrão os ADFGVX_STACK_PAINT_SIZE bytes de pilha abaixo do chamador e guarda
+ * o endereço da região em stats->stack_region.
+ *
+ * As funções chamadas depois, pelo mesmo chamador, sobrescrevem o padrão até a profundidade que
+ * usarem; adfgvx_stats_stack_peak procura o byte mais fundo sobrescrito. Mede só a thread atual, e
+ * threads diferentes podem medir ao mesmo tempo com adfgvx_stats próprios. A pilha da thread precisa
+ * ter ADFGVX_STACK_PAINT_SIZE bytes livres abaixo do chamador (ver adfgvx.h).
+ *
+ * @param stats Instrumentação que recebe a região.
+ */
+__attribute__((noinline)) void adfgvx_stats_stack_paint(adfgvx_stats *stats)
+{
+  volatile unsigned char region[ADFGVX_STACK_PAINT_SIZE];
+
+  for (size_t i = 0; i < sizeof(region); i++)
+    region[i] = STACK_PAINT_BYTE;
+
+  stats->stack_region = (size_t)(uintptr_t)region;
+}
+
+/**
+ * @brief Mede a maior profundidade de pilha usada desde adfgvx_stats_stack_paint(stats) (a partir do
+ * chamador de adfgvx_stats_stack_paint) e a guarda em stats->peak_stack_bytes.
+ *
+ * Precisa ser chamada pela mesma thread e antes de o chamador de adfgvx_stats_stack_paint retornar
+ * (a região fica abaixo do quadro dele).
+ *
+ * @param stats Instrumentação com a região preenchida.
+ * @return size_t Bytes de pilha usados, ou 0 se a pilha não foi preenchida.
+ */
+__attribute__((noinline)) size_t adfgvx_stats_stack_peak(adfgvx_stats *stats)
+{
+  const volatile unsigned char *region = (const volatile unsigned char *)(uintptr_t)stats->stack_region;
+  size_t untouched = 0;
+
+  if (region == NULL)
+  {
+    return 0;
+  }
+
+  // A pilha cresce para endereços menores: o primeiro byte alterado a partir do fim mais baixo é o mais fundo
+  while (untouched < ADFGVX_STACK_PAINT_SIZE && region[untouched] == STACK_PAINT_BYTE)
+    untouched++;
+
+  size_t used = ADFGVX_STACK_PAINT_SIZE - untouched;
+  if (used > stats->peak_stack_bytes)
+    stats->peak_stack_bytes = used;
+  return used;
+}
+
+/**
+ * @brief Estado compartilhado da busca de chaves: símbolos do crib por coluna, tarefas e candidatos.
+ */
+typedef struct
+{
+  const char *ciphertext;
+  int key_length;
+  int max_mismatches;
+  size_t column_length[ADFGVX_SEARCH_MAX_KEY];
+  int crib_first[ADFGVX_SEARCH_MAX_KEY + 1]; // Símbolos do crib da coluna c: [crib_first[c], crib_first[c + 1])
+  size_t crib_row[2 * ADFGVX_SEARCH_MAX_CRIB];
+  char crib_symbol[2 * ADFGVX_SEARCH_MAX_CRIB];
+  double remaining[ADFGVX_SEARCH_MAX_KEY + 1]; // remaining[d]: permutações abaixo de um prefixo de d colunas, (k - d)!
+  int prefix_depth;                            // Colunas fixadas por tarefa (a divisão entre as threads)
+  int task_count;
+  int next_task;
+  adfgvx_key_candidate *candidates;
+  int candidate_capacity;
+  int candidate_count;
+  pthread_mutex_t lock; // Protege next_task, candidates e candidate_count
+} key_search;
+
+/**
+ * @brief Thread da busca de chaves: contadores próprios e o prefixo da permutação em construção.
+ */
+typedef struct
+{
+  key_search *search;
+  adfgvx_key_search_stats stats;
+  int order[ADFGVX_SEARCH_MAX_KEY];
+  int used[ADFGVX_SEARCH_MAX_KEY];
+} key_search_worker;
+
+// Símbolos do crib da coluna `column` que não conferem se ela começar em `offset` no texto cifrado
+static int key_search_column_mismatches(const key_search *search, int column, size_t offset, int budget)
+{
+  int mismatches = 0;
+
+  for (int i = search->crib_first[column]; i < search->crib_first[column + 1] && mismatches <= budget; i++)
+  {
+    mismatches += search->ciphertext[offset + search->crib_row[i]] != search->crib_symbol[i];
+  }
+  return mismatches;
+}
+
+// Guarda uma permutação completa aceita
+static void key_search_accept(key_search_worker *worker, int mismatches)
+{
+  key_search *search = worker->search;
+
+  worker->stats.matches++;
+  pthread_mutex_lock(&search->lock);
+  if (search->candidate_count < search->candidate_capacity)
+  {
+    adfgvx_key_candidate *candidate = &search->candidates[search->candidate_count];
+    memcpy(candidate->order, worker->order, sizeof(int) * search->key_length);
+    candidate->mismatches = mismatches;
+  }
+  search->candidate_count++;
+  pthread_mutex_unlock(&search->lock);
+}
+
+/**
+ * @brief Estende o prefixo de `depth` colunas (que ocupa o texto cifrado até `offset`) com cada coluna
+ * ainda livre, descartando a extensão assim que os símbolos do crib daquela coluna não conferirem.
+ *
+ * O tamanho de cada coluna (curta ou longa) fixa onde a próxima começa, então cada coluna é conferida
+ * uma única vez, no momento em que entra no prefixo, sem decifrar nada.
+ */
+static void key_search_extend(key_search_worker *worker, int depth, size_t offset, int mismatches)
+{
+  const key_search *search = worker->search;
+
+  if (depth == search->key_length)
+  {
+    worker->stats.permutations += 1;
+    key_search_accept(worker, mismatches);
+    return;
+  }
+
+  for (int column = 0; column < search->key_length; column++)
+  {
+    if (worker->used[column])
+      continue;
+
+    int budget = search->max_mismatches - mismatches;
+    int column_mismatches = key_search_column_mismatches(search, column, offset, budget);
+
+    worker->stats.nodes++;
+    if (column_mismatches > budget)
+    {
+      worker->stats.permutations += search->remaining[depth + 1];
+      continue;
+    }
+
+    worker->order[depth] = column;
+    worker->used[column] = 1;
+    key_search_extend(worker, depth + 1, offset + search->column_length[column], mismatches + column_mismatches);
+    worker->used[column] = 0;
+  }
+}
+
+/**
+ * @brief Thread da busca: pega o próximo prefixo de prefix_depth colunas e procura abaixo dele.
+ *
+ * A tarefa t é decodificada em base mista (k, k - 1, ...): cada dígito escolhe uma coluna entre as
+ * que ainda não estão no prefixo, então toda tarefa é um prefixo válido e distinto. Se uma coluna do
+ * prefixo já não confere, todas as permutações da tarefa são descartadas de uma vez.
+ */
+static void *key_search_worker_main(void *arg)
+{
+  key_search_worker *worker = arg;
+  key_search *search = worker->search;
+
+  for (;;)
+  {
+    pthread_mutex_lock(&search->lock);
+    int task = search->next_task++;
+    pthread_mutex_unlock(&search->lock);
+    if (task >= search->task_count)
+      break;
+
+    int mismatches = 0, depth = 0, choices = search->task_count;
+    size_t offset = 0;
+
+    memset(worker->used, 0, sizeof(worker->used));
+    for (; depth < search->prefix_depth; depth++)
+    {
+      choices /= search->key_length - depth;
+      int pick = task / choices, column = 0;
+      task %= choices;
+
+      // pick-ésima coluna ainda livre
+      for (int seen = 0; worker->used[column] || seen++ < pick; column++)
+        ;
+
+      int budget = search->max_mismatches - mismatches;
+      int column_mismatches = key_search_column_mismatches(search, column, offset, budget);
+
+      worker->stats.nodes++;
+      if (column_mismatches > budget)
+        break;
+
+      worker->order[depth] = column;
+      worker->used[column] = 1;
+      mismatches += column_mismatches;
+      offset += search->column_length[column];
+    }
+
+    if (depth < search->prefix_depth)
+      worker->stats.permutations += search->remaining[search->prefix_depth];
+    else
+      key_search_extend(worker, depth, offset, mismatches);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Procura as ordens de colunas compatíveis com um trecho conhecido da mensagem (crib).
+ *
+ * Para cada permutação das key_length colunas, o tamanho de cada coluna (symbol_count / key_length,
+ * mais um para as primeiras symbol_count % key_length colunas originais) fixa onde cada coluna começa
+ * no texto cifrado, e com isso onde estão os símbolos do crib. As permutações são construídas coluna
+ * a coluna e cada coluna só é conferida contra os símbolos do crib que caem nela; um prefixo com mais
+ * de max_mismatches símbolos diferentes é descartado junto com todas as suas extensões, sem decifrar
+ * nada. O trabalho é dividido entre as threads por prefixo (as primeiras colunas da permutação).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria) usada para codificar o crib.
+ * @param ciphertext Texto cifrado.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param key_length Comprimento da chave procurada (2 a ADFGVX_SEARCH_MAX_KEY).
+ * @param crib Trecho conhecido da mensagem, só com caracteres da matriz (no máximo ADFGVX_SEARCH_MAX_CRIB).
+ * @param crib_length Quantidade de caracteres do crib.
+ * @param crib_offset Posição do crib na mensagem, em caracteres válidos.
+ * @param max_mismatches Quantidade de símbolos do crib que podem não conferir (0 para coincidência exata).
+ * @param thread_count Quantidade de threads.
+ * @param candidates Vetor de saída com as ordens aceitas (as primeiras candidate_capacity).
+ * @param candidate_capacity Tamanho de candidates.
+ * @param stats Contadores da busca (saída, pode ser NULL).
+ * @return int Quantidade de ordens aceitas (pode passar de candidate_capacity), ou -1 se os parâmetros forem inválidos.
+ */
+int adfgvx_key_search(const polybius_square *polybius, const char ciphertext[], size_t symbol_count, int key_length,
+                      const char crib[], size_t crib_length, size_t crib_offset, int max_mismatches, int thread_count,
+                      adfgvx_key_candidate candidates[], int candidate_capacity, adfgvx_key_search_stats *stats)
+{
+  key_search search = {.ciphertext = ciphertext, .key_length = key_length, .max_mismatches = max_mismatches,
+                       .candidates = candidates, .candidate_capacity = candidate_capacity};
+  key_search_worker workers[ADFGVX_MAX_THREADS];
+  pthread_t threads[ADFGVX_MAX_THREADS];
+  int started[ADFGVX_MAX_THREADS] = {0};
+
+  if (key_length < 2 || key_length > ADFGVX_SEARCH_MAX_KEY || crib_length == 0 || crib_length > ADFGVX_SEARCH_MAX_CRIB ||
+      2 * (crib_offset + crib_length) > symbol_count || max_mismatches < 0 || thread_count < 1)
+  {
+    return -1;
+  }
+  if (thread_count > ADFGVX_MAX_THREADS)
+    thread_count = ADFGVX_MAX_THREADS;
+
+  // Tamanho de cada coluna original
+  for (int c = 0; c < key_length; c++)
+    search.column_length[c] = symbol_count / key_length + ((size_t)c < symbol_count % key_length);
+
+  // Símbolos do crib agrupados por coluna: o símbolo linear j fica na coluna j % k, linha j / k
+  size_t first_symbol = 2 * crib_offset, last_symbol = 2 * (crib_offset + crib_length);
+  int count = 0;
+  for (int c = 0; c < key_length; c++)
+  {
+    search.crib_first[c] = count;
+    for (size_t j = first_symbol + (c - first_symbol % key_length + key_length) % key_length; j < last_symbol; j += key_length)
+    {
+      unsigned short pair = polybius->forward[(unsigned char)crib[(j - first_symbol) / 2]];
+      if (!(pair & POLYBIUS_VALID))
+        return -1;
+
+      search.crib_row[count] = j / key_length;
+      search.crib_symbol[count++] = j % 2 == 0 ? POLYBIUS_ROW(pair) : POLYBIUS_COL(pair);
+    }
+  }
+  search.crib_first[key_length] = count;
+
+  search.remaining[key_length] = 1;
+  for (int d = key_length - 1; d >= 0; d--)
+    search.remaining[d] = search.remaining[d + 1] * (key_length - d);
+
+  // Prefixos de duas colunas (ou três, com muitas threads) dividem o trabalho em k(k-1)... tarefas
+  search.prefix_depth = key_length > 3 && thread_count > key_length ? 3 : 2;
+  search.task_count = 1;
+  for (int d = 0; d < search.prefix_depth; d++)
+    search.task_count *= key_length - d;
+  if (thread_count > search.task_count)
+    thread_count = search.task_count;
+
+  pthread_mutex_init(&search.lock, NULL);
+  for (int t = 0; t < thread_count; t++)
+  {
+    workers[t] = (key_search_worker){.search = &search};
+    if (t > 0)
+      started[t] = pthread_create(&threads[t], NULL, key_search_worker_main, &workers[t]) == 0;
+  }
+
+  // A thread atual também procura; se alguma thread não puder ser criada, as outras levam as tarefas dela
+  key_search_worker_main(&workers[0]);
+  for (int t = 1; t < thread_count; t++)
+  {
+    if (started[t])
+      pthread_join(threads[t], NULL);
+  }
+  pthread_mutex_destroy(&search.lock);
+
+  if (stats != NULL)
+  {
+    *stats = (adfgvx_key_search_stats){0};
+    for (int t = 0; t < thread_count; t++)
+    {
+      stats->nodes += workers[t].stats.nodes;
+      stats->permutations += workers[t].stats.permutations;
+      stats->matches += workers[t].stats.matches;
+      stats->thread_count += t == 0 || started[t];
+    }
+  }
+  return search.candidate_count;
+}
+
+/**
+ * @brief Visão da matriz que produz índices de símbolo (0 a 5) no lugar das letras ADFGVX.
+ *
+ * Troca as tabelas forward, row_symbols e col_symbols pelas versões com índices; como os kernels de
+ * codificação e os caminhos de escrita direta só consultam essas tabelas, qualquer um deles (por exemplo
+ * cipher_adfgvx_ordered ou kernel->encode) chamado com a visão produz índices, sem código novo. A
+ * transposição não depende do valor dos símbolos. Para decodificar, use decipher_adfgvx_indices ou
+ * kernel->decode_indices, e symbols_from_indices para converter em letras na saída.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param view Visão com índices (saída); aponta para as tabelas de polybius.
+ */
+void polybius_square_index_view(const polybius_square *polybius, polybius_square *view)
+{
+  *view = *polybius;
+  view->forward = polybius->forward_indices;
+  view->row_symbols = polybius->row_indices;
+  view->col_symbols = polybius->col_indices;
+}
+
+/**
+ * @brief Converte índices de símbolo (0 a 5) nas letras ADFGVX, na fronteira de saída (pode ser no lugar).
+ *
+ * @param indices Índices de símbolo, todos entre 0 e 5.
+ * @param count Quantidade de índices.
+ * @param symbols_out Buffer com pelo menos count posições (pode ser o próprio indices).
+ */
+void symbols_from_indices(const char indices[], size_t count, char symbols_out[])
+{
+  for (size_t i = 0; i < count; i++)
+    symbols_out[i] = symbols[(unsigned char)indices[i]];
+}
+
+/**
+ * @brief Converte letras ADFGVX em índices de símbolo (pode ser no lugar); símbolos inválidos viram 255.
+ *
+ * @param symbols_in Símbolos ADFGVX.
+ * @param count Quantidade de símbolos.
+ * @param indices Buffer com pelo menos count posições (pode ser o próprio symbols_in).
+ */
+void indices_from_symbols(const char symbols_in[], size_t count, char indices[])
+{
+  for (size_t i = 0; i < count; i++)
+    indices[i] = (char)(symbol_rank[(unsigned char)symbols_in[i]] - 1);
+}
+
+/**
+ * @brief Decifra um texto cifrado em índices de símbolo (ver polybius_square_index_view).
+ *
+ * Mesmo percurso de decipher_adfgvx_ordered, sem a conversão das letras: com chaves curtas os pares são
+ * lidos direto das colunas e o caractere é cells[6 * linha + coluna]; com BLOCKED_KEY_LENGTH colunas ou
+ * mais, são reagrupados em janelas com scatter_columns e decodificados com kernel->decode_indices. Pares
+ * com algum índice acima de 5 são descartados e um símbolo final sem par é ignorado.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria; não a visão).
+ * @param order Ordem das colunas (ver compute_column_order ou adfgvx_key_schedule).
+ * @param key_length Comprimento da chave.
+ * @param indices Texto cifrado em índices de símbolo.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída com pelo menos symbol_count / 2 + 1 posições.
+ * @return size_t Quantidade de caracteres escritos em output (terminado em '\0').
+ */
+size_t decipher_adfgvx_indices(const polybius_square *polybius, const int order[], int key_length, const char indices[], size_t symbol_count, char output[])
+{
+  size_t column_start[key_length], length = 0;
+
+  compute_column_offsets(key_length, order, symbol_count, column_start);
+
+  if (key_length < BLOCKED_KEY_LENGTH)
+  {
+    const char *cells = polybius->cells;
+    int col_index = 0;
+
+    for (size_t i = 0; i + 1 < symbol_count; i += 2)
+    {
+      unsigned char row = indices[column_start[col_index]++];
+      if (++col_index == key_length)
+        col_index = 0;
+
+      unsigned char col = indices[column_start[col_index]++];
+      if (++col_index == key_length)
+        col_index = 0;
+
+      char c = row < 6 && col < 6 ? cells[6 * row + col] : '\0';
+      output[length] = c;
+      length += c != '\0';
+    }
+  }
+  else
+  {
+    const polybius_kernel *kernel = polybius_select_kernel();
+    char window[BLOCKED_WINDOW_SYMBOLS];
+
+    for (size_t first = 0; first + 1 < symbol_count; first += BLOCKED_WINDOW_SYMBOLS)
+    {
+      size_t window_count = symbol_count - first < BLOCKED_WINDOW_SYMBOLS ? (symbol_count - first) & ~(size_t)1 : BLOCKED_WINDOW_SYMBOLS;
+
+      scatter_columns(indices, first, window_count, key_length, column_start, window);
+      length += kernel->decode_indices(polybius, window, window_count / 2, output + length);
+    }
+  }
+
+  output[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief Tamanho em bytes do formato compactado (cabeçalho e um byte por par de símbolos).
+ *
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @return size_t Tamanho em bytes.
+ */
+size_t adfgvx_packed_size(size_t symbol_count)
+{
+  return ADFGVX_PACKED_HEADER_SIZE + (symbol_count + 1) / 2;
+}
+
+/**
+ * @brief Escreve o cabeçalho do formato compactado.
+ *
+ * @param header Buffer com pelo menos ADFGVX_PACKED_HEADER_SIZE bytes.
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param format_version Versão do formato (ADFGVX_PACKED_VERSION); não depende da chave nem da matriz.
+ */
+void adfgvx_packed_write_header(unsigned char header[], size_t symbol_count, unsigned int format_version)
+{
+  memcpy(header, ADFGVX_PACKED_MAGIC, 4);
+  for (int i = 0; i < 8; i++)
+    header[4 + i] = (unsigned char)((unsigned long long)symbol_count >> (56 - 8 * i));
+  for (int i = 0; i < 4; i++)
+    header[12 + i] = (unsigned char)(format_version >> (24 - 8 * i));
+}
+
+/**
+ * @brief Lê e valida o cabeçalho do formato compactado.
+ *
+ * @param packed Dados compactados, a partir do cabeçalho.
+ * @param packed_size Quantidade de bytes disponíveis em packed.
+ * @param symbol_count Quantidade de símbolos do texto cifrado (saída).
+ * @param format_version Versão do formato gravada na cifragem (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se não for o formato compactado ou se os dados estiverem truncados.
+ */
+int adfgvx_packed_read_header(const unsigned char packed[], size_t packed_size, size_t *symbol_count, unsigned int *format_version)
+{
+  unsigned long long count = 0;
+  unsigned int version = 0;
+
+  if (packed_size < ADFGVX_PACKED_HEADER_SIZE || memcmp(packed, ADFGVX_PACKED_MAGIC, 4) != 0)
+  {
+    return 1;
+  }
+
+  for (int i = 0; i < 8; i++)
+    count = (count << 8) | packed[4 + i];
+  for (int i = 0; i < 4; i++)
+    version = (version << 8) | packed[12 + i];
+
+  if (count > (unsigned long long)(packed_size - ADFGVX_PACKED_HEADER_SIZE) * 2)
+  {
+    return 1;
+  }
+
+  *symbol_count = (size_t)count;
+  if (format_version != NULL)
+    *format_version = version;
+  return 0;
+}
+
+/**
+ * @brief Cifra uma mensagem direto no formato compactado, sem passar pelo texto cifrado em letras.
+ *
+ * Como em scatter_symbols, cada símbolo vai direto para a sua posição final p (cursor da sua coluna).
+ * As posições de uma coluna são consecutivas, então cada coluna monta os seus bytes sozinha: guarda
+ * 6 * a na posição par e grava o byte inteiro na ímpar, sem ler a saída. Só o byte dividido entre o
+ * fim de uma coluna e o início da seguinte é completado no final.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param order Ordem das colunas (ver compute_column_order ou adfgvx_key_schedule).
+ * @param key_length Comprimento da chave.
+ * @param message Mensagem de entrada; bytes fora da matriz são ignorados.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param symbol_count Quantidade de símbolos (2 por caractere válido da mensagem).
+ * @param packed Buffer com pelo menos (symbol_count + 1) / 2 posições (sem o cabeçalho).
+ */
+void cipher_adfgvx_packed(const polybius_square *polybius, const int order[], int key_length, const char message[], size_t message_length, size_t symbol_count, unsigned char packed[])
+{
+  const unsigned short *forward = polybius->forward_indices; // Índices direto da tabela, sem passar pelas letras
+  size_t column_start[key_length], cursor[key_length];
+  unsigned char pending[key_length]; // 6 * a do byte em andamento de cada coluna (0 se a coluna começa em posição ímpar)
+  int col_index = 0;
+
+  compute_column_offsets(key_length, order, symbol_count, column_start);
+  for (int c = 0; c < key_length; c++)
+  {
+    cursor[c] = column_start[c];
+    pending[c] = 0;
+  }
+
+  for (size_t i = 0; i < message_length; i++)
+  {
+    unsigned short pair = forward[(unsigned char)message[i]];
+    if (!(pair & POLYBIUS_VALID))
+      continue;
+
+    for (int h = 0; h < 2; h++)
+    {
+      size_t position = cursor[col_index]++;
+      unsigned char index = h == 0 ? POLYBIUS_ROW(pair) : POLYBIUS_COL(pair);
+
+      // Posição par: só guarda 6 * a; posição ímpar: grava o byte inteiro, sem ler a saída
+      if (position & 1)
+        packed[position >> 1] = pending[col_index] + index;
+      else
+        pending[col_index] = 6 * index;
+      if (++col_index == key_length)
+        col_index = 0;
+    }
+  }
+
+  // Uma coluna que termina em posição par divide o último byte com a coluna seguinte, que o gravou
+  // só com a sua parte (ou com nada, no último byte do texto cifrado)
+  for (int c = 0; c < key_length; c++)
+  {
+    size_t last = cursor[c] - 1;
+
+    if (cursor[c] > column_start[c] && (last & 1) == 0)
+    {
+      if (last + 1 < symbol_count)
+        packed[last >> 1] += pending[c];
+      else
+        packed[last >> 1] = pending[c];
+    }
+  }
+}
+
+// Posto (1 a 6, como symbol_rank) da linha e da coluna de cada byte compactado válido
+static const unsigned char packed_row_rank[POLYBIUS_CELLS] = {1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3,
+                                                              4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6};
+static const unsigned char packed_col_rank[POLYBIUS_CELLS] = {1, 2, 3, 4, 5, 6, 1, 2, 3, 4, 5, 6, 1, 2, 3, 4, 5, 6,
+                                                              1, 2, 3, 4, 5, 6, 1, 2, 3, 4, 5, 6, 1, 2, 3, 4, 5, 6};
+
+// Posto (1 a 6, como symbol_rank) do símbolo na posição `position` do texto compactado, 0 se o byte for inválido
+static inline unsigned char packed_symbol_rank(const unsigned char packed[], size_t position)
+{
+  unsigned char v = packed[position >> 1];
+
+  if (v >= POLYBIUS_CELLS)
+    return 0;
+  return position & 1 ? packed_col_rank[v] : packed_row_rank[v];
+}
+
+/**
+ * @brief Decifra o formato compactado lendo cada símbolo direto do seu byte, sem descompactar antes.
+ *
+ * Mesmo percurso de gather_decode_symbols (pares reagrupados linha a linha a partir do início de
+ * cada coluna), com o índice de cada símbolo tirado do byte compactado em vez da letra. Pares com
+ * algum byte inválido são descartados e um símbolo final sem par é ignorado.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param order Ordem das colunas (ver compute_column_order ou adfgvx_key_schedule).
+ * @param key_length Comprimento da chave.
+ * @param packed Bytes compactados (sem o cabeçalho).
+ * @param symbol_count Quantidade de símbolos do texto cifrado.
+ * @param output Buffer de saída com pelo menos symbol_count / 2 + 1 posições.
+ * @return size_t Quantidade de caracteres escritos em output (terminado em '\0').
+ */
+size_t decipher_adfgvx_packed(const polybius_square *polybius, const int order[], int key_length, const unsigned char packed[], size_t symbol_count, char output[])
+{
+  const char(*reverse)[7] = polybius->reverse;
+  size_t cursor[key_length], length = 0;
+  int col_index = 0;
+
+  compute_column_offsets(key_length, order, symbol_count, cursor);
+
+  for (size_t i = 0; i + 1 < symbol_count; i += 2)
+  {
+    unsigned char row = packed_symbol_rank(packed, cursor[col_index]++);
+    if (++col_index == key_length)
+      col_index = 0;
+
+    unsigned char col = packed_symbol_rank(packed, cursor[col_index]++);
+    if (++col_index == key_length)
+      col_index = 0;
+
+    char c = reverse[row][col];
+    output[length] = c;
+    length += c != '\0';
+  }
+
+  output[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief Cifra uma mensagem em memória no formato compactado (cabeçalho e um byte por par de símbolos).
+ *
+ * O cabeçalho leva só a versão do formato (ADFGVX_PACKED_VERSION), nada derivado da chave.
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile.
+ * @param message Mensagem de entrada (não precisa terminar em '\0'); bytes fora da matriz são ignorados.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer do formato compactado.
+ * @param output_capacity Tamanho de output; precisa comportar adfgvx_packed_size(símbolos) bytes.
+ * @param output_length Quantidade de bytes escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se output for pequeno demais.
+ */
+int adfgvx_encrypt_packed(const adfgvx_key_schedule *schedule, const char message[], size_t message_length, unsigned char output[], size_t output_capacity, size_t *output_length)
+{
+  size_t symbol_count = 2 * polybius_count_valid(&schedule->polybius, message, message_length);
+
+  if (adfgvx_packed_size(symbol_count) > output_capacity)
+  {
+    return 1;
+  }
+
+  adfgvx_packed_write_header(output, symbol_count, ADFGVX_PACKED_VERSION);
+  cipher_adfgvx_packed(&schedule->polybius, schedule->order, schedule->key_length, message, message_length, symbol_count,
+                       output + ADFGVX_PACKED_HEADER_SIZE);
+  if (output_length != NULL)
+    *output_length = adfgvx_packed_size(symbol_count);
+  return 0;
+}
+
+/**
+ * @brief Decifra o formato compactado em memória, conferindo o cabeçalho e a versão do formato.
+ *
+ * O formato não guarda nada que identifique a chave (para não permitir testar chaves offline), então
+ * uma chave ou matriz diferente da cifragem não é detectada: produz uma mensagem sem sentido.
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile (o mesmo da cifragem).
+ * @param packed Dados compactados, a partir do cabeçalho.
+ * @param packed_size Quantidade de bytes de packed.
+ * @param output Buffer da mensagem decifrada.
+ * @param output_capacity Tamanho de output; precisa comportar symbol_count / 2 caracteres e o '\0' final.
+ * @param output_length Quantidade de caracteres escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se o cabeçalho for inválido, a versão for outra ou output for pequeno demais.
+ */
+int adfgvx_decrypt_packed(const adfgvx_key_schedule *schedule, const unsigned char packed[], size_t packed_size, char output[], size_t output_capacity, size_t *output_length)
+{
+  size_t symbol_count;
+  unsigned int format_version;
+
+  if (adfgvx_packed_read_header(packed, packed_size, &symbol_count, &format_version) != 0 || format_version != ADFGVX_PACKED_VERSION ||
+      symbol_count / 2 >= output_capacity)
+  {
+    return 1;
+  }
+
+  size_t length = decipher_adfgvx_packed(&schedule->polybius, schedule->order, schedule->key_length, packed + ADFGVX_PACKED_HEADER_SIZE,
+                                         symbol_count, output);
+  if (output_length != NULL)
+    *output_length = length;
+  return 0;
+}
+
+/**
+ * @brief Escreve o cabeçalho de um bloco do formato do modo stream.
+ *
+ * @param header Buffer com pelo menos ADFGVX_STREAM_HEADER_SIZE bytes.
+ * @param symbol_count Quantidade de símbolos do bloco (menor que 2^32).
+ */
+void adfgvx_stream_write_header(unsigned char header[], size_t symbol_count)
+{
+  for (int i = 0; i < ADFGVX_STREAM_HEADER_SIZE; i++)
+    header[i] = (unsigned char)(symbol_count >> (24 - 8 * i));
+}
+
+/**
+ * @brief Confere se os dados são uma sequência de blocos do formato do modo stream que ocupa todo o buffer.
+ *
+ * Cada bloco precisa ter pelo menos um símbolo e só símbolos ADFGVX. O primeiro byte de um bloco é o
+ * mais significativo da contagem, então um texto cifrado em letras nunca é confundido com o formato.
+ *
+ * @param data Dados a conferir.
+ * @param size Quantidade de bytes de data.
+ * @param symbol_count Soma dos símbolos de todos os blocos (saída, pode ser NULL).
+ * @return int 0 se os dados estão no formato do modo stream, 1 caso contrário.
+ */
+int adfgvx_stream_check(const char data[], size_t size, size_t *symbol_count)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  size_t position = 0, total = 0;
+
+  if (size == 0)
+  {
+    return 1;
+  }
+
+  while (position < size)
+  {
+    size_t count = 0;
+
+    if (size - position < ADFGVX_STREAM_HEADER_SIZE)
+      return 1;
+    for (int i = 0; i < ADFGVX_STREAM_HEADER_SIZE; i++)
+      count = (count << 8) | bytes[position++];
+    if (count == 0 || count > size - position)
+      return 1;
+    for (size_t i = 0; i < count; i++)
+    {
+      if (symbol_rank[bytes[position + i]] == 0)
+        return 1;
+    }
+    position += count;
+    total += count;
+  }
+
+  if (symbol_count != NULL)
+    *symbol_count = total;
+  return 0;
+}
+
+/**
+ * @brief Decifra em memória os blocos do formato do modo stream, cada um como uma mensagem independente
+ * (como foram cifrados), concatenando as mensagens.
+ *
+ * @param schedule Escalonamento compilado com adfgvx_key_schedule_compile (o mesmo da cifragem).
+ * @param data Blocos do modo stream, a partir do primeiro cabeçalho.
+ * @param size Quantidade de bytes de data.
+ * @param output Buffer da mensagem decifrada.
+ * @param output_capacity Tamanho de output; size / 2 + 1 bytes sempre bastam.
+ * @param output_length Quantidade de caracteres escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se os dados não estiverem no formato ou output for pequeno demais.
+ */
+int adfgvx_decrypt_stream(const adfgvx_key_schedule *schedule, const char data[], size_t size, char output[], size_t output_capacity, size_t *output_length)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  size_t position = 0, length = 0, symbol_count;
+
+  if (adfgvx_stream_check(data, size, &symbol_count) != 0 || symbol_count / 2 >= output_capacity)
+  {
+    return 1;
+  }
+
+  while (position < size)
+  {
+    size_t count = 0;
+
+    for (int i = 0; i < ADFGVX_STREAM_HEADER_SIZE; i++)
+      count = (count << 8) | bytes[position++];
+    length += decipher_adfgvx_ordered(&schedule->polybius, schedule->order, schedule->key_length, data + position, count, output + length);
+    position += count;
+  }
+
+  if (output_length != NULL)
+    *output_length = length;
+  return 0;
+}
+
+/**
+ * @brief Calcula quantos bytes de arena um adfgvx_appender precisa.
+ *
+ * @param key_length Comprimento da chave.
+ * @param symbol_capacity Quantidade máxima de símbolos da mensagem inteira (2 por caractere válido).
+ * @return size_t Tamanho da arena em bytes.
+ */
+size_t adfgvx_appender_arena_size(int key_length, size_t symbol_capacity)
+{
+  size_t column_capacity = (symbol_capacity + key_length - 1) / key_length;
+  size_t size = 0;
+
+  size += column_capacity * key_length + ARENA_ALIGNMENT;         // columns
+  size += 2 * (sizeof(size_t) * key_length + ARENA_ALIGNMENT);    // symbols_per_column e flushed
+  size += 2 * APPENDER_BLOCK_SIZE + ARENA_ALIGNMENT;              // symbols
+  return size;
+}
+
+/**
+ * @brief Inicializa uma cifragem incremental vazia, com todos os buffers reservados na arena.
+ *
+ * @param appender Cifragem incremental a ser inicializada.
+ * @param arena Arena com pelo menos adfgvx_appender_arena_size(key_length, symbol_capacity) bytes livres.
+ * @param schedule Escalonamento compilado da chave (precisa continuar válido enquanto o appender for usado).
+ * @param symbol_capacity Quantidade máxima de símbolos da mensagem inteira.
+ * @return int 0 em caso de sucesso, 1 se os parâmetros forem inválidos ou a arena não tiver espaço suficiente.
+ */
+int adfgvx_appender_init(adfgvx_appender *appender, adfgvx_arena *arena, const adfgvx_key_schedule *schedule, size_t symbol_capacity)
+{
+  int k = schedule->key_length;
+
+  if (k <= 0)
+  {
+    return 1;
+  }
+
+  appender->schedule = schedule;
+  appender->kernel = polybius_select_kernel();
+  appender->symbol_capacity = symbol_capacity;
+  appender->column_capacity = (symbol_capacity + k - 1) / k;
+  appender->columns = adfgvx_arena_alloc(arena, appender->column_capacity * k);
+  appender->symbols_per_column = adfgvx_arena_alloc(arena, sizeof(size_t) * k);
+  appender->flushed = adfgvx_arena_alloc(arena, sizeof(size_t) * k);
+  appender->symbols = adfgvx_arena_alloc(arena, 2 * APPENDER_BLOCK_SIZE);
+
+  if (appender->columns == NULL || appender->symbols_per_column == NULL || appender->flushed == NULL || appender->symbols == NULL)
+  {
+    return 1;
+  }
+
+  adfgvx_appender_reset(appender);
+  return 0;
+}
+
+/**
+ * @brief Volta a cifragem incremental para a mensagem vazia, sem realocar os buffers.
+ *
+ * @param appender Cifragem incremental inicializada com adfgvx_appender_init.
+ */
+void adfgvx_appender_reset(adfgvx_appender *appender)
+{
+  int k = appender->schedule->key_length;
+
+  memset(appender->symbols_per_column, 0, sizeof(size_t) * k);
+  memset(appender->flushed, 0, sizeof(size_t) * k);
+  appender->symbol_count = 0;
+  appender->next_column = 0;
+}
+
+/**
+ * @brief Acrescenta texto ao fim da mensagem, codificando só o texto novo.
+ *
+ * O texto é codificado em blocos de APPENDER_BLOCK_SIZE caracteres com o kernel da CPU e cada símbolo
+ * vai para o fim da coluna seguinte, continuando de onde o acréscimo anterior parou: o custo é
+ * proporcional a length, não ao tamanho da mensagem inteira.
+ *
+ * @param appender Cifragem incremental inicializada com adfgvx_appender_init.
+ * @param text Texto acrescentado (não precisa terminar em '\0'); bytes fora da matriz são ignorados.
+ * @param length Quantidade de bytes de text.
+ * @return int Quantidade de símbolos acrescentados, ou -1 se a mensagem passaria de symbol_capacity (nada é acrescentado).
+ */
+int adfgvx_appender_append(adfgvx_appender *appender, const char text[], size_t length)
+{
+  const polybius_square *polybius = &appender->schedule->polybius;
+  int k = appender->schedule->key_length;
+  size_t added = 2 * polybius_count_valid(polybius, text, length);
+
+  if (added > appender->symbol_capacity - appender->symbol_count)
+  {
+    return -1;
+  }
+
+  int column = appender->next_column;
+  for (size_t start = 0; start < length; start += APPENDER_BLOCK_SIZE)
+  {
+    int block = length - start < APPENDER_BLOCK_SIZE ? (int)(length - start) : APPENDER_BLOCK_SIZE;
+    int symbol_count = appender->kernel->encode(polybius, text + start, block, appender->symbols);
+
+    for (int i = 0; i < symbol_count; i++)
+    {
+      appender->columns[column * appender->column_capacity + appender->symbols_per_column[column]++] = appender->symbols[i];
+      if (++column == k)
+        column = 0;
+    }
+  }
+
+  appender->next_column = column;
+  appender->symbol_count += added;
+  return (int)added;
+}
+
+/**
+ * @brief Escreve o texto cifrado da mensagem inteira até agora (as colunas na ordem da chave).
+ *
+ * @param appender Cifragem incremental.
+ * @param output Buffer do texto cifrado.
+ * @param output_capacity Tamanho de output; precisa comportar os símbolos e o '\0' final.
+ * @param output_length Quantidade de símbolos escritos (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 se output for pequeno demais.
+ */
+int adfgvx_appender_ciphertext(const adfgvx_appender *appender, char output[], size_t output_capacity, size_t *output_length)
+{
+  const adfgvx_key_schedule *schedule = appender->schedule;
+  size_t position = 0;
+
+  if (appender->symbol_count >= output_capacity)
+  {
+    return 1;
+  }
+
+  for (int i = 0; i < schedule->key_length; i++)
+  {
+    int column = schedule->order[i];
+
+    memcpy(output + position, appender->columns + column * appender->column_capacity, appender->symbols_per_column[column]);
+    position += appender->symbols_per_column[column];
+  }
+
+  output[position] = '\0';
+  if (output_length != NULL)
+    *output_length = position;
+  return 0;
+}
+
+/**
+ * @brief Lista, na ordem do texto cifrado, os símbolos novos de cada coluna desde o último adfgvx_appender_commit.
+ *
+ * Cada acréscimo só aumenta o fim das colunas, então quem guarda o texto cifrado por coluna (ou o texto
+ * anterior) atualiza a sua cópia só com os segmentos. ciphertext_offset já considera o crescimento das
+ * colunas anteriores no texto cifrado atual.
+ *
+ * @param appender Cifragem incremental.
+ * @param segments Vetor de saída com pelo menos key_length posições.
+ * @return int Quantidade de segmentos (colunas que mudaram).
+ */
+int adfgvx_appender_changes(const adfgvx_appender *appender, adfgvx_column_segment segments[])
+{
+  const adfgvx_key_schedule *schedule = appender->schedule;
+  size_t position = 0;
+  int count = 0;
+
+  for (int i = 0; i < schedule->key_length; i++)
+  {
+    int column = schedule->order[i];
+    size_t flushed = appender->flushed[column], length = appender->symbols_per_column[column];
+
+    if (length > flushed)
+    {
+      segments[count++] = (adfgvx_column_segment){.column = column, .column_offset = flushed, .ciphertext_offset = position + flushed,
+                                                  .symbols = appender->columns + column * appender->column_capacity + flushed,
+                                                  .length = length - flushed};
+    }
+    position += length;
+  }
+  return count;
+}
+
+/**
+ * @brief Marca todos os símbolos atuais como entregues: o próximo adfgvx_appender_changes só lista os acréscimos seguintes.
+ *
+ * @param appender Cifragem incremental.
+ */
+void adfgvx_appender_commit(adfgvx_appender *appender)
+{
+  memcpy(appender->flushed, appender->symbols_per_column, sizeof(size_t) * appender->schedule->key_length);
+}
+
+/**
+ * @brief Tamanho da arena necessária para adfgvx_round_plan_init.
+ *
+ * @param symbol_capacity Quantidade máxima de símbolos do texto cifrado (2 por caractere válido).
+ * @return size_t Bytes necessários (8 por símbolo: o mapa composto e o de uma rodada).
+ */
+size_t adfgvx_round_plan_arena_size(size_t symbol_capacity)
+{
+  return 2 * (sizeof(unsigned int) * symbol_capacity + ARENA_ALIGNMENT);
+}
+
+/**
+ * @brief Inicializa um plano de rodadas vazio com memória vinda de uma arena.
+ *
+ * @param plan Plano a ser inicializado.
+ * @param arena Arena com pelo menos adfgvx_round_plan_arena_size(symbol_capacity) bytes livres.
+ * @param symbol_capacity Quantidade máxima de símbolos (no máximo UINT_MAX, posições de 32 bits).
+ * @return int 0 em caso de sucesso, 1 se a arena não tiver espaço ou a capacidade for grande demais.
+ */
+int adfgvx_round_plan_init(adfgvx_round_plan *plan, adfgvx_arena *arena, size_t symbol_capacity)
+{
+  if (symbol_capacity > UINT_MAX)
+  {
+    return 1;
+  }
+
+  plan->map = adfgvx_arena_alloc(arena, sizeof(unsigned int) * symbol_capacity);
+  plan->round_map = adfgvx_arena_alloc(arena, sizeof(unsigned int) * symbol_capacity);
+  plan->symbol_capacity = symbol_capacity;
+  plan->symbol_count = 0;
+  plan->rounds = 0;
+  return plan->map == NULL || plan->round_map == NULL;
+}
+
+/**
+ * @brief Compõe as permutações das rodadas em um único mapa, para um tamanho de texto cifrado conhecido.
+ *
+ * A rodada r leva a posição p para column_start[p % k] + p / k (a coluna de p na ordem da chave r,
+ * na linha p / k). Cada rodada é calculada em sequência, sem divisões, em round_map, e composta com o
+ * mapa acumulado (map[i] = round_map[map[i]]). O custo é O(symbol_count) por rodada, uma única vez por
+ * tamanho; cifrar e decifrar com o plano custa uma passada, com qualquer quantidade de rodadas.
+ *
+ * @param plan Plano inicializado com adfgvx_round_plan_init.
+ * @param schedules Escalonamentos das rodadas, na ordem de aplicação (a matriz Polybius não é usada aqui).
+ * @param rounds Quantidade de rodadas (pelo menos 1).
+ * @param symbol_count Quantidade de símbolos do texto cifrado (2 por caractere válido da mensagem).
+ * @return int 0 em caso de sucesso, 1 se symbol_count exceder a capacidade ou alguma chave estiver vazia.
+ */
+int adfgvx_round_plan_compile(adfgvx_round_plan *plan, const adfgvx_key_schedule *const schedules[], int rounds, size_t symbol_count)
+{
+  if (rounds < 1 || symbol_count > plan->symbol_capacity)
+  {
+    return 1;
+  }
+  for (int r = 0; r < rounds; r++)
+  {
+    if (schedules[r]->key_length <= 0)
+      return 1;
+  }
+
+  for (int r = 0; r < rounds; r++)
+  {
+    int k = schedules[r]->key_length;
+    size_t column_start[k];
+    unsigned int *positions = r == 0 ? plan->map : plan->round_map;
+    int col_index = 0;
+    size_t row = 0;
+
+    compute_column_offsets(k, schedules[r]->order, symbol_count, column_start);
+    for (size_t p = 0; p < symbol_count; p++)
+    {
+      positions[p] = (unsigned int)(column_start[col_index] + row);
+      if (++col_index == k)
+      {
+        col_index = 0;
+        row++;
+      }
+    }
+
+    if (r > 0)
+    {
+      for (size_t i = 0; i < symbol_count; i++)
+        plan->map[i] = plan->round_map[plan->map[i]];
+    }
+  }
+
+  plan->symbol_count = symbol_count;
+  plan->rounds = rounds;
+  return 0;
+}
+
+/**
+ * @brief Cifra uma mensagem com todas as rodadas do plano em uma única passada.
+ *
+ * Cada caractere válido vira o seu par de símbolos, escrito direto nas posições finais map[i] e
+ * map[i + 1]; não há texto intermediário entre as rodadas.
+ *
+ * @param plan Plano compilado com adfgvx_round_plan_compile.
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param message Mensagem; bytes fora da matriz são ignorados.
+ * @param message_length Quantidade de bytes da mensagem.
+ * @param output Buffer com pelo menos plan->symbol_count + 1 posições (terminado em '\0').
+ * @return int 0 em caso de sucesso, -1 se a mensagem não tiver exatamente plan->symbol_count / 2 caracteres válidos.
+ */
+int adfgvx_round_plan_encrypt(const adfgvx_round_plan *plan, const polybius_square *polybius, const char message[], size_t message_length, char output[])
+{
+  const unsigned short *forward = polybius->forward;
+  const unsigned int *map = plan->map;
+  size_t symbol_count = plan->symbol_count, position = 0;
+
+  for (size_t i = 0; i < message_length; i++)
+  {
+    unsigned short pair = forward[(unsigned char)message[i]];
+    if (!(pair & POLYBIUS_VALID))
+      continue;
+
+    if (position + 2 > symbol_count)
+    {
+      return -1;
+    }
+    output[map[position]] = POLYBIUS_ROW(pair);
+    output[map[position + 1]] = POLYBIUS_COL(pair);
+    position += 2;
+  }
+
+  if (position != symbol_count)
+  {
+    return -1;
+  }
+  output[symbol_count] = '\0';
+  return 0;
+}
+
+/**
+ * @brief Decifra um texto cifrado com todas as rodadas do plano em uma única passada (mapa inverso).
+ *
+ * O símbolo i da sequência Polybius está na posição map[i] do texto cifrado: cada par é lido direto de
+ * lá e convertido pela matriz. Pares com símbolos inválidos são descartados.
+ *
+ * @param plan Plano compilado com adfgvx_round_plan_compile.
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param ciphertext Texto cifrado com plan->symbol_count símbolos.
+ * @param output Buffer com pelo menos plan->symbol_count / 2 + 1 posições.
+ * @return size_t Quantidade de caracteres escritos em output (terminado em '\0').
+ */
+size_t adfgvx_round_plan_decrypt(const adfgvx_round_plan *plan, const polybius_square *polybius, const char ciphertext[], char output[])
+{
+  const char(*reverse)[7] = polybius->reverse;
+  const unsigned int *map = plan->map;
+  size_t length = 0;
+
+  for (size_t i = 0; i + 1 < plan->symbol_count; i += 2)
+  {
+    unsigned char row = ciphertext[map[i]], col = ciphertext[map[i + 1]];
+    char c = reverse[symbol_rank[row]][symbol_rank[col]];
+
+    output[length] = c;
+    length += c != '\0';
+  }
+
+  output[length] = '\0';
+  return length;
+}
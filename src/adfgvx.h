@@ -0,0 +1,349 @@
+/**
+ * Biblioteca: Cifra ADFGVX
+ *
+ * Licença: MIT License.
+ *
+ * Interface pública da biblioteca usada pelo programa cipher_adfgvx, pelos testes e por quem quiser
+ * cifrar dentro do próprio processo, sem fork/exec e sem E/S de arquivos.
+ *
+ * Como usar:
+ * - Estática: gcc -O2 -pthread -c adfgvx.c -o adfgvx.o && ar rcs libadfgvx.a adfgvx.o
+ * - Compartilhada: gcc -O2 -pthread -shared -fPIC adfgvx.c -o libadfgvx.so
+ * - Programa: gcc -O2 -pthread programa.c -L. -ladfgvx (ou gcc -O2 -pthread programa.c adfgvx.c)
+ *
+ * API principal: adfgvx_encrypt / adfgvx_decrypt (uma mensagem) e adfgvx_encrypt_batch /
+ * adfgvx_decrypt_batch (várias mensagens com a mesma chave). Quem cifra repetidamente com as mesmas
+ * chaves pode compilá-las uma vez (adfgvx_key_schedule) e mantê-las em um adfgvx_schedule_cache, e
+ * usar adfgvx_encrypt_scheduled / adfgvx_decrypt_scheduled. O contexto reutilizável e a arena também
+ * fazem parte da API. Todos os nomes exportados por este cabeçalho têm o prefixo adfgvx_ (ou ADFGVX_);
+ * as tabelas, os kernels e os caminhos de baixo nível ficam em adfgvx_internal.h, usado pelo programa e
+ * pelos testes.
+ */
+
+#ifndef ADFGVX_H
+#define ADFGVX_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Quantidade máxima de threads dos caminhos paralelos (adfgvx_parallel_plan)
+#define ADFGVX_MAX_THREADS 256
+
+// Busca de chaves por crib (adfgvx_key_search): maior chave e maior crib, em caracteres
+#define ADFGVX_SEARCH_MAX_KEY 32
+#define ADFGVX_SEARCH_MAX_CRIB 256
+// Formato compactado: cabeçalho "ADFP", quantidade de símbolos (8 bytes) e versão do formato (4 bytes),
+// ambos big-endian, seguidos de um byte por par de símbolos consecutivos do texto cifrado (6 * a + b, 0 a 35).
+// O cabeçalho não identifica a chave: um hash da chave em claro permitiria testar chaves candidatas offline.
+#define ADFGVX_PACKED_MAGIC "ADFP"
+#define ADFGVX_PACKED_HEADER_SIZE 16
+#define ADFGVX_PACKED_VERSION 1
+// Formato do modo stream: blocos cifrados de forma independente, cada um com um cabeçalho de 4 bytes com a
+// quantidade de símbolos (big-endian) seguido dos símbolos ADFGVX do bloco
+#define ADFGVX_STREAM_HEADER_SIZE 4
+
+struct adfgvx_kernel;        // Kernel Polybius escolhido para a CPU (interno)
+struct adfgvx_square_tables; // Memória das tabelas de uma matriz própria (interna)
+
+/**
+ * @brief Matriz Polybius compilada: tabelas de consulta usadas na codificação e na decodificação.
+ *
+ * Cada escalonamento guarda a sua (adfgvx_key_schedule.polybius): a matriz padrão com
+ * adfgvx_key_schedule_compile e uma matriz própria com adfgvx_key_schedule_compile_square. Os campos
+ * apontam para tabelas internas da biblioteca e não devem ser alterados.
+ */
+typedef struct adfgvx_square
+{
+  const unsigned short *forward; // [256], par de símbolos de cada caractere (com bit de validade)
+  const char (*reverse)[7];      // [7][7], caractere de cada par de símbolos
+  const char *cells;             // [48], matriz linha a linha (36 posições e folga para leituras vetoriais)
+  const char *row_symbols;       // [48], símbolo da linha do caractere de cada posição da matriz padrão
+  const char *col_symbols;       // [48], símbolo da coluna do caractere de cada posição da matriz padrão
+  int default_alphabet;          // 1 se a matriz usa os mesmos 36 caracteres da padrão (kernels vetoriais de codificação)
+  const unsigned short *forward_indices; // [256], como forward, com os índices 0 a 5 dos símbolos no lugar das letras
+  const char *row_indices;               // [48], como row_symbols, com índices
+  const char *col_indices;               // [48], como col_symbols, com índices
+} adfgvx_square;
+
+/**
+ * @brief Arena de memória: uma região fornecida pelo chamador, reservada em blocos e nunca liberada
+ * bloco a bloco.
+ */
+typedef struct
+{
+  char *base;
+  size_t size;
+  size_t used;
+} adfgvx_arena;
+
+/**
+ * @brief Etapas medidas pela instrumentação (adfgvx_stats).
+ */
+typedef enum
+{
+  ADFGVX_STAGE_READ,      // Leitura da entrada
+  ADFGVX_STAGE_ENCODE,    // Polybius: caracteres -> símbolos
+  ADFGVX_STAGE_TRANSPOSE, // Transposição das colunas (cifragem e decifragem)
+  ADFGVX_STAGE_DECODE,    // Polybius inverso: pares -> caracteres
+  ADFGVX_STAGE_WRITE,     // Escrita da saída
+  ADFGVX_STAGE_COUNT
+} adfgvx_stage;
+
+/**
+ * @brief Instrumentação opcional: tempo de parede e ciclos por etapa, bytes de entrada e saída,
+ * caracteres descartados e picos de uso de buffers e de pilha.
+ *
+ * Fica desligada enquanto adfgvx_ctx.stats for NULL: o custo é um teste de ponteiro por etapa de
+ * cada mensagem, nunca por byte. Com -DADFGVX_NO_STATS os pontos de medição nem são compilados.
+ */
+typedef struct
+{
+  double seconds[ADFGVX_STAGE_COUNT];
+  unsigned long long cycles[ADFGVX_STAGE_COUNT]; // Contador de ciclos da CPU (0 fora de x86-64)
+  unsigned long calls[ADFGVX_STAGE_COUNT];
+  size_t bytes_in;
+  size_t bytes_out;
+  size_t invalid_dropped;   // Bytes da entrada fora da matriz Polybius (cifragem) ou pares inválidos (decifragem)
+  size_t peak_buffer_bytes; // Maior soma de buffers informada com adfgvx_stats_buffer
+  size_t peak_stack_bytes;  // Maior profundidade de pilha medida com adfgvx_stats_stack_peak
+  size_t stack_region;      // Endereço da região preenchida pelo último adfgvx_stats_stack_paint (0: não preenchida)
+} adfgvx_stats;
+
+/**
+ * @brief Início de uma medição (ver adfgvx_stats_start e adfgvx_stats_stop).
+ */
+typedef struct
+{
+  double seconds;
+  unsigned long long cycles;
+} adfgvx_stats_mark;
+
+#ifdef ADFGVX_NO_STATS
+#define ADFGVX_STATS_ON(stats) 0
+#else
+#define ADFGVX_STATS_ON(stats) ((stats) != NULL)
+#endif
+
+// Tamanho da região de pilha preenchida por adfgvx_stats_stack_paint, em bytes. O padrão (1 MB) precisa
+// caber na pilha da thread chamadora, o que não vale em alvos embarcados (pilhas de poucos KB): lá,
+// compile a biblioteca e o programa com o mesmo -DADFGVX_STACK_PAINT_SIZE=N menor, ou não use o preenchimento.
+#ifndef ADFGVX_STACK_PAINT_SIZE
+#define ADFGVX_STACK_PAINT_SIZE ((size_t)1 << 20)
+#endif
+
+/**
+ * @brief Contexto reutilizável de cifra: capacidades e buffers pré-dimensionados vindos de uma arena.
+ */
+typedef struct
+{
+  int message_capacity; // Quantidade máxima de caracteres por mensagem
+  int key_capacity;     // Comprimento máximo da chave
+  int *order;           // Ordem das colunas [key_capacity]
+  size_t *cursor;       // Posição inicial/escrita de cada coluna [key_capacity]
+  char *message;        // Buffer de entrada [message_capacity + 1]
+  char *output;         // Buffer de saída [2 * message_capacity + 1]
+  char *symbols;        // Buffer auxiliar de símbolos [2 * message_capacity + 1]
+  int message_length;   // Bytes válidos em message
+  int symbol_count;     // Símbolos produzidos pela última cifragem
+  const struct adfgvx_kernel *kernel; // Kernel Polybius escolhido para a CPU atual
+  const adfgvx_square *polybius;   // Matriz usada por adfgvx_ctx_encrypt/adfgvx_ctx_decrypt (padrão após adfgvx_ctx_init)
+  adfgvx_stats *stats;             // Instrumentação das cifragens/decifragens do contexto (NULL após adfgvx_ctx_init: desligada)
+} adfgvx_ctx;
+
+/**
+ * @brief Escalonamento compilado de uma chave: tudo o que depende só da chave, calculado uma vez.
+ *
+ * order[i] é a coluna original escrita na posição i do texto cifrado e rank é a permutação inversa
+ * (rank[order[i]] == i). O tamanho de cada coluna sai de adfgvx_key_schedule_column_length. A matriz
+ * Polybius (padrão ou própria) é compilada junto com a chave.
+ */
+typedef struct adfgvx_key_schedule
+{
+  char *key;          // Cópia dos bytes da chave [key_capacity]
+  int key_length;     // Comprimento da chave compilada (0 se vazio)
+  int key_capacity;   // Comprimento máximo da chave
+  unsigned int hash;  // Hash FNV-1a da chave
+  int *order;         // Permutação das colunas [key_capacity]
+  int *rank;          // Permutação inversa [key_capacity]
+  adfgvx_square polybius;              // Matriz usada com esta chave
+  struct adfgvx_square_tables *tables; // Memória das tabelas de uma matriz própria
+  int refcount;       // Usuários atuais (entradas de cache com refcount > 0 não são reaproveitadas)
+  struct adfgvx_key_schedule *prev, *next; // Lista LRU do cache
+} adfgvx_key_schedule;
+
+/**
+ * @brief Cache LRU limitado de escalonamentos, indexado pelos bytes da chave, com entradas vindas de uma arena.
+ */
+typedef struct
+{
+  adfgvx_key_schedule *entries;     // Entradas [entry_count]
+  int entry_count;                  // Quantidade máxima de chaves
+  int key_capacity;                 // Comprimento máximo de cada chave
+  adfgvx_key_schedule *head, *tail; // Mais recente e mais antiga
+  pthread_mutex_t lock;
+  unsigned long hits;
+  unsigned long misses;
+} adfgvx_schedule_cache;
+
+/**
+ * @brief Plano de cifragem paralela de uma mensagem: o trecho de cada thread e o índice global do seu
+ * primeiro símbolo, obtidos com uma contagem paralela dos caracteres válidos (adfgvx_parallel_count).
+ */
+typedef struct
+{
+  int thread_count;                             // Quantidade de trechos
+  size_t message_start[ADFGVX_MAX_THREADS + 1]; // Início de cada trecho na mensagem (o último é o tamanho)
+  size_t symbol_start[ADFGVX_MAX_THREADS + 1];  // Primeiro símbolo de cada trecho (o último é o total)
+} adfgvx_parallel_plan;
+
+/**
+ * @brief Cifragem incremental de uma mensagem que cresce por acréscimos (ver adfgvx_appender_append).
+ *
+ * Guarda os símbolos de cada coluna original e quantos cada uma já tem (symbols_per_column), então um
+ * acréscimo só codifica o texto novo e o continua nas colunas de onde o anterior parou. flushed marca
+ * quantos símbolos de cada coluna já foram entregues como segmentos (adfgvx_appender_commit).
+ */
+typedef struct
+{
+  const adfgvx_key_schedule *schedule; // Chave e matriz (precisa continuar válido enquanto o appender for usado)
+  const struct adfgvx_kernel *kernel;  // Kernel Polybius escolhido para a CPU atual
+  size_t symbol_capacity;              // Quantidade máxima de símbolos da mensagem inteira
+  size_t column_capacity;              // Símbolos por coluna: symbol_capacity / key_length, arredondado para cima
+  char *columns;                       // Coluna original c em columns + c * column_capacity [key_length * column_capacity]
+  size_t *symbols_per_column;          // Símbolos de cada coluna original [key_length]
+  size_t *flushed;                     // Símbolos de cada coluna já entregues como segmento [key_length]
+  char *symbols;                       // Bloco de codificação dos acréscimos
+  size_t symbol_count;                 // Símbolos da mensagem inteira até agora
+  int next_column;                     // Coluna que recebe o próximo símbolo (symbol_count % key_length)
+} adfgvx_appender;
+
+/**
+ * @brief Símbolos novos de uma coluna desde o último adfgvx_appender_commit e onde ficam no texto cifrado atual.
+ */
+typedef struct
+{
+  int column;               // Coluna original
+  size_t column_offset;     // Símbolos da coluna já entregues antes deste segmento
+  size_t ciphertext_offset; // Posição do primeiro símbolo do segmento no texto cifrado atual
+  const char *symbols;      // Símbolos novos (dentro de adfgvx_appender.columns)
+  size_t length;
+} adfgvx_column_segment;
+
+/**
+ * @brief Várias rodadas de transposição (dupla transposição, com chaves diferentes) compostas em um único
+ * mapa, para um tamanho de texto cifrado fixo (ver adfgvx_round_plan_compile).
+ *
+ * map[i] é a posição final, no texto cifrado, do símbolo i da sequência Polybius depois de todas as
+ * rodadas. A cifragem escreve cada símbolo direto na posição final e a decifragem lê cada par pelo mesmo
+ * mapa (aplicando a inversa): uma única passada, qualquer que seja a quantidade de rodadas.
+ */
+typedef struct
+{
+  unsigned int *map;       // Posição final de cada símbolo [symbol_capacity]
+  unsigned int *round_map; // Posições de uma única rodada, usadas na composição [symbol_capacity]
+  size_t symbol_capacity;  // Quantidade máxima de símbolos
+  size_t symbol_count;     // Quantidade de símbolos do plano compilado (0 se vazio)
+  int rounds;              // Rodadas compostas no plano
+} adfgvx_round_plan;
+
+/**
+ * @brief Ordem de colunas encontrada pela busca de chaves e a quantidade de símbolos do crib que não conferem.
+ */
+typedef struct
+{
+  int order[ADFGVX_SEARCH_MAX_KEY]; // order[i]: coluna original lida na posição i (como adfgvx_key_schedule.order)
+  int mismatches;
+} adfgvx_key_candidate;
+
+/**
+ * @brief Contadores da busca de chaves.
+ */
+typedef struct
+{
+  unsigned long long nodes;   // Prefixos de permutação avaliados (cada um confere uma coluna contra o crib)
+  double permutations;        // Permutações cobertas, inclusive as descartadas junto com um prefixo podado
+  unsigned long long matches; // Permutações completas aceitas
+  int thread_count;           // Threads efetivamente usadas
+} adfgvx_key_search_stats;
+
+// API principal
+size_t adfgvx_encrypted_length(const char message[], size_t message_length);
+int adfgvx_encrypt(const char key[], int key_length, const char message[], size_t message_length, char output[], size_t output_capacity, size_t *output_length);
+int adfgvx_decrypt(const char key[], int key_length, const char ciphertext[], size_t symbol_count, char output[], size_t output_capacity, size_t *output_length);
+int adfgvx_encrypt_batch(const char key[], int key_length, size_t count, const char *const messages[], const size_t message_lengths[], char *const outputs[], const size_t output_capacities[], size_t output_lengths[]);
+int adfgvx_decrypt_batch(const char key[], int key_length, size_t count, const char *const ciphertexts[], const size_t symbol_counts[], char *const outputs[], const size_t output_capacities[], size_t output_lengths[]);
+int adfgvx_encrypt_scheduled(const adfgvx_key_schedule *schedule, const char message[], size_t message_length, char output[], size_t output_capacity, size_t *output_length);
+int adfgvx_decrypt_scheduled(const adfgvx_key_schedule *schedule, const char ciphertext[], size_t symbol_count, char output[], size_t output_capacity, size_t *output_length);
+
+// Cifragem e decifragem paralela de uma única mensagem
+size_t adfgvx_parallel_count(adfgvx_parallel_plan *plan, const adfgvx_key_schedule *schedule, const char message[], size_t message_length, int thread_count);
+void adfgvx_parallel_encrypt(const adfgvx_parallel_plan *plan, const adfgvx_key_schedule *schedule, const char message[], char output[]);
+size_t adfgvx_parallel_decrypt(const adfgvx_key_schedule *schedule, const char ciphertext[], size_t symbol_count, char output[], int thread_count);
+int adfgvx_encrypt_parallel(const adfgvx_key_schedule *schedule, const char message[], size_t message_length, char output[], size_t output_capacity, size_t *output_length, int thread_count);
+int adfgvx_decrypt_parallel(const adfgvx_key_schedule *schedule, const char ciphertext[], size_t symbol_count, char output[], size_t output_capacity, size_t *output_length, int thread_count);
+
+// Formato compactado (um byte por par de símbolos)
+size_t adfgvx_packed_size(size_t symbol_count);
+void adfgvx_packed_write_header(unsigned char header[], size_t symbol_count, unsigned int format_version);
+int adfgvx_packed_read_header(const unsigned char packed[], size_t packed_size, size_t *symbol_count, unsigned int *format_version);
+int adfgvx_encrypt_packed(const adfgvx_key_schedule *schedule, const char message[], size_t message_length, unsigned char output[], size_t output_capacity, size_t *output_length);
+int adfgvx_decrypt_packed(const adfgvx_key_schedule *schedule, const unsigned char packed[], size_t packed_size, char output[], size_t output_capacity, size_t *output_length);
+
+// Formato do modo stream (blocos com cabeçalho de tamanho)
+void adfgvx_stream_write_header(unsigned char header[], size_t symbol_count);
+int adfgvx_stream_check(const char data[], size_t size, size_t *symbol_count);
+int adfgvx_decrypt_stream(const adfgvx_key_schedule *schedule, const char data[], size_t size, char output[], size_t output_capacity, size_t *output_length);
+
+// Cifragem incremental (mensagens que crescem por acréscimos)
+size_t adfgvx_appender_arena_size(int key_length, size_t symbol_capacity);
+int adfgvx_appender_init(adfgvx_appender *appender, adfgvx_arena *arena, const adfgvx_key_schedule *schedule, size_t symbol_capacity);
+void adfgvx_appender_reset(adfgvx_appender *appender);
+int adfgvx_appender_append(adfgvx_appender *appender, const char text[], size_t length);
+int adfgvx_appender_ciphertext(const adfgvx_appender *appender, char output[], size_t output_capacity, size_t *output_length);
+int adfgvx_appender_changes(const adfgvx_appender *appender, adfgvx_column_segment segments[]);
+void adfgvx_appender_commit(adfgvx_appender *appender);
+
+// Várias rodadas de transposição compostas em uma única passada
+size_t adfgvx_round_plan_arena_size(size_t symbol_capacity);
+int adfgvx_round_plan_init(adfgvx_round_plan *plan, adfgvx_arena *arena, size_t symbol_capacity);
+int adfgvx_round_plan_compile(adfgvx_round_plan *plan, const adfgvx_key_schedule *const schedules[], int rounds, size_t symbol_count);
+int adfgvx_round_plan_encrypt(const adfgvx_round_plan *plan, const adfgvx_square *polybius, const char message[], size_t message_length, char output[]);
+size_t adfgvx_round_plan_decrypt(const adfgvx_round_plan *plan, const adfgvx_square *polybius, const char ciphertext[], char output[]);
+
+// Busca da ordem das colunas a partir de um trecho conhecido da mensagem (crib)
+int adfgvx_key_search(const adfgvx_square *polybius, const char ciphertext[], size_t symbol_count, int key_length,
+                      const char crib[], size_t crib_length, size_t crib_offset, int max_mismatches, int thread_count,
+                      adfgvx_key_candidate candidates[], int candidate_capacity, adfgvx_key_search_stats *stats);
+
+// Instrumentação (adfgvx_stats)
+void adfgvx_stats_start(adfgvx_stats_mark *mark);
+void adfgvx_stats_stop(adfgvx_stats *stats, adfgvx_stage stage, const adfgvx_stats_mark *mark);
+void adfgvx_stats_buffer(adfgvx_stats *stats, size_t bytes);
+void adfgvx_stats_stack_paint(adfgvx_stats *stats);
+size_t adfgvx_stats_stack_peak(adfgvx_stats *stats);
+
+// Arena e contexto reutilizável
+void adfgvx_arena_init(adfgvx_arena *arena, void *memory, size_t size);
+void *adfgvx_arena_alloc(adfgvx_arena *arena, size_t size);
+size_t adfgvx_ctx_arena_size(int message_capacity, int key_capacity);
+int adfgvx_ctx_init(adfgvx_ctx *ctx, adfgvx_arena *arena, int message_capacity, int key_capacity);
+void adfgvx_ctx_reset(adfgvx_ctx *ctx);
+int adfgvx_ctx_encrypt(adfgvx_ctx *ctx, const char key[], int key_length, const char message[], int message_length, char output[], int output_capacity);
+int adfgvx_ctx_decrypt(adfgvx_ctx *ctx, const char key[], int key_length, const char ciphertext[], int symbol_count, char output[], int output_capacity);
+int adfgvx_ctx_encrypt_scheduled(adfgvx_ctx *ctx, const adfgvx_key_schedule *schedule, const char message[], int message_length, char output[], int output_capacity);
+int adfgvx_ctx_decrypt_scheduled(adfgvx_ctx *ctx, const adfgvx_key_schedule *schedule, const char ciphertext[], int symbol_count, char output[], int output_capacity);
+
+// Escalonamentos de chave e cache LRU
+size_t adfgvx_key_schedule_arena_size(int key_capacity);
+int adfgvx_key_schedule_init(adfgvx_key_schedule *schedule, adfgvx_arena *arena, int key_capacity);
+int adfgvx_key_schedule_compile(adfgvx_key_schedule *schedule, const char key[], int key_length);
+int adfgvx_key_schedule_compile_square(adfgvx_key_schedule *schedule, const char key[], int key_length, const char cells[]);
+size_t adfgvx_key_schedule_column_length(const adfgvx_key_schedule *schedule, size_t symbol_count, int column);
+size_t adfgvx_schedule_cache_arena_size(int entry_count, int key_capacity);
+int adfgvx_schedule_cache_init(adfgvx_schedule_cache *cache, adfgvx_arena *arena, int entry_count, int key_capacity);
+void adfgvx_schedule_cache_destroy(adfgvx_schedule_cache *cache);
+const adfgvx_key_schedule *adfgvx_schedule_acquire(adfgvx_schedule_cache *cache, const char key[], int key_length);
+const adfgvx_key_schedule *adfgvx_schedule_acquire_square(adfgvx_schedule_cache *cache, const char key[], int key_length, const char cells[]);
+void adfgvx_schedule_release(adfgvx_schedule_cache *cache, const adfgvx_key_schedule *schedule);
+
+#endif
@@ -0,0 +1,141 @@
+/**
+ * Biblioteca: Cifra ADFGVX
+ *
+ * Licença: MIT License.
+ *
+ * Interface interna da biblioteca: tabelas de consulta, matrizes Polybius, kernels, caminhos de baixo
+ * nível e o caminho original. Usada por adfgvx.c, pelo programa cipher_adfgvx e pelos testes; não faz
+ * parte da API pública (adfgvx.h) e os seus nomes não têm o prefixo adfgvx_.
+ */
+
+#ifndef ADFGVX_INTERNAL_H
+#define ADFGVX_INTERNAL_H
+
+#include "adfgvx.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ADFGVX_X86_SIMD 1
+#endif
+
+// Caracteres codificados de uma vez por adfgvx_appender_append
+#define APPENDER_BLOCK_SIZE 4096
+
+// Capacidades padrão do programa, em caracteres. Os limites efetivos são definidos em tempo de execução no adfgvx_ctx.
+#define DEFAULT_MESSAGE_CAPACITY 2560
+#define DEFAULT_KEY_CAPACITY 8
+// Alinhamento dos blocos reservados na arena
+#define ARENA_ALIGNMENT 16
+
+// Tabelas de consulta pré-computadas a partir de `square` (geradas em tempo de compilação).
+// polybius_forward[c]: par (linha, coluna) de símbolos ADFGVX do caractere c, com o símbolo da linha
+// no byte baixo, o da coluna nos bits 8-14 e POLYBIUS_VALID indicando que c está na matriz.
+#define POLYBIUS_VALID 0x8000
+#define POLYBIUS_PAIR(row, col) (POLYBIUS_VALID | ((col) << 8) | (row))
+#define POLYBIUS_ROW(pair) ((char)((pair) & 0xFF))
+#define POLYBIUS_COL(pair) ((char)(((pair) >> 8) & 0x7F))
+
+extern const char symbols[6];
+extern const char square[6][6];
+extern const unsigned short polybius_forward[256];
+extern const unsigned short polybius_forward_indices[256];
+extern const unsigned char symbol_rank[256];
+extern const char polybius_reverse[7][7];
+
+// Quantidade de posições da matriz Polybius e tamanho dos vetores de 36 posições com folga para
+// leituras vetoriais de 16 bytes
+#define POLYBIUS_CELLS 36
+#define POLYBIUS_CELLS_PADDED 48
+
+/**
+ * @brief Matriz Polybius compilada (adfgvx_square).
+ *
+ * A matriz padrão (polybius_default_square) aponta para as tabelas geradas em tempo de compilação;
+ * matrizes próprias (carregadas ou derivadas de uma palavra-chave) são compiladas uma única vez com
+ * polybius_square_compile em um polybius_square_tables e usadas exatamente pelo mesmo código.
+ * forward tem o formato de polybius_forward, reverse o de polybius_reverse e os vetores de posições
+ * têm POLYBIUS_CELLS_PADDED bytes.
+ */
+typedef adfgvx_square polybius_square;
+
+/**
+ * @brief Memória das tabelas de uma matriz Polybius própria.
+ */
+typedef struct adfgvx_square_tables
+{
+  unsigned short forward[256];
+  char reverse[7][7];
+  char cells[POLYBIUS_CELLS_PADDED];
+  char row_symbols[POLYBIUS_CELLS_PADDED];
+  char col_symbols[POLYBIUS_CELLS_PADDED];
+  unsigned short forward_indices[256];
+  char row_indices[POLYBIUS_CELLS_PADDED];
+  char col_indices[POLYBIUS_CELLS_PADDED];
+} polybius_square_tables;
+
+extern const polybius_square polybius_default_square;
+
+/**
+ * @brief Kernel de codificação/decodificação Polybius (escalar ou vetorial), escolhido em tempo de execução.
+ */
+typedef struct adfgvx_kernel
+{
+  const char *name;
+  int (*encode)(const polybius_square *polybius, const char message[], int message_length, char symbols_out[]); // Retorna a quantidade de símbolos
+  int (*decode)(const polybius_square *polybius, const char pairs[], int pair_count, char message[]);          // Retorna a quantidade de caracteres
+  int (*pack)(const char symbols[], int symbol_count, unsigned char packed[]);   // Retorna a quantidade de bytes, ou -1 se houver símbolo inválido
+  int (*unpack)(const unsigned char packed[], int symbol_count, char symbols[]); // Retorna symbol_count, ou -1 se houver byte inválido
+  int (*decode_indices)(const polybius_square *polybius, const char pairs[], int pair_count, char message[]); // Como decode, com pares de índices 0 a 5
+} polybius_kernel;
+
+// Representação interna por índices de símbolo (0 a 5); letras só na fronteira de saída
+void polybius_square_index_view(const polybius_square *polybius, polybius_square *view);
+void symbols_from_indices(const char indices[], size_t count, char symbols_out[]);
+void indices_from_symbols(const char symbols_in[], size_t count, char indices[]);
+size_t decipher_adfgvx_indices(const polybius_square *polybius, const int order[], int key_length, const char indices[], size_t symbol_count, char output[]);
+
+// Formato compactado: codificação e decodificação com a ordem das colunas já calculada
+void cipher_adfgvx_packed(const polybius_square *polybius, const int order[], int key_length, const char message[], size_t message_length, size_t symbol_count, unsigned char packed[]);
+size_t decipher_adfgvx_packed(const polybius_square *polybius, const int order[], int key_length, const unsigned char packed[], size_t symbol_count, char output[]);
+// Caminho original: matriz de colunas e transposição por trocas
+int read_file(const char *filename, char *buffer, int max_length);
+int get_adfgvx_symbols(char c, char *row, char *col);
+void insert_symbol_to_column(int key_length, int max_per_column, char symbol, int *symbol_count, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[]);
+void polybius_encode_to_columns(int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[]);
+void transpose_columns_by_key_order(char key[], int key_length, int max_per_column, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[]);
+void cipher_adfgvx(char key[], int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[]);
+
+// Escrita e leitura direta de cada símbolo na sua posição final
+void compute_column_order(const char key[], int key_length, int order[]);
+void compute_column_offsets(int key_length, const int order[], size_t symbol_count, size_t column_start[]);
+size_t count_valid_characters(const char message[], size_t message_length);
+size_t polybius_count_valid(const polybius_square *polybius, const char message[], size_t message_length);
+void scatter_symbols(const polybius_square *polybius, int key_length, const char message[], size_t message_length, size_t cursor[], char output[]);
+int cipher_adfgvx_direct(const char key[], int key_length, const char message[], char output[]);
+void cipher_adfgvx_ordered(const polybius_square *polybius, const int order[], int key_length, const char *message, size_t message_length, size_t symbol_count, char *output);
+void cipher_adfgvx_buffer(const char key[], int key_length, const char *message, size_t message_length, size_t symbol_count, char *output);
+size_t gather_decode_symbols(const polybius_square *polybius, int key_length, const char ciphertext[], size_t symbol_count, size_t cursor[], char output[]);
+size_t decipher_adfgvx_ordered(const polybius_square *polybius, const int order[], int key_length, const char ciphertext[], size_t symbol_count, char output[]);
+size_t decipher_adfgvx_direct(const char key[], int key_length, const char ciphertext[], size_t symbol_count, char output[]);
+
+// Cifragem no próprio buffer da mensagem (memória extra O(key_length))
+size_t polybius_encode_in_place(const polybius_square *polybius, char buffer[], size_t message_length);
+void transpose_symbols_in_place(char symbols[], size_t symbol_count, int key_length, const size_t column_start[]);
+size_t cipher_adfgvx_in_place(const polybius_square *polybius, const int order[], int key_length, char buffer[], size_t message_length);
+
+// Kernels Polybius
+extern const polybius_kernel polybius_kernels[];
+extern const int polybius_kernel_count;
+int polybius_encode_scalar(const polybius_square *polybius, const char message[], int message_length, char symbols_out[]);
+int polybius_decode_scalar(const polybius_square *polybius, const char pairs[], int pair_count, char message[]);
+int polybius_pack_scalar(const char symbols[], int symbol_count, unsigned char packed[]);
+int polybius_unpack_scalar(const unsigned char packed[], int symbol_count, char symbols[]);
+int polybius_decode_indices_scalar(const polybius_square *polybius, const char pairs[], int pair_count, char message[]);
+int polybius_kernel_supported(const polybius_kernel *kernel);
+const polybius_kernel *polybius_select_kernel(void);
+void gather_columns(const char symbols[], size_t first, size_t count, int key_length, const size_t column_start[], char output[]);
+void scatter_columns(const char ciphertext[], size_t first, size_t count, int key_length, const size_t column_start[], char symbols[]);
+
+// Matrizes Polybius próprias
+void polybius_square_from_keyword(const char keyword[], int keyword_length, char cells[POLYBIUS_CELLS]);
+int polybius_square_compile(polybius_square *polybius, polybius_square_tables *tables, const char cells[POLYBIUS_CELLS]);
+#endif
@@ -5,17 +5,36 @@
  *
  * Como usar:
  * - Create: Crie os arquivos "message.txt" e "key.txt" no mesmo diretório do código.
- * - Compile Windows: gcc ./cipher_adfgvx.c -o cipher_adfgvx
- * - Compile Mac: clang ./cipher_adfgvx.c -o cipher_adfgvx (pode ser necessário dar permissão para leitura/escrita de arquivos)
+ * - Compile Windows: gcc ./adfgvx.c ./cipher_adfgvx.c -o cipher_adfgvx -pthread
+ * - Compile Mac: clang ./adfgvx.c ./cipher_adfgvx.c -o cipher_adfgvx -pthread (pode ser necessário dar permissão para leitura/escrita de arquivos)
  * - Change: Mude os arquivos de entrada conforme o necessário.
- * - Execute: ./cipher_adfgvx
+ * - Execute: ./cipher_adfgvx (ou ./cipher_adfgvx --matrix para usar a matriz de colunas original)
+ * - In-place: ./cipher_adfgvx --in-place (codifica e transpõe no próprio buffer; memória extra O(tamanho da chave))
+ * - Capacidade: ./cipher_adfgvx --capacity 10000 --key-capacity 16 (limites de mensagem e chave, padrão 2560 e 8)
+ * - Stream: ./cipher_adfgvx --stream [entrada] [saída] [--pipeline [--chunks N]] (sem argumentos usa stdin/stdout, ex: cat log.txt | ./cipher_adfgvx --stream > log.enc)
+ * - Decifrar: ./cipher_adfgvx --decrypt [entrada] [saída] [--threads N] (padrão "./encrypted.txt" e "./decrypted.txt"; "-" usa stdin/stdout; aceita a saída de --stream e --packed)
+ * - Two-pass: ./cipher_adfgvx --two-pass [entrada] [saída] [--buffer BYTES] (arquivo inteiro como uma mensagem, com memória constante)
+ * - Compactado: ./cipher_adfgvx --packed [entrada] [saída] (um byte por par de símbolos, padrão "./encrypted.adfp"; --decrypt reconhece o formato)
+ * - Mmap: ./cipher_adfgvx --mmap <entrada> <saída> [--threads N] (arquivo inteiro como uma mensagem, via mmap; "-" usa stdin/stdout)
+ * - Comparar E/S: ./cipher_adfgvx --bench-io <entrada> <saída> (fputc x fwrite x mmap x duas passadas x compactado)
+ * - Benchmark: ./cipher_adfgvx --bench [--max-size BYTES] [--baseline anterior.json] > resultado.json (JSON com mediana, p99, bytes/s e ciclos/byte)
+ * - Batch: ./cipher_adfgvx --batch <diretório|manifesto> [--threads N] [--engine uring|threads|sequential] [--depth D] [--cold] (cada arquivo vira "<arquivo>.enc", ou a saída indicada no manifesto)
+ * - Estatísticas: ./cipher_adfgvx --stats [--matrix|--in-place] (tempo e ciclos por etapa, bytes, descartes e picos de memória, em JSON no stderr)
+ * - Daemon: ./cipher_adfgvx --daemon <socket> [--threads N] (requisições binárias por um socket de domínio Unix; ver run_daemon_mode)
+ * - Carga: ./cipher_adfgvx --load <socket> [--connections C] [--requests N] [--size BYTES] [--pipeline P] [--decrypt] (req/s e latências)
+ * - Busca de chaves: ./cipher_adfgvx --search <texto cifrado> --key-length K --crib TEXTO [--offset N] [--mismatches M] [--threads N] (ordens de colunas compatíveis com o crib)
  *
  * Dados de entrada e saída:
  * - Entrada:
  *    Arquivo "./message.txt" contendo a mensagem a ser cifrada em MAIÚSCULAS, podendo haver espaços, vírgula e ponto. Caracteres fora da matriz Polybius serão ignorados.
- *    Arquivo "./key.txt" contendo a chave de transposição (até 8 caracteres).
+ *    Arquivo "./key.txt" contendo a chave de transposição (até 8 caracteres; chaves longas, de milhares de caracteres, com --key-capacity).
  * - Saída:
  *    Arquivo "./encrypted.txt" com a mensagem cifrada, onde cada caractere é um símbolo ADFGVX (A, D, F, G, V, X) representando pares de caracteres da matriz Polybius.
+ *    Com --decrypt, arquivo "./decrypted.txt" com a mensagem decifrada (somente os caracteres da matriz Polybius).
+ *    Com --packed, arquivo "./encrypted.adfp" com um cabeçalho de 16 bytes ("ADFP", quantidade de símbolos e versão do formato)
+ *    seguido de um byte por par de símbolos (metade do tamanho de "./encrypted.txt").
+ *    No modo stream, cada bloco de até --capacity caracteres é cifrado de forma independente e escrito como
+ *    um cabeçalho de 4 bytes (quantidade de símbolos, big-endian) seguido dos símbolos do bloco.
  * Autores:
  * - Lucas Dantas
  * - Marcus Vinicius
@@ -27,176 +46,4051 @@
  * Plataforma alvo: Microprocessadores com suporte a código C.
  */
 
+#include "adfgvx_internal.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef ADFGVX_X86_SIMD
+#include <x86intrin.h>
+#endif
+
+// Motor io_uring do modo batch: só no Linux, com chamadas de sistema diretas (sem liburing)
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BATCH_IO_URING
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// Tamanho dos buffers de E/S do modo stream (escritas grandes em vez de uma chamada por símbolo)
+#define STREAM_IO_BUFFER_SIZE (1 << 20)
+
+// Pipeline do modo stream: blocos no pool, espera ativa antes de ceder a CPU e faixas do histograma de latência
+#define PIPELINE_CHUNKS 16
+#define PIPELINE_SPIN 256
+#define PIPELINE_MAX_SLEEP_NS 1000000
+#define PIPELINE_LATENCY_BUCKETS 256
+
+// Modo two-pass: tamanho da leitura da entrada e memória padrão dos buffers de coluna (somados)
+#define TWO_PASS_READ_SIZE 4096
+#define TWO_PASS_BUFFER_SIZE (1 << 16)
+
+// Modo batch: sufixo dos arquivos cifrados e tamanho máximo de um caminho
+#define BATCH_OUTPUT_SUFFIX ".enc"
+#define BATCH_PATH_LENGTH 4096
+// Motor io_uring: arquivos em andamento (leitura, cifragem ou escrita) ao mesmo tempo
+#define BATCH_URING_DEPTH 64
+
+// Benchmark: maior tamanho de mensagem da varredura e tolerância padrão (%) em relação à baseline
+#define BENCH_MAX_SIZE ((size_t)1 << 30)
+#define BENCH_TOLERANCE 10.0
+
+// Modo daemon: cabeçalho de 8 bytes nas requisições e respostas, maior payload aceito e entradas do cache de chaves
+#define DAEMON_HEADER_SIZE 8
+#define DAEMON_MAX_PAYLOAD ((size_t)64 << 20)
+#define DAEMON_CACHE_ENTRIES 64
+#define DAEMON_IO_BUFFER_SIZE (1 << 16)
+#define DAEMON_SEND_TIMEOUT 5 // Segundos sem conseguir enviar nada antes de o daemon desistir de uma conexão
+#define DAEMON_OP_ENCRYPT 'E'
+#define DAEMON_OP_DECRYPT 'D'
+#define DAEMON_STATUS_OK 0
+#define DAEMON_STATUS_ERROR 1
+
+/**
+ * @brief Bloco do pipeline do modo stream: buffers de entrada e de saída, reutilizados pelo pool.
+ */
+typedef struct
+{
+  char *message;
+  size_t message_length; // 0 marca o fim da entrada
+  char *output;
+  int symbol_count;
+  double ready; // Instante em que o bloco terminou de ser lido (latência até a escrita)
+} pipeline_chunk;
+
+/**
+ * @brief Fila circular sem lock de um produtor e um consumidor (SPSC).
+ *
+ * Só o produtor escreve tail e só o consumidor escreve head; cada um fica na sua linha de cache.
+ */
+typedef struct
+{
+  unsigned head __attribute__((aligned(64)));
+  unsigned tail __attribute__((aligned(64)));
+  unsigned mask;
+  pipeline_chunk **slots;
+} pipeline_ring;
+
+/**
+ * @brief Contadores de uma etapa do pipeline.
+ */
+typedef struct
+{
+  long long chunks;
+  long long stalls;      // Vezes em que a etapa esperou (fila de entrada vazia ou nenhum buffer livre)
+  double stall_seconds;  // Tempo total dessas esperas
+  long long depth_sum;   // Soma da ocupação da fila de saída a cada envio (média = depth_sum / chunks)
+  unsigned depth_max;
+} pipeline_stage;
+
+/**
+ * @brief Relatório do pipeline: contadores das três etapas, vazão e histograma de latência por bloco.
+ */
+typedef struct
+{
+  pipeline_stage reader;  // Saída: fila leitura -> cifragem; esperas: nenhum buffer livre (contrapressão)
+  pipeline_stage encoder; // Saída: fila cifragem -> escrita; esperas: nenhum bloco lido
+  pipeline_stage writer;  // Esperas: nenhum bloco cifrado
+  long long bytes_in;
+  long long bytes_out;
+  double seconds;
+  unsigned long long latency[PIPELINE_LATENCY_BUCKETS]; // Da leitura à escrita de cada bloco, em ns (ver pipeline_latency_bucket)
+  double latency_max;
+} pipeline_report;
+
+/**
+ * @brief Tarefa do modo batch: um arquivo de entrada e o arquivo cifrado correspondente.
+ */
+typedef struct
+{
+  char *input;
+  char *output;
+} batch_job;
+
+typedef struct batch_pool batch_pool;
+
+/**
+ * @brief Worker do modo batch: fila própria de tarefas [head, tail), contexto de cifra e contadores.
+ */
+typedef struct
+{
+  batch_pool *pool;
+  int index;
+  pthread_t thread;
+  pthread_mutex_t lock; // Protege head e tail (o dono retira do início, os ladrões do final)
+  int head;
+  int tail;
+  void *arena_memory;
+  adfgvx_arena arena;
+  adfgvx_ctx ctx;
+  int files;
+  int failures;
+  long long bytes_in;
+  long long bytes_out;
+} batch_worker;
+
+/**
+ * @brief Pool do modo batch: lista de tarefas, workers e o escalonamento da chave compartilhado.
+ */
+struct batch_pool
+{
+  batch_job *jobs;
+  int job_count;
+  int job_capacity;
+  batch_worker *workers;
+  int worker_count;
+  adfgvx_key_schedule schedule; // Chave compilada uma única vez e compartilhada (somente leitura)
+  void *uring;                  // Motor io_uring em execução (batch_uring), ou NULL
+};
+
+#ifdef BATCH_IO_URING
+/**
+ * @brief Anel do io_uring mapeado em memória: filas de submissão (SQ) e de conclusão (CQ).
+ */
+typedef struct
+{
+  int fd;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring; // Igual a sq_ring com IORING_FEAT_SINGLE_MMAP
+  size_t cq_ring_size;
+  size_t sqes_size;
+  unsigned sq_entries;
+  unsigned to_submit; // SQEs preenchidas e ainda não enviadas ao kernel
+} batch_ring;
+
+/**
+ * @brief Arquivo em andamento no motor io_uring: etapa atual, descritor e buffers próprios.
+ *
+ * Os buffers são do slot (e não do worker) porque a leitura e a escrita continuam no kernel enquanto os
+ * workers cifram outros arquivos.
+ */
+typedef struct
+{
+  int job;
+  int state; // BATCH_OP_* da operação em andamento
+  int fd;
+  int failed;
+  char *message;
+  size_t message_length;
+  char *output;
+  int symbol_count;
+  size_t written;
+} batch_slot;
+
+/**
+ * @brief Motor io_uring do modo batch: anel, slots e as filas de entrega entre o anel e os workers.
+ *
+ * A thread principal é a única que usa o anel. Os workers retiram slots lidos de encrypt_queue, cifram e
+ * os devolvem em done_queue, avisando a thread do anel por event_fd (uma leitura sempre pendente no anel).
+ */
+typedef struct
+{
+  batch_pool *pool;
+  batch_ring ring;
+  batch_slot *slots;
+  int slot_count;
+  int next_job;
+  int finished;
+  pthread_mutex_t lock; // Protege as duas filas e stop
+  pthread_cond_t ready;
+  int *encrypt_queue; // Filas circulares de índices de slot, com slot_count posições
+  int encrypt_head;
+  int encrypt_tail;
+  int *done_queue;
+  int done_head;
+  int done_tail;
+  int stop;
+  int event_fd;
+  uint64_t event_value; // Destino da leitura pendente em event_fd
+  int error;            // errno de um envio ao anel que falhou (encerra o motor)
+  int files;
+  int failures;
+  long long bytes_in;
+  long long bytes_out;
+} batch_uring;
+#endif
+
+/**
+ * @brief Resultado de uma combinação do benchmark (operação, caminho, mistura, tamanho e chave).
+ */
+typedef struct
+{
+  const char *op;
+  const char *path;
+  const char *mix;
+  size_t size;
+  int key_length;
+  int runs;
+  double median_ns;
+  double p99_ns;
+  double cycles_per_byte;
+} bench_result;
+
+/**
+ * @brief Estado de uma execução do benchmark: buffers, opções e resultados já medidos.
+ */
+typedef struct
+{
+  adfgvx_ctx *ctx;
+  char *message;
+  char *ciphertext;
+  char *symbols;
+  size_t symbol_count;
+  const char *directory;
+  int max_runs;
+  double *samples;
+  unsigned long long *cycles;
+  bench_result *results;
+  int result_count;
+  int result_capacity;
+} bench_state;
+
+/**
+ * @brief Estado compartilhado do modo daemon: socket de escuta e chaves já compiladas.
+ */
+typedef struct
+{
+  int listen_fd;
+  adfgvx_schedule_cache cache;                 // Chaves enviadas nas requisições (compartilhado, com lock próprio)
+  const adfgvx_key_schedule *default_schedule; // Chave de "./key.txt", compilada na inicialização e sempre reservada
+  const char *cells;                           // Matriz Polybius de todas as chaves
+} daemon_server;
+
+/**
+ * @brief Conexão do gerador de carga: requisições enviadas, latências medidas e falhas.
+ */
+typedef struct
+{
+  const char *socket_path;
+  const char *request; // Requisição completa (cabeçalho e payload), repetida em todos os envios
+  size_t request_size;
+  size_t expected_length; // Tamanho esperado de cada resposta (payload)
+  int requests;
+  int pipeline;
+  double *latencies;
+  int completed;
+  int failures;
+  pthread_t thread;
+} load_client;
+
+/**
+ * @brief Retorna o tempo de um relógio monotônico, em segundos.
+ */
+double monotonic_seconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Escreve um bloco cifrado no formato do modo stream.
+ *
+ * Cada bloco é precedido por um cabeçalho de ADFGVX_STREAM_HEADER_SIZE bytes com a quantidade de símbolos
+ * (big-endian), seguido pelos símbolos já transpostos, escritos com um único fwrite.
+ *
+ * @param output Arquivo de saída.
+ * @param encrypted Símbolos cifrados do bloco.
+ * @param symbol_count Quantidade de símbolos do bloco.
+ * @return int 0 em caso de sucesso, 1 em caso de erro de escrita.
+ */
+int write_stream_chunk(FILE *output, char encrypted[], int symbol_count)
+{
+  // Blocos sem nenhum caractere válido não geram saída
+  if (symbol_count == 0)
+  {
+    return 0;
+  }
+
+  unsigned char header[ADFGVX_STREAM_HEADER_SIZE];
+
+  adfgvx_stream_write_header(header, (size_t)symbol_count);
+  if (fwrite(header, 1, ADFGVX_STREAM_HEADER_SIZE, output) != ADFGVX_STREAM_HEADER_SIZE ||
+      fwrite(encrypted, 1, symbol_count, output) != (size_t)symbol_count)
+  {
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Cifra uma entrada de tamanho arbitrário em blocos independentes.
+ *
+ * A entrada é lida em blocos de ctx->message_capacity bytes no buffer do contexto, cada bloco é
+ * cifrado com adfgvx_ctx_encrypt_scheduled (a chave e a matriz do contexto são compiladas uma única
+ * vez) e escrito com o cabeçalho de write_stream_chunk. A memória usada é
+ * fixa (o contexto e os buffers de E/S), independente do tamanho da entrada.
+ *
+ * @param ctx Contexto de cifra, reutilizado em todos os blocos.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input Arquivo de entrada (pode ser stdin).
+ * @param output Arquivo de saída (pode ser stdout).
+ * @return int 0 em caso de sucesso, 1 em caso de erro de leitura ou escrita.
+ */
+int cipher_adfgvx_stream(adfgvx_ctx *ctx, char key[], int key_length, FILE *input, FILE *output)
+{
+  static char input_buffer[STREAM_IO_BUFFER_SIZE], output_buffer[STREAM_IO_BUFFER_SIZE];
+  char schedule_memory[adfgvx_key_schedule_arena_size(key_length)];
+  adfgvx_arena schedule_arena;
+  adfgvx_key_schedule schedule;
+
+  adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+  if (adfgvx_key_schedule_init(&schedule, &schedule_arena, key_length) != 0 ||
+      adfgvx_key_schedule_compile_square(&schedule, key, key_length, ctx->polybius->cells) != 0)
+  {
+    return 1;
+  }
+
+  setvbuf(input, input_buffer, _IOFBF, STREAM_IO_BUFFER_SIZE);
+  setvbuf(output, output_buffer, _IOFBF, STREAM_IO_BUFFER_SIZE);
+
+  while ((ctx->message_length = fread(ctx->message, 1, ctx->message_capacity, input)) > 0)
+  {
+    int symbol_count = adfgvx_ctx_encrypt_scheduled(ctx, &schedule, ctx->message, ctx->message_length, ctx->output, 2 * ctx->message_capacity + 1);
+
+    if (symbol_count < 0 || write_stream_chunk(output, ctx->output, symbol_count) != 0)
+    {
+      return 1;
+    }
+    adfgvx_ctx_reset(ctx);
+  }
+
+  if (ferror(input) || fflush(output) != 0)
+  {
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Coloca um bloco na fila (somente o produtor). A fila comporta todos os blocos do pool, então
+ * nunca está cheia: a contrapressão vem da fila de buffers livres.
+ *
+ * @return unsigned Ocupação da fila logo após o envio.
+ */
+static unsigned pipeline_push(pipeline_ring *ring, pipeline_chunk *chunk)
+{
+  unsigned tail = ring->tail;
+
+  ring->slots[tail & ring->mask] = chunk;
+  __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+  return tail + 1 - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Retira um bloco da fila (somente o consumidor), ou NULL se ela estiver vazia.
+ */
+static pipeline_chunk *pipeline_pop(pipeline_ring *ring)
+{
+  unsigned head = ring->head;
+
+  if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+  {
+    return NULL;
+  }
+  pipeline_chunk *chunk = ring->slots[head & ring->mask];
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+  return chunk;
+}
+
+/**
+ * @brief Estado compartilhado pelas três threads do pipeline.
+ */
+typedef struct
+{
+  FILE *input;
+  FILE *output;
+  adfgvx_ctx *ctx;
+  const adfgvx_key_schedule *schedule;
+  pipeline_ring filled;    // Leitura -> cifragem
+  pipeline_ring encrypted; // Cifragem -> escrita
+  pipeline_ring free;      // Escrita -> leitura (pool de buffers)
+  int failed;              // Alguma etapa falhou: as outras param de esperar
+  pipeline_report *report;
+} pipeline_state;
+
+/**
+ * @brief Espera um bloco da fila, contando a espera como um stall da etapa.
+ *
+ * Espera ativa por PIPELINE_SPIN voltas, depois cede a CPU (sched_yield) e, se a fila continuar vazia
+ * (entrada contínua e lenta, como um tail de log), dorme com intervalos dobrando até PIPELINE_MAX_SLEEP_NS.
+ *
+ * @return pipeline_chunk* Bloco retirado, ou NULL se outra etapa falhou.
+ */
+static pipeline_chunk *pipeline_wait(pipeline_state *state, pipeline_ring *ring, pipeline_stage *stage)
+{
+  pipeline_chunk *chunk = pipeline_pop(ring);
+  if (chunk != NULL)
+  {
+    return chunk;
+  }
+
+  double start = monotonic_seconds();
+  long sleep_ns = 1000;
+  stage->stalls++;
+  for (int spin = 0; (chunk = pipeline_pop(ring)) == NULL; spin++)
+  {
+    if (__atomic_load_n(&state->failed, __ATOMIC_ACQUIRE))
+    {
+      return NULL;
+    }
+    if (spin < PIPELINE_SPIN)
+    {
+#ifdef ADFGVX_X86_SIMD
+      _mm_pause();
+#endif
+    }
+    else if (spin < 2 * PIPELINE_SPIN)
+    {
+      sched_yield();
+    }
+    else
+    {
+      struct timespec pause = {0, sleep_ns};
+      nanosleep(&pause, NULL);
+      if (sleep_ns < PIPELINE_MAX_SLEEP_NS)
+        sleep_ns *= 2;
+    }
+  }
+  stage->stall_seconds += monotonic_seconds() - start;
+  return chunk;
+}
+
+/**
+ * @brief Faixa do histograma de latência: potência de 2 dos nanossegundos, com 4 subfaixas cada.
+ */
+static int pipeline_latency_bucket(unsigned long long ns)
+{
+  if (ns < 4)
+  {
+    return (int)ns;
+  }
+  int msb = 63 - __builtin_clzll(ns);
+  return msb * 4 + (int)((ns >> (msb - 2)) & 3);
+}
+
+/**
+ * @brief Percentil (0 a 1) do histograma de latência, em segundos (limite superior da faixa).
+ */
+double pipeline_latency_percentile(const pipeline_report *report, double percentile)
+{
+  unsigned long long total = 0, seen = 0;
+
+  for (int i = 0; i < PIPELINE_LATENCY_BUCKETS; i++)
+    total += report->latency[i];
+
+  for (int i = 0; i < PIPELINE_LATENCY_BUCKETS; i++)
+  {
+    seen += report->latency[i];
+    if (total > 0 && seen >= percentile * total)
+    {
+      double upper = i < 4 ? i + 1 : (double)((5ULL + i % 4) << (i / 4 - 2));
+      return (upper < report->latency_max * 1e9 ? upper : report->latency_max * 1e9) / 1e9;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Etapa de leitura: preenche cada buffer livre com o que chegou na entrada, até ctx->message_capacity bytes.
+ *
+ * Usa read no descritor (e não fread, que só retorna com o bloco cheio): numa entrada contínua, como um
+ * tail de log, cada linha segue para a cifragem assim que chega. Em arquivos regulares os blocos saem
+ * cheios, como no modo stream sem pipeline. O bloco é marcado com o instante em que os dados chegaram
+ * (o retorno de read), de onde a latência é medida.
+ */
+static void *pipeline_reader_main(void *arg)
+{
+  pipeline_state *state = arg;
+  pipeline_stage *stage = &state->report->reader;
+  pipeline_chunk *chunk;
+
+  while ((chunk = pipeline_wait(state, &state->free, stage)) != NULL)
+  {
+    ssize_t received;
+    do
+      received = read(fileno(state->input), chunk->message, state->ctx->message_capacity);
+    while (received < 0 && errno == EINTR);
+    chunk->ready = monotonic_seconds();
+    if (received < 0)
+    {
+      __atomic_store_n(&state->failed, 1, __ATOMIC_RELEASE);
+      return NULL;
+    }
+    chunk->message_length = (size_t)received;
+
+    // Depois do envio o bloco pertence às etapas seguintes (e pode voltar ao pool)
+    size_t length = chunk->message_length;
+    unsigned depth = pipeline_push(&state->filled, chunk);
+    stage->chunks++;
+    stage->depth_sum += depth;
+    if (depth > stage->depth_max)
+      stage->depth_max = depth;
+    if (length == 0)
+      return NULL;
+    state->report->bytes_in += length;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Etapa de cifragem: cifra cada bloco lido com o contexto (uma única thread usa o contexto).
+ */
+static void *pipeline_encoder_main(void *arg)
+{
+  pipeline_state *state = arg;
+  pipeline_stage *stage = &state->report->encoder;
+  adfgvx_ctx *ctx = state->ctx;
+  pipeline_chunk *chunk;
+
+  while ((chunk = pipeline_wait(state, &state->filled, stage)) != NULL)
+  {
+    if (chunk->message_length > 0)
+    {
+      adfgvx_ctx_reset(ctx);
+      chunk->symbol_count = adfgvx_ctx_encrypt_scheduled(ctx, state->schedule, chunk->message, (int)chunk->message_length, chunk->output,
+                                                         2 * ctx->message_capacity + 1);
+      if (chunk->symbol_count < 0)
+      {
+        __atomic_store_n(&state->failed, 1, __ATOMIC_RELEASE);
+        return NULL;
+      }
+    }
+
+    size_t length = chunk->message_length;
+    unsigned depth = pipeline_push(&state->encrypted, chunk);
+    stage->chunks++;
+    stage->depth_sum += depth;
+    if (depth > stage->depth_max)
+      stage->depth_max = depth;
+    if (length == 0)
+      return NULL;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Cifra uma entrada contínua com um pipeline de três threads: leitura, cifragem e escrita.
+ *
+ * Mesmo formato de cipher_adfgvx_stream (blocos de até ctx->message_capacity bytes com o cabeçalho de
+ * write_stream_chunk), mas as etapas se sobrepõem: enquanto um bloco é cifrado, o seguinte é lido e o
+ * anterior escrito. Cada bloco é o que a entrada entregou de uma vez (ver pipeline_reader_main): com
+ * arquivos regulares, a saída é idêntica à do modo stream; com um pipe, os blocos seguem a chegada dos dados. Os blocos passam por filas SPSC sem lock e voltam à leitura por uma terceira fila,
+ * o pool de chunk_count buffers, que limita a memória e faz a contrapressão: sem buffer livre, a leitura
+ * espera a escrita. A escrita chama fflush sempre que não há outro bloco cifrado na fila, para que uma
+ * entrada lenta (um tail de log) não fique retida no buffer de saída.
+ *
+ * @param ctx Contexto de cifra (usado somente pela thread de cifragem).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input Arquivo de entrada (pode ser stdin; lido pelo descritor, sem o buffer do stdio).
+ * @param output Arquivo de saída (pode ser stdout).
+ * @param chunk_count Quantidade de buffers do pool (pelo menos 2).
+ * @param report Contadores das etapas, vazão e latência (saída; pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 em caso de erro de leitura, escrita, memória ou criação de threads.
+ */
+int cipher_adfgvx_pipeline(adfgvx_ctx *ctx, char key[], int key_length, FILE *input, FILE *output, int chunk_count, pipeline_report *report)
+{
+  static char output_buffer[STREAM_IO_BUFFER_SIZE];
+  char schedule_memory[adfgvx_key_schedule_arena_size(key_length)];
+  adfgvx_arena schedule_arena;
+  adfgvx_key_schedule schedule;
+  pipeline_report local_report;
+  pipeline_state state = {.input = input, .output = output, .ctx = ctx, .schedule = &schedule, .report = report ? report : &local_report};
+  size_t capacity = ctx->message_capacity;
+  unsigned ring_size = 1;
+
+  if (chunk_count < 2)
+  {
+    return 1;
+  }
+  adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+  if (adfgvx_key_schedule_init(&schedule, &schedule_arena, key_length) != 0 ||
+      adfgvx_key_schedule_compile_square(&schedule, key, key_length, ctx->polybius->cells) != 0)
+  {
+    return 1;
+  }
+
+  while (ring_size < (unsigned)chunk_count)
+    ring_size *= 2;
+  pipeline_chunk *chunks = calloc(chunk_count, sizeof(pipeline_chunk));
+  pipeline_chunk **slots = malloc(3 * sizeof(pipeline_chunk *) * ring_size);
+  char *buffers = malloc((size_t)chunk_count * (3 * capacity + 1));
+  if (chunks == NULL || slots == NULL || buffers == NULL)
+  {
+    free(chunks);
+    free(slots);
+    free(buffers);
+    return 1;
+  }
+
+  memset(state.report, 0, sizeof(*state.report));
+  pipeline_ring *rings[] = {&state.filled, &state.encrypted, &state.free};
+  for (int i = 0; i < 3; i++)
+  {
+    rings[i]->mask = ring_size - 1;
+    rings[i]->slots = slots + i * ring_size;
+  }
+  for (int i = 0; i < chunk_count; i++)
+  {
+    chunks[i].message = buffers + (size_t)i * (3 * capacity + 1);
+    chunks[i].output = chunks[i].message + capacity;
+    pipeline_push(&state.free, &chunks[i]);
+  }
+
+  setvbuf(output, output_buffer, _IOFBF, STREAM_IO_BUFFER_SIZE);
+
+  // A cifragem começa antes da leitura: se a leitura não puder ser criada, a cifragem vê failed e termina
+  // (a leitura poderia ficar bloqueada em read numa entrada contínua, sem nunca ver failed)
+  double start = monotonic_seconds();
+  pthread_t reader, encoder;
+  int encoder_started = pthread_create(&encoder, NULL, pipeline_encoder_main, &state) == 0;
+  int reader_started = encoder_started && pthread_create(&reader, NULL, pipeline_reader_main, &state) == 0;
+  if (!reader_started)
+  {
+    __atomic_store_n(&state.failed, 1, __ATOMIC_RELEASE);
+  }
+
+  // Etapa de escrita, na thread chamadora
+  pipeline_report *out = state.report;
+  pipeline_chunk *chunk;
+  while (reader_started)
+  {
+    chunk = pipeline_pop(&state.encrypted);
+    if (chunk == NULL)
+    {
+      // Nada mais na fila: entrega o que já foi escrito antes de esperar
+      if (fflush(output) != 0)
+      {
+        __atomic_store_n(&state.failed, 1, __ATOMIC_RELEASE);
+        break;
+      }
+      chunk = pipeline_wait(&state, &state.encrypted, &out->writer);
+    }
+    if (chunk == NULL || chunk->message_length == 0)
+      break;
+
+    if (write_stream_chunk(output, chunk->output, chunk->symbol_count) != 0)
+    {
+      __atomic_store_n(&state.failed, 1, __ATOMIC_RELEASE);
+      break;
+    }
+    double latency = monotonic_seconds() - chunk->ready;
+    out->latency[pipeline_latency_bucket((unsigned long long)(latency * 1e9))]++;
+    if (latency > out->latency_max)
+      out->latency_max = latency;
+    out->writer.chunks++;
+    out->bytes_out += chunk->symbol_count > 0 ? ADFGVX_STREAM_HEADER_SIZE + chunk->symbol_count : 0;
+    pipeline_push(&state.free, chunk);
+  }
+
+  if (reader_started)
+    pthread_join(reader, NULL);
+  if (encoder_started)
+    pthread_join(encoder, NULL);
+  int failed = state.failed || fflush(output) != 0;
+  out->seconds = monotonic_seconds() - start;
+
+  free(chunks);
+  free(slots);
+  free(buffers);
+  return failed;
+}
+
+/**
+ * @brief Escreve o relatório do pipeline em stderr: vazão, filas, esperas de cada etapa e latência.
+ */
+void write_pipeline_report(const pipeline_report *report)
+{
+  const pipeline_stage *stages[] = {&report->reader, &report->encoder, &report->writer};
+  const char *names[] = {"reader", "encoder", "writer"};
+  double seconds = report->seconds > 0 ? report->seconds : 1e-9;
+
+  fprintf(stderr, "pipeline: %lld chunks, %.3f s, %.2f MB/s in, %.2f MB/s out\n", report->writer.chunks, seconds,
+          report->bytes_in / seconds / 1e6, report->bytes_out / seconds / 1e6);
+  fprintf(stderr, "  queue depth: read->encode avg %.2f max %u, encode->write avg %.2f max %u\n",
+          report->reader.chunks ? (double)report->reader.depth_sum / report->reader.chunks : 0.0, report->reader.depth_max,
+          report->encoder.chunks ? (double)report->encoder.depth_sum / report->encoder.chunks : 0.0, report->encoder.depth_max);
+  for (int i = 0; i < 3; i++)
+  {
+    fprintf(stderr, "  %-7s: %lld stalls, %.1f ms stalled\n", names[i], stages[i]->stalls, stages[i]->stall_seconds * 1e3);
+  }
+  fprintf(stderr, "  latency: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", pipeline_latency_percentile(report, 0.5) * 1e6,
+          pipeline_latency_percentile(report, 0.99) * 1e6, pipeline_latency_percentile(report, 0.999) * 1e6, report->latency_max * 1e6);
+}
+
+/**
+ * @brief Executa o modo stream: ./cipher_adfgvx --stream [entrada] [saída] [--pipeline [--chunks N]]
+ *
+ * Sem argumentos (ou com "-") usa stdin e stdout, o que permite cifrar arquivos grandes via pipe. Com
+ * --pipeline, a leitura, a cifragem e a escrita rodam em threads separadas (ver cipher_adfgvx_pipeline),
+ * com a mesma saída, e o relatório do pipeline é escrito em stderr ao final.
+ *
+ * @param ctx Contexto de cifra.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--stream".
+ * @param argv Argumentos após "--stream".
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int run_stream_mode(adfgvx_ctx *ctx, char key[], int key_length, int argc, char *argv[])
+{
+  FILE *input = stdin, *output = stdout;
+  const char *paths[2] = {"-", "-"};
+  int path_count = 0, pipeline = 0, chunk_count = PIPELINE_CHUNKS;
+
+  for (int i = 0; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--pipeline") == 0)
+      pipeline = 1;
+    else if (strcmp(argv[i], "--chunks") == 0 && i + 1 < argc)
+      chunk_count = atoi(argv[++i]);
+    else if (path_count < 2)
+      paths[path_count++] = argv[i];
+    else
+      chunk_count = 0;
+  }
+  if (chunk_count < 2)
+  {
+    fprintf(stderr, "Usage: --stream [input] [output] [--pipeline [--chunks N]] (N >= 2)\n");
+    return 1;
+  }
+
+  if (strcmp(paths[0], "-") != 0)
+  {
+    input = fopen(paths[0], "rb");
+    if (input == NULL)
+    {
+      perror("Error opening stream input.");
+      return 1;
+    }
+  }
+
+  if (strcmp(paths[1], "-") != 0)
+  {
+    output = fopen(paths[1], "wb");
+    if (output == NULL)
+    {
+      perror("Error opening stream output.");
+      if (input != stdin)
+        fclose(input);
+      return 1;
+    }
+  }
+
+  pipeline_report report;
+  int result = pipeline ? cipher_adfgvx_pipeline(ctx, key, key_length, input, output, chunk_count, &report)
+                        : cipher_adfgvx_stream(ctx, key, key_length, input, output);
+  if (result != 0)
+  {
+    perror("Error while streaming.");
+  }
+  else if (pipeline)
+  {
+    write_pipeline_report(&report);
+  }
+
+  if (input != stdin)
+    fclose(input);
+  if (output != stdout && fclose(output) != 0)
+    result = 1;
+
+  return result;
+}
+
+/**
+ * @brief Adiciona um arquivo à lista de tarefas do modo batch, aumentando a lista quando necessário.
+ *
+ * @param pool Pool com a lista de tarefas.
+ * @param input Caminho do arquivo de entrada.
+ * @param output Caminho do arquivo de saída, ou NULL para usar "<entrada>.enc".
+ * @return int 0 em caso de sucesso, 1 se faltar memória.
+ */
+int batch_add_job(batch_pool *pool, const char *input, const char *output)
+{
+  if (pool->job_count == pool->job_capacity)
+  {
+    int capacity = pool->job_capacity ? 2 * pool->job_capacity : 64;
+    batch_job *jobs = realloc(pool->jobs, sizeof(batch_job) * capacity);
+    if (jobs == NULL)
+    {
+      return 1;
+    }
+    pool->jobs = jobs;
+    pool->job_capacity = capacity;
+  }
+
+  // Os dois caminhos são alocados antes de a tarefa entrar na lista
+  char *input_copy = strdup(input);
+  char *output_copy = output != NULL ? strdup(output) : malloc(strlen(input) + sizeof(BATCH_OUTPUT_SUFFIX));
+  if (input_copy == NULL || output_copy == NULL)
+  {
+    free(input_copy);
+    free(output_copy);
+    return 1;
+  }
+  if (output == NULL)
+  {
+    strcpy(output_copy, input);
+    strcat(output_copy, BATCH_OUTPUT_SUFFIX);
+  }
+
+  batch_job *job = &pool->jobs[pool->job_count];
+  job->input = input_copy;
+  job->output = output_copy;
+  pool->job_count++;
+  return 0;
+}
+
+/**
+ * @brief Monta a lista de tarefas a partir de um diretório ou de um manifesto.
+ *
+ * Diretório: cada arquivo regular (exceto os que já terminam em ".enc") é cifrado em "<arquivo>.enc".
+ * Manifesto: cada linha contém "entrada [saída]"; sem saída, usa "<entrada>.enc".
+ *
+ * @param pool Pool que receberá as tarefas.
+ * @param path Caminho do diretório ou do manifesto.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int batch_collect_jobs(batch_pool *pool, const char *path)
+{
+  struct stat info;
+
+  if (stat(path, &info) != 0)
+  {
+    return 1;
+  }
+
+  if (S_ISDIR(info.st_mode))
+  {
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    char file_path[BATCH_PATH_LENGTH];
+
+    if (dir == NULL)
+    {
+      return 1;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+      size_t name_length = strlen(entry->d_name);
+      size_t suffix_length = strlen(BATCH_OUTPUT_SUFFIX);
+
+      if (name_length >= suffix_length && strcmp(entry->d_name + name_length - suffix_length, BATCH_OUTPUT_SUFFIX) == 0)
+        continue;
+      if (snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name) >= (int)sizeof(file_path))
+        continue;
+      if (stat(file_path, &info) != 0 || !S_ISREG(info.st_mode))
+        continue;
+
+      if (batch_add_job(pool, file_path, NULL) != 0)
+      {
+        closedir(dir);
+        return 1;
+      }
+    }
+    closedir(dir);
+    return 0;
+  }
+
+  FILE *manifest = fopen(path, "r");
+  char line[2 * BATCH_PATH_LENGTH], input[BATCH_PATH_LENGTH], output[BATCH_PATH_LENGTH];
+
+  if (manifest == NULL)
+  {
+    return 1;
+  }
+  while (fgets(line, sizeof(line), manifest) != NULL)
+  {
+    int fields = sscanf(line, "%4095s %4095s", input, output);
+    if (fields < 1)
+      continue;
+
+    if (batch_add_job(pool, input, fields == 2 ? output : NULL) != 0)
+    {
+      fclose(manifest);
+      return 1;
+    }
+  }
+  fclose(manifest);
+  return 0;
+}
+
+/**
+ * @brief Cifra um arquivo do batch com o contexto do worker.
+ *
+ * @param worker Worker que executa a tarefa (contexto e contadores próprios).
+ * @param job Arquivos de entrada e saída.
+ * @return int 0 em caso de sucesso, 1 em caso de erro (arquivo maior que a capacidade, leitura ou escrita).
+ */
+int batch_encrypt_file(batch_worker *worker, batch_job *job)
+{
+  adfgvx_ctx *ctx = &worker->ctx;
+  FILE *input = fopen(job->input, "rb");
+
+  if (input == NULL)
+  {
+    return 1;
+  }
+
+  adfgvx_ctx_reset(ctx);
+  ctx->message_length = fread(ctx->message, 1, ctx->message_capacity, input);
+  int too_large = fgetc(input) != EOF;
+  fclose(input);
+
+  if (too_large)
+  {
+    return 1;
+  }
+
+  int symbol_count = adfgvx_ctx_encrypt_scheduled(ctx, &worker->pool->schedule, ctx->message, ctx->message_length, ctx->output, 2 * ctx->message_capacity + 1);
+  if (symbol_count < 0)
+  {
+    return 1;
+  }
+
+  FILE *output = fopen(job->output, "wb");
+  if (output == NULL)
+  {
+    return 1;
+  }
+  int written = fwrite(ctx->output, 1, symbol_count, output) == (size_t)symbol_count;
+  if (fclose(output) != 0 || !written)
+  {
+    return 1;
+  }
+
+  worker->bytes_in += ctx->message_length;
+  worker->bytes_out += symbol_count;
+  return 0;
+}
+
+/**
+ * @brief Retira a próxima tarefa da fila do próprio worker ou, se ela estiver vazia, rouba uma tarefa
+ * do final da fila de outro worker.
+ *
+ * @param worker Worker que procura trabalho.
+ * @return int Índice da tarefa, ou -1 se todas as filas estiverem vazias.
+ */
+int batch_next_job(batch_worker *worker)
+{
+  batch_pool *pool = worker->pool;
+  int job = -1;
+
+  // Fila própria: retira do início
+  pthread_mutex_lock(&worker->lock);
+  if (worker->head < worker->tail)
+    job = worker->head++;
+  pthread_mutex_unlock(&worker->lock);
+
+  // Roubo: retira do final da fila de outro worker, começando pelo vizinho
+  for (int i = 1; job < 0 && i < pool->worker_count; i++)
+  {
+    batch_worker *victim = &pool->workers[(worker->index + i) % pool->worker_count];
+
+    pthread_mutex_lock(&victim->lock);
+    if (victim->head < victim->tail)
+      job = --victim->tail;
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return job;
+}
+
+/**
+ * @brief Laço de cada thread do modo batch: executa tarefas até todas as filas ficarem vazias.
+ */
+void *batch_worker_main(void *arg)
+{
+  batch_worker *worker = arg;
+  int job;
+
+  while ((job = batch_next_job(worker)) >= 0)
+  {
+    if (batch_encrypt_file(worker, &worker->pool->jobs[job]) == 0)
+    {
+      worker->files++;
+    }
+    else
+    {
+      fprintf(stderr, "Error encrypting '%s'.\n", worker->pool->jobs[job].input);
+      worker->failures++;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Descarta do cache de páginas os arquivos de entrada do batch (opção --cold).
+ *
+ * Usa posix_fadvise(POSIX_FADV_DONTNEED), que não exige root; páginas sujas só são descartadas depois
+ * de gravadas, por isso os arquivos são sincronizados antes.
+ *
+ * @param pool Pool com a lista de tarefas.
+ */
+void batch_drop_cache(batch_pool *pool)
+{
+  for (int i = 0; i < pool->job_count; i++)
+  {
+    int fd = open(pool->jobs[i].input, O_RDONLY);
+    if (fd < 0)
+      continue;
+
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+#ifdef BATCH_IO_URING
+// Operações do motor io_uring, guardadas nos 3 bits baixos do user_data (o slot fica nos demais)
+#define BATCH_OP_OPEN_INPUT 0
+#define BATCH_OP_READ 1
+#define BATCH_OP_CLOSE_INPUT 2
+#define BATCH_OP_ENCRYPT 3
+#define BATCH_OP_OPEN_OUTPUT 4
+#define BATCH_OP_WRITE 5
+#define BATCH_OP_CLOSE_OUTPUT 6
+#define BATCH_OP_EVENT 7
+
+/**
+ * @brief Cria o anel do io_uring com pelo menos entries posições e mapeia as filas.
+ *
+ * @param ring Anel (saída).
+ * @param entries Quantidade de posições da fila de submissão.
+ * @return int 0 em caso de sucesso, -1 se o kernel não tiver io_uring (ou ele estiver desativado), com errno.
+ */
+int batch_ring_init(batch_ring *ring, unsigned entries)
+{
+  struct io_uring_params params;
+
+  memset(ring, 0, sizeof(*ring));
+  memset(&params, 0, sizeof(params));
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd < 0)
+  {
+    return -1;
+  }
+  // IORING_OP_OPENAT, IORING_OP_CLOSE, IORING_OP_READ e IORING_OP_WRITE chegaram junto com este recurso (5.6)
+  if (!(params.features & IORING_FEAT_RW_CUR_POS))
+  {
+    close(ring->fd);
+    errno = ENOSYS;
+    return -1;
+  }
+
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    if (ring->cq_ring_size > ring->sq_ring_size)
+      ring->sq_ring_size = ring->cq_ring_size;
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  ring->cq_ring = ring->sq_ring;
+  if (ring->sq_ring != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+  if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+  {
+    int error = errno;
+    if (ring->sqes != MAP_FAILED)
+      munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring)
+      munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring != MAP_FAILED)
+      munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    errno = error;
+    return -1;
+  }
+
+  char *sq = ring->sq_ring, *cq = ring->cq_ring;
+  ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+  ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+  ring->sq_entries = params.sq_entries;
+  return 0;
+}
+
+/**
+ * @brief Desfaz os mapeamentos e fecha o anel.
+ */
+void batch_ring_close(batch_ring *ring)
+{
+  munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  munmap(ring->sq_ring, ring->sq_ring_size);
+  close(ring->fd);
+}
+
+/**
+ * @brief Envia as SQEs preenchidas e, com wait_count > 0, espera essa quantidade de conclusões.
+ *
+ * @return int 0 em caso de sucesso, -1 em caso de erro (errno).
+ */
+int batch_ring_submit(batch_ring *ring, unsigned wait_count)
+{
+  for (;;)
+  {
+    int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, wait_count, wait_count > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if (submitted >= 0)
+    {
+      ring->to_submit -= (unsigned)submitted;
+      return 0;
+    }
+    if (errno != EINTR)
+    {
+      return -1;
+    }
+  }
+}
+
+/**
+ * @brief Preenche a próxima SQE (enviando as anteriores se a fila estiver cheia).
+ *
+ * @param ring Anel.
+ * @param opcode Operação IORING_OP_*.
+ * @param fd Descritor (ou AT_FDCWD em IORING_OP_OPENAT).
+ * @param address Buffer ou caminho.
+ * @param length Tamanho do buffer.
+ * @param offset Posição no arquivo.
+ * @param user_data Slot e operação, devolvidos na conclusão.
+ * @return struct io_uring_sqe* SQE preenchida (campos específicos podem ser ajustados antes do envio), ou
+ * NULL se a fila estava cheia e o envio das anteriores falhou (errno).
+ */
+struct io_uring_sqe *batch_ring_prepare(batch_ring *ring, int opcode, int fd, const void *address, unsigned length, unsigned long long offset, unsigned long long user_data)
+{
+  unsigned tail = *ring->sq_tail;
+
+  while (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) == ring->sq_entries)
+  {
+    if (batch_ring_submit(ring, 0) != 0)
+    {
+      return NULL;
+    }
+  }
+
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = (unsigned char)opcode;
+  sqe->fd = fd;
+  sqe->addr = (unsigned long long)(uintptr_t)address;
+  sqe->len = length;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  ring->sq_array[index] = index;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ring->to_submit++;
+  return sqe;
+}
+
+/**
+ * @brief batch_ring_prepare no anel do motor; uma falha fica em engine->error e encerra o motor.
+ *
+ * Um fechamento que não pôde ser enviado é feito na hora, para não perder o descritor.
+ *
+ * @return struct io_uring_sqe* SQE preenchida, ou NULL em caso de erro.
+ */
+static struct io_uring_sqe *batch_uring_prepare(batch_uring *engine, int opcode, int fd, const void *address, unsigned length, unsigned long long offset,
+                                                unsigned long long user_data)
+{
+  struct io_uring_sqe *sqe = batch_ring_prepare(&engine->ring, opcode, fd, address, length, offset, user_data);
+
+  if (sqe == NULL)
+  {
+    if (engine->error == 0)
+      engine->error = errno;
+    if (opcode == IORING_OP_CLOSE)
+      close(fd);
+  }
+  return sqe;
+}
+
+/**
+ * @brief Coloca um índice de slot em uma fila circular do motor (chamar com engine->lock).
+ */
+static void batch_uring_push(batch_uring *engine, int *queue, int *tail, int slot)
+{
+  queue[*tail % engine->slot_count] = slot;
+  (*tail)++;
+}
+
+/**
+ * @brief Laço dos workers do motor io_uring: cifra os arquivos já lidos e os devolve ao anel.
+ */
+void *batch_uring_worker_main(void *arg)
+{
+  batch_worker *worker = arg;
+  batch_uring *engine = (batch_uring *)worker->pool->uring;
+  uint64_t one = 1;
+
+  for (;;)
+  {
+    pthread_mutex_lock(&engine->lock);
+    while (engine->encrypt_head == engine->encrypt_tail && !engine->stop)
+      pthread_cond_wait(&engine->ready, &engine->lock);
+    if (engine->encrypt_head == engine->encrypt_tail)
+    {
+      pthread_mutex_unlock(&engine->lock);
+      return NULL;
+    }
+    int index = engine->encrypt_queue[engine->encrypt_head++ % engine->slot_count];
+    pthread_mutex_unlock(&engine->lock);
+
+    batch_slot *slot = &engine->slots[index];
+    adfgvx_ctx_reset(&worker->ctx);
+    slot->symbol_count = adfgvx_ctx_encrypt_scheduled(&worker->ctx, &worker->pool->schedule, slot->message, (int)slot->message_length,
+                                                      slot->output, 2 * worker->ctx.message_capacity + 1);
+
+    pthread_mutex_lock(&engine->lock);
+    batch_uring_push(engine, engine->done_queue, &engine->done_tail, index);
+    pthread_mutex_unlock(&engine->lock);
+    if (write(engine->event_fd, &one, sizeof(one)) != sizeof(one))
+    {
+      // O contador do eventfd só satura em 2^64 - 1; a leitura pendente já foi acordada
+    }
+  }
+}
+
+/**
+ * @brief Começa o próximo arquivo da lista no slot (abertura da entrada), se ainda houver arquivos e o
+ * motor não tiver falhado.
+ */
+static void batch_uring_start(batch_uring *engine, int index)
+{
+  batch_slot *slot = &engine->slots[index];
+
+  if (engine->error != 0 || engine->next_job >= engine->pool->job_count)
+  {
+    slot->job = -1;
+    return;
+  }
+
+  slot->job = engine->next_job++;
+  slot->state = BATCH_OP_OPEN_INPUT;
+  slot->fd = -1;
+  slot->failed = 0;
+  slot->message_length = 0;
+  slot->written = 0;
+  struct io_uring_sqe *sqe = batch_uring_prepare(engine, IORING_OP_OPENAT, AT_FDCWD, engine->pool->jobs[slot->job].input, 0, 0,
+                                                 (unsigned long long)index << 3 | BATCH_OP_OPEN_INPUT);
+  if (sqe != NULL)
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+}
+
+/**
+ * @brief Encerra o arquivo do slot (contadores e mensagem de erro) e começa o próximo no mesmo slot.
+ */
+static void batch_uring_finish(batch_uring *engine, int index)
+{
+  batch_slot *slot = &engine->slots[index];
+
+  if (slot->fd >= 0)
+  {
+    batch_uring_prepare(engine, IORING_OP_CLOSE, slot->fd, NULL, 0, 0, (unsigned long long)index << 3 | BATCH_OP_CLOSE_INPUT);
+    slot->fd = -1;
+  }
+
+  if (slot->failed)
+  {
+    fprintf(stderr, "Error encrypting '%s'.\n", engine->pool->jobs[slot->job].input);
+    engine->failures++;
+  }
+  else
+  {
+    engine->files++;
+    engine->bytes_in += slot->message_length;
+    engine->bytes_out += slot->symbol_count;
+  }
+  engine->finished++;
+  batch_uring_start(engine, index);
+}
+
+/**
+ * @brief Avança o slot com o resultado da operação concluída (uma etapa da máquina de estados).
+ *
+ * Abrir a entrada -> ler até o fim (várias leituras se preciso) -> fechar (sem esperar) e entregar aos
+ * workers -> abrir a saída -> escrever até o fim -> fechar a saída. Qualquer erro encerra o arquivo.
+ *
+ * @param engine Motor io_uring.
+ * @param index Slot da operação.
+ * @param op Operação concluída (BATCH_OP_*).
+ * @param result Resultado da operação (res da CQE: descritor, bytes ou -errno).
+ */
+static void batch_uring_advance(batch_uring *engine, int index, int op, int result)
+{
+  batch_slot *slot = &engine->slots[index];
+  size_t capacity = (size_t)engine->pool->workers[0].ctx.message_capacity;
+
+  if (op == BATCH_OP_CLOSE_INPUT)
+    return;
+
+  if (result < 0 || (op == BATCH_OP_WRITE && result == 0))
+  {
+    slot->failed = 1;
+    batch_uring_finish(engine, index);
+    return;
+  }
+
+  switch (op)
+  {
+  case BATCH_OP_OPEN_INPUT:
+    slot->fd = result;
+    result = 0;
+    // Lê até capacity + 1 bytes: um byte a mais indica um arquivo maior que a capacidade
+    /* fall through */
+  case BATCH_OP_READ:
+    slot->message_length += (size_t)result;
+    if (slot->message_length > capacity)
+    {
+      slot->failed = 1;
+      batch_uring_finish(engine, index);
+    }
+    else if (result > 0 || slot->state == BATCH_OP_OPEN_INPUT)
+    {
+      slot->state = BATCH_OP_READ;
+      batch_uring_prepare(engine, IORING_OP_READ, slot->fd, slot->message + slot->message_length, (unsigned)(capacity + 1 - slot->message_length),
+                          slot->message_length, (unsigned long long)index << 3 | BATCH_OP_READ);
+    }
+    else
+    {
+      // Fim do arquivo: fecha a entrada sem esperar e entrega a mensagem aos workers
+      batch_uring_prepare(engine, IORING_OP_CLOSE, slot->fd, NULL, 0, 0, (unsigned long long)index << 3 | BATCH_OP_CLOSE_INPUT);
+      slot->fd = -1;
+      slot->state = BATCH_OP_ENCRYPT;
+      pthread_mutex_lock(&engine->lock);
+      batch_uring_push(engine, engine->encrypt_queue, &engine->encrypt_tail, index);
+      pthread_cond_signal(&engine->ready);
+      pthread_mutex_unlock(&engine->lock);
+    }
+    break;
+
+  case BATCH_OP_ENCRYPT:
+    if (slot->symbol_count < 0)
+    {
+      slot->failed = 1;
+      batch_uring_finish(engine, index);
+      break;
+    }
+    slot->state = BATCH_OP_OPEN_OUTPUT;
+    struct io_uring_sqe *sqe = batch_uring_prepare(engine, IORING_OP_OPENAT, AT_FDCWD, engine->pool->jobs[slot->job].output, 0, 0,
+                                                   (unsigned long long)index << 3 | BATCH_OP_OPEN_OUTPUT);
+    if (sqe != NULL)
+    {
+      sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+      sqe->len = 0666;
+    }
+    break;
+
+  case BATCH_OP_OPEN_OUTPUT:
+    slot->fd = result;
+    result = 0;
+    /* fall through */
+  case BATCH_OP_WRITE:
+    slot->written += (size_t)result;
+    if (slot->written < (size_t)slot->symbol_count)
+    {
+      slot->state = BATCH_OP_WRITE;
+      batch_uring_prepare(engine, IORING_OP_WRITE, slot->fd, slot->output + slot->written, (unsigned)(slot->symbol_count - slot->written),
+                          slot->written, (unsigned long long)index << 3 | BATCH_OP_WRITE);
+    }
+    else
+    {
+      // O fechamento da saída é esperado: um erro nele (como no fclose) falha o arquivo
+      slot->state = BATCH_OP_CLOSE_OUTPUT;
+      batch_uring_prepare(engine, IORING_OP_CLOSE, slot->fd, NULL, 0, 0, (unsigned long long)index << 3 | BATCH_OP_CLOSE_OUTPUT);
+      slot->fd = -1;
+    }
+    break;
+
+  case BATCH_OP_CLOSE_OUTPUT:
+    batch_uring_finish(engine, index);
+    break;
+  }
+}
+
+/**
+ * @brief Executa as tarefas do pool com o motor io_uring.
+ *
+ * Até slot_count arquivos ficam em andamento ao mesmo tempo: as aberturas, leituras, escritas e
+ * fechamentos são enviados ao anel sem bloquear, e a thread principal só dorme em io_uring_enter
+ * esperando conclusões. Os arquivos lidos são cifrados pelos workers do pool (cada um com o seu contexto).
+ *
+ * @param pool Pool com as tarefas e os workers já inicializados.
+ * @param slot_count Quantidade de arquivos em andamento.
+ * @return int 0 se as tarefas foram executadas (um erro do anel no meio da execução conta os arquivos não
+ * concluídos como falhas), -1 se o io_uring não estiver disponível ou nenhum worker pôde ser criado (nada
+ * foi executado; errno).
+ */
+int batch_run_uring(batch_pool *pool, int slot_count)
+{
+  batch_uring engine = {0};
+  size_t capacity = (size_t)pool->workers[0].ctx.message_capacity;
+
+  // Cada slot tem no máximo duas operações pendentes (o fechamento da entrada e a etapa seguinte)
+  if (batch_ring_init(&engine.ring, 2 * (unsigned)slot_count + 1) != 0)
+  {
+    return -1;
+  }
+
+  engine.pool = pool;
+  engine.slot_count = slot_count;
+  engine.event_fd = eventfd(0, EFD_CLOEXEC);
+  engine.slots = calloc(slot_count, sizeof(batch_slot));
+  engine.encrypt_queue = malloc(sizeof(int) * slot_count);
+  engine.done_queue = malloc(sizeof(int) * slot_count);
+  char *buffers = malloc((size_t)slot_count * (3 * capacity + 2));
+  if (engine.event_fd < 0 || engine.slots == NULL || engine.encrypt_queue == NULL || engine.done_queue == NULL || buffers == NULL)
+  {
+    int error = errno;
+    if (engine.event_fd >= 0)
+      close(engine.event_fd);
+    free(engine.slots);
+    free(engine.encrypt_queue);
+    free(engine.done_queue);
+    free(buffers);
+    batch_ring_close(&engine.ring);
+    errno = error;
+    return -1;
+  }
+  pthread_mutex_init(&engine.lock, NULL);
+  pthread_cond_init(&engine.ready, NULL);
+  pool->uring = &engine;
+
+  // Sem nenhum worker nada seria cifrado e o anel esperaria para sempre: desiste antes de enviar qualquer operação
+  int started = 0, error = 0;
+  while (started < pool->worker_count &&
+         (error = pthread_create(&pool->workers[started].thread, NULL, batch_uring_worker_main, &pool->workers[started])) == 0)
+    started++;
+  if (started == 0)
+  {
+    pool->uring = NULL;
+    pthread_cond_destroy(&engine.ready);
+    pthread_mutex_destroy(&engine.lock);
+    close(engine.event_fd);
+    free(engine.slots);
+    free(engine.encrypt_queue);
+    free(engine.done_queue);
+    free(buffers);
+    batch_ring_close(&engine.ring);
+    errno = error;
+    return -1;
+  }
+  if (started < pool->worker_count)
+    fprintf(stderr, "Started %d of %d batch threads.\n", started, pool->worker_count);
+
+  // Uma leitura sempre pendente em event_fd acorda o anel quando um worker termina uma cifragem
+  batch_uring_prepare(&engine, IORING_OP_READ, engine.event_fd, &engine.event_value, sizeof(engine.event_value), 0, BATCH_OP_EVENT);
+  for (int i = 0; i < slot_count; i++)
+  {
+    engine.slots[i].message = buffers + (size_t)i * (3 * capacity + 2);
+    engine.slots[i].output = engine.slots[i].message + capacity + 1;
+    batch_uring_start(&engine, i);
+  }
+
+  while (engine.finished < pool->job_count && engine.error == 0)
+  {
+    if (batch_ring_submit(&engine.ring, 1) != 0)
+    {
+      engine.error = errno;
+      break;
+    }
+
+    unsigned head = *engine.ring.cq_head;
+    while (head != __atomic_load_n(engine.ring.cq_tail, __ATOMIC_ACQUIRE))
+    {
+      struct io_uring_cqe *cqe = &engine.ring.cqes[head & *engine.ring.cq_mask];
+      unsigned long long user_data = cqe->user_data;
+      int result = cqe->res;
+
+      __atomic_store_n(engine.ring.cq_head, ++head, __ATOMIC_RELEASE);
+      if ((user_data & 7) != BATCH_OP_EVENT)
+      {
+        batch_uring_advance(&engine, (int)(user_data >> 3), (int)(user_data & 7), result);
+        continue;
+      }
+
+      // Workers terminaram cifragens: retoma cada slot devolvido e arma de novo a leitura do eventfd
+      for (;;)
+      {
+        pthread_mutex_lock(&engine.lock);
+        int index = engine.done_head == engine.done_tail ? -1 : engine.done_queue[engine.done_head++ % slot_count];
+        pthread_mutex_unlock(&engine.lock);
+        if (index < 0)
+          break;
+        batch_uring_advance(&engine, index, BATCH_OP_ENCRYPT, 0);
+      }
+      batch_uring_prepare(&engine, IORING_OP_READ, engine.event_fd, &engine.event_value, sizeof(engine.event_value), 0, BATCH_OP_EVENT);
+    }
+  }
+
+  // Com o anel com erro, os arquivos em andamento falham e os que não começaram entram na contagem de falhas
+  if (engine.error != 0)
+  {
+    errno = engine.error;
+    perror("io_uring_enter");
+    for (int i = 0; i < slot_count; i++)
+    {
+      if (engine.slots[i].job >= 0)
+        fprintf(stderr, "Error encrypting '%s'.\n", pool->jobs[engine.slots[i].job].input);
+    }
+  }
+
+  pthread_mutex_lock(&engine.lock);
+  engine.stop = 1;
+  pthread_cond_broadcast(&engine.ready);
+  pthread_mutex_unlock(&engine.lock);
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+
+  // Os contadores do motor ficam no primeiro worker, somados como os dos outros motores
+  pool->workers[0].files = engine.files;
+  pool->workers[0].failures = engine.failures + (pool->job_count - engine.finished);
+  pool->workers[0].bytes_in = engine.bytes_in;
+  pool->workers[0].bytes_out = engine.bytes_out;
+  pool->uring = NULL;
+
+  // Fechar o anel cancela a leitura pendente do eventfd e os fechamentos ainda não concluídos
+  batch_ring_close(&engine.ring);
+  for (int i = 0; i < slot_count && engine.error != 0; i++)
+  {
+    if (engine.slots[i].job >= 0 && engine.slots[i].fd >= 0)
+      close(engine.slots[i].fd);
+  }
+  close(engine.event_fd);
+  pthread_cond_destroy(&engine.ready);
+  pthread_mutex_destroy(&engine.lock);
+  free(engine.slots);
+  free(engine.encrypt_queue);
+  free(engine.done_queue);
+  free(buffers);
+  return 0;
+}
+#endif
+
+/**
+ * @brief Executa o modo batch: ./cipher_adfgvx --batch <diretório|manifesto> [--threads N] [--engine uring|threads|sequential] [--depth D] [--cold]
+ *
+ * Motores:
+ * - uring (padrão no Linux): até D arquivos em andamento no io_uring (ver batch_run_uring), cifrados por N
+ *   workers. Sem io_uring no kernel (ou desativado), usa o motor threads.
+ * - threads: as tarefas são divididas em partes iguais entre as filas dos workers, e workers sem trabalho
+ *   roubam tarefas das filas dos outros; cada worker lê, cifra e escreve com E/S bloqueante.
+ * - sequential: um arquivo por vez na thread principal (referência para as medições).
+ * Cada worker tem o seu próprio contexto de cifra (arena própria). Com --cold, as entradas são descartadas
+ * do cache de páginas antes da execução. Ao final, informa arquivos/s e MB/s em stderr.
+ *
+ * @param ctx Contexto principal (define as capacidades dos contextos dos workers).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--batch".
+ * @param argv Argumentos após "--batch".
+ * @return int 0 se todos os arquivos foram cifrados, 1 caso contrário.
+ */
+int run_batch_mode(adfgvx_ctx *ctx, char key[], int key_length, int argc, char *argv[])
+{
+  batch_pool pool = {0};
+  int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int depth = BATCH_URING_DEPTH, cold = 0;
+#ifdef BATCH_IO_URING
+  const char *engine = "uring";
+#else
+  const char *engine = "threads";
+#endif
+  int result = 0, valid = argc >= 1;
+
+  for (int i = 1; i < argc && valid; i++)
+  {
+    if (strcmp(argv[i], "--cold") == 0)
+      cold = 1;
+    else if (i + 1 >= argc)
+      valid = 0;
+    else if (strcmp(argv[i], "--threads") == 0)
+      thread_count = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--engine") == 0)
+      engine = argv[++i];
+    else if (strcmp(argv[i], "--depth") == 0)
+      depth = atoi(argv[++i]);
+    else
+      valid = 0;
+  }
+  if (strcmp(engine, "uring") != 0 && strcmp(engine, "threads") != 0 && strcmp(engine, "sequential") != 0)
+    valid = 0;
+  if (!valid || thread_count <= 0 || thread_count > ADFGVX_MAX_THREADS || depth <= 0)
+  {
+    fprintf(stderr, "Usage: --batch <directory|manifest> [--threads N] [--engine uring|threads|sequential] [--depth D] [--cold]\n");
+    return 1;
+  }
+
+#ifndef BATCH_IO_URING
+  if (strcmp(engine, "uring") == 0)
+  {
+    fprintf(stderr, "io_uring not available on this platform, using thread pool.\n");
+    engine = "threads";
+  }
+#endif
+  if (strcmp(engine, "sequential") == 0)
+    thread_count = 1;
+
+  // A chave é compilada uma vez; os workers só calculam as posições das colunas de cada arquivo
+  char schedule_memory[adfgvx_key_schedule_arena_size(key_length)];
+  adfgvx_arena schedule_arena;
+
+  adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+  if (adfgvx_key_schedule_init(&pool.schedule, &schedule_arena, key_length) != 0 ||
+      adfgvx_key_schedule_compile_square(&pool.schedule, key, key_length, ctx->polybius->cells) != 0)
+  {
+    fprintf(stderr, "Error compiling key.\n");
+    return 1;
+  }
+
+  if (batch_collect_jobs(&pool, argv[0]) != 0)
+  {
+    perror("Error reading batch directory or manifest.");
+    result = 1;
+    goto cleanup;
+  }
+  if (cold)
+  {
+    batch_drop_cache(&pool);
+  }
+
+  pool.worker_count = thread_count < pool.job_count ? thread_count : (pool.job_count > 0 ? pool.job_count : 1);
+  if (depth > pool.job_count)
+    depth = pool.job_count > 0 ? pool.job_count : 1;
+  pool.workers = calloc(pool.worker_count, sizeof(batch_worker));
+  if (pool.workers == NULL)
+  {
+    result = 1;
+    goto cleanup;
+  }
+
+  // Cada worker recebe uma faixa contígua de tarefas e um contexto com arena própria
+  size_t arena_size = adfgvx_ctx_arena_size(ctx->message_capacity, ctx->key_capacity);
+  for (int i = 0; i < pool.worker_count; i++)
+  {
+    batch_worker *worker = &pool.workers[i];
+
+    worker->pool = &pool;
+    worker->index = i;
+    worker->head = (int)((long long)pool.job_count * i / pool.worker_count);
+    worker->tail = (int)((long long)pool.job_count * (i + 1) / pool.worker_count);
+    worker->arena_memory = malloc(arena_size);
+    pthread_mutex_init(&worker->lock, NULL);
+
+    if (worker->arena_memory == NULL)
+    {
+      result = 1;
+      goto cleanup;
+    }
+    adfgvx_arena_init(&worker->arena, worker->arena_memory, arena_size);
+    adfgvx_ctx_init(&worker->ctx, &worker->arena, ctx->message_capacity, ctx->key_capacity);
+  }
+
+  double start = monotonic_seconds();
+#ifdef BATCH_IO_URING
+  if (strcmp(engine, "uring") == 0 && batch_run_uring(&pool, depth) != 0)
+  {
+    fprintf(stderr, "io_uring engine unavailable (%s), using thread pool.\n", strerror(errno));
+    engine = "threads";
+  }
+#endif
+  if (strcmp(engine, "sequential") == 0)
+  {
+    batch_worker_main(&pool.workers[0]);
+  }
+  else if (strcmp(engine, "threads") == 0)
+  {
+    int started = 0;
+    while (started < pool.worker_count &&
+           pthread_create(&pool.workers[started].thread, NULL, batch_worker_main, &pool.workers[started]) == 0)
+      started++;
+    // As filas dos workers que não iniciaram são esvaziadas por roubo; sem nenhuma thread, a principal as processa
+    if (started < pool.worker_count)
+      fprintf(stderr, "Started %d of %d batch threads.\n", started, pool.worker_count);
+    if (started == 0)
+      batch_worker_main(&pool.workers[0]);
+    for (int i = 0; i < started; i++)
+      pthread_join(pool.workers[i].thread, NULL);
+  }
+
+  int files = 0, failures = 0;
+  long long bytes_in = 0, bytes_out = 0;
+  for (int i = 0; i < pool.worker_count; i++)
+  {
+    files += pool.workers[i].files;
+    failures += pool.workers[i].failures;
+    bytes_in += pool.workers[i].bytes_in;
+    bytes_out += pool.workers[i].bytes_out;
+  }
+  double elapsed = monotonic_seconds() - start;
+  if (elapsed <= 0)
+    elapsed = 1e-9;
+
+  fprintf(stderr, "batch: %s, %d files, %d failed, %d threads, %.3f s, %.1f files/s, %.2f MB/s in, %.2f MB/s out\n",
+          engine, files, failures, pool.worker_count, elapsed, files / elapsed, bytes_in / elapsed / 1e6, bytes_out / elapsed / 1e6);
+  result = failures > 0;
+
+cleanup:
+  if (pool.workers != NULL)
+  {
+    for (int i = 0; i < pool.worker_count; i++)
+    {
+      free(pool.workers[i].arena_memory);
+      pthread_mutex_destroy(&pool.workers[i].lock);
+    }
+    free(pool.workers);
+  }
+  for (int i = 0; i < pool.job_count; i++)
+  {
+    free(pool.jobs[i].input);
+    free(pool.jobs[i].output);
+  }
+  free(pool.jobs);
+  return result;
+}
+
+/**
+ * @brief Lê toda a entrada (pipe ou arquivo) para um buffer alocado, em blocos de STREAM_IO_BUFFER_SIZE.
+ *
+ * Usado quando a entrada não pode ser mapeada em memória.
+ *
+ * @param input Arquivo de entrada.
+ * @param length Tamanho lido (saída).
+ * @return char* Buffer com o conteúdo (liberar com free), ou NULL em caso de erro.
+ */
+char *read_whole_file(FILE *input, size_t *length)
+{
+  size_t capacity = STREAM_IO_BUFFER_SIZE, used = 0, read_count;
+  char *buffer = malloc(capacity);
+
+  while (buffer != NULL && (read_count = fread(buffer + used, 1, capacity - used, input)) > 0)
+  {
+    used += read_count;
+    if (used == capacity)
+    {
+      char *grown = realloc(buffer, capacity * 2);
+      if (grown == NULL)
+      {
+        free(buffer);
+        return NULL;
+      }
+      buffer = grown;
+      capacity *= 2;
+    }
+  }
+
+  if (buffer != NULL && ferror(input))
+  {
+    free(buffer);
+    return NULL;
+  }
+  *length = used;
+  return buffer;
+}
+
+/**
+ * @brief Cifra um arquivo usando mmap na entrada e na saída, sem stdio e sem chamadas por byte.
+ *
+ * A entrada é mapeada se for um arquivo regular; caso contrário (pipe, "-") é lida inteira com
+ * read_whole_file. A saída é criada com o tamanho exato (2 símbolos por caractere válido) e mapeada;
+ * com "-" o texto cifrado é escrito em stdout com um único fwrite. A contagem e a cifragem são
+ * divididas entre thread_count threads (ver adfgvx_parallel_count).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input_path Caminho da entrada ("-" para stdin).
+ * @param output_path Caminho da saída ("-" para stdout).
+ * @param thread_count Quantidade máxima de threads.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int cipher_adfgvx_mapped(const polybius_square *polybius, char key[], int key_length, const char *input_path, const char *output_path, int thread_count)
+{
+  const char *message = NULL;
+  char *read_buffer = NULL, *output = NULL;
+  size_t message_length = 0;
+  int input_fd = -1, output_fd = -1, result = 1;
+  struct stat info;
+  char schedule_memory[adfgvx_key_schedule_arena_size(key_length)];
+  adfgvx_arena schedule_arena;
+  adfgvx_key_schedule schedule;
+  adfgvx_parallel_plan plan;
+
+  adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+  if (adfgvx_key_schedule_init(&schedule, &schedule_arena, key_length) != 0 ||
+      adfgvx_key_schedule_compile_square(&schedule, key, key_length, polybius->cells) != 0)
+  {
+    return 1;
+  }
+
+  if (strcmp(input_path, "-") != 0 && (input_fd = open(input_path, O_RDONLY)) < 0)
+  {
+    return 1;
+  }
+
+  if (input_fd >= 0 && fstat(input_fd, &info) == 0 && S_ISREG(info.st_mode))
+  {
+    message_length = info.st_size;
+    if (message_length > 0)
+    {
+      message = mmap(NULL, message_length, PROT_READ, MAP_PRIVATE, input_fd, 0);
+      if (message == MAP_FAILED)
+      {
+        message = NULL;
+        goto cleanup;
+      }
+      madvise((void *)message, message_length, MADV_SEQUENTIAL);
+    }
+  }
+  else
+  {
+    // Fallback para pipes: leitura bufferizada de toda a entrada
+    FILE *input = input_fd >= 0 ? fdopen(input_fd, "rb") : stdin;
+    if (input == NULL || (read_buffer = read_whole_file(input, &message_length)) == NULL)
+      goto cleanup;
+    message = read_buffer;
+  }
+
+  // Passo de contagem (paralelo): fixa o tamanho exato do texto cifrado e o primeiro símbolo de cada trecho
+  size_t symbol_count = adfgvx_parallel_count(&plan, &schedule, message, message_length, thread_count);
+
+  if (strcmp(output_path, "-") == 0)
+  {
+    output = malloc(symbol_count ? symbol_count : 1);
+    if (output == NULL)
+      goto cleanup;
+
+    adfgvx_parallel_encrypt(&plan, &schedule, message, output);
+    result = fwrite(output, 1, symbol_count, stdout) != symbol_count || fflush(stdout) != 0;
+    free(output);
+    output = NULL;
+    goto cleanup;
+  }
+
+  output_fd = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (output_fd < 0 || ftruncate(output_fd, symbol_count) != 0)
+    goto cleanup;
+
+  if (symbol_count > 0)
+  {
+    output = mmap(NULL, symbol_count, PROT_READ | PROT_WRITE, MAP_SHARED, output_fd, 0);
+    if (output == MAP_FAILED)
+    {
+      output = NULL;
+      goto cleanup;
+    }
+
+    adfgvx_parallel_encrypt(&plan, &schedule, message, output);
+    munmap(output, symbol_count);
+  }
+  result = close(output_fd) != 0;
+  output_fd = -1;
+
+cleanup:
+  if (output_fd >= 0)
+    close(output_fd);
+  if (read_buffer != NULL)
+    free(read_buffer);
+  else if (message != NULL)
+    munmap((void *)message, message_length);
+  if (input_fd >= 0)
+    close(input_fd);
+  return result;
+}
+
+/**
+ * @brief Executa o modo mmap: ./cipher_adfgvx --mmap <entrada> <saída> [--threads N] ("-" para stdin/stdout)
+ *
+ * Diferente do modo stream, a entrada inteira é cifrada como uma única mensagem, sem limite de
+ * capacidade. Por padrão usa uma thread por CPU; o texto cifrado não depende da quantidade de threads.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--mmap".
+ * @param argv Argumentos após "--mmap".
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int run_mmap_mode(const polybius_square *polybius, char key[], int key_length, int argc, char *argv[])
+{
+  int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (argc > 3 && strcmp(argv[2], "--threads") == 0)
+  {
+    thread_count = atoi(argv[3]);
+  }
+  if (argc < 2 || key_length <= 0 || thread_count <= 0)
+  {
+    fprintf(stderr, "Usage: --mmap <input|-> <output|-> [--threads N]\n");
+    return 1;
+  }
+
+  if (cipher_adfgvx_mapped(polybius, key, key_length, argv[0], argv[1], thread_count) != 0)
+  {
+    perror("Error encrypting with mmap.");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Cifra um arquivo em duas passadas com memória constante, sem buffer da mensagem e sem matriz de colunas.
+ *
+ * A primeira passada lê a entrada em blocos de TWO_PASS_READ_SIZE bytes e só conta os caracteres
+ * válidos, o que fixa o tamanho de cada coluna e a posição de cada uma no texto cifrado. A segunda
+ * passada lê a entrada de novo, codifica cada bloco com o kernel da CPU e acumula cada símbolo no
+ * buffer da sua coluna; buffer cheio é escrito com pwrite direto na posição atual da coluna no arquivo
+ * de saída. A memória usada é o bloco de leitura, os seus símbolos e buffer_size bytes de buffers de
+ * coluna (divididos entre as colunas, pelo menos 1 byte cada), independente do tamanho da mensagem.
+ * A entrada precisa ser um arquivo (não um pipe).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input_path Caminho da entrada.
+ * @param output_path Caminho da saída.
+ * @param buffer_size Memória total dos buffers de coluna, em bytes.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int cipher_adfgvx_two_pass(const polybius_square *polybius, char key[], int key_length, const char *input_path, const char *output_path, size_t buffer_size)
+{
+  size_t column_buffer = buffer_size / key_length > 0 ? buffer_size / key_length : 1;
+  char *memory = malloc(3 * TWO_PASS_READ_SIZE + column_buffer * key_length);
+  int input_fd = open(input_path, O_RDONLY), output_fd = -1, result = 1;
+  int order[key_length];
+  size_t cursor[key_length], fill[key_length];
+  size_t symbol_count = 0;
+  ssize_t length;
+
+  if (memory == NULL || input_fd < 0)
+  {
+    goto cleanup;
+  }
+  char *chunk = memory, *symbols = memory + TWO_PASS_READ_SIZE, *columns = memory + 3 * TWO_PASS_READ_SIZE;
+
+  // Primeira passada: só a contagem dos caracteres válidos
+  while ((length = read(input_fd, chunk, TWO_PASS_READ_SIZE)) > 0)
+    symbol_count += 2 * polybius_count_valid(polybius, chunk, length);
+  if (length < 0 || lseek(input_fd, 0, SEEK_SET) != 0)
+    goto cleanup;
+
+  compute_column_order(key, key_length, order);
+  compute_column_offsets(key_length, order, symbol_count, cursor);
+  memset(fill, 0, sizeof(fill));
+
+  output_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (output_fd < 0 || ftruncate(output_fd, symbol_count) != 0)
+    goto cleanup;
+
+  // Segunda passada: o bloco é codificado pelo kernel em sequência linear e cada coluna copia os seus
+  // símbolos (um a cada key_length) para o seu buffer; buffers cheios vão para a posição da coluna
+  const polybius_kernel *kernel = polybius_select_kernel();
+  int column = 0, failed = 0;
+  while (!failed && (length = read(input_fd, chunk, TWO_PASS_READ_SIZE)) > 0)
+  {
+    int count = kernel->encode(polybius, chunk, (int)length, symbols);
+
+    for (int c = 0; c < key_length; c++)
+    {
+      char *buffer = columns + (size_t)c * column_buffer;
+      size_t used = fill[c];
+
+      for (int j = (c - column + key_length) % key_length; j < count; j += key_length)
+      {
+        buffer[used++] = symbols[j];
+        if (used == column_buffer)
+        {
+          failed |= pwrite(output_fd, buffer, column_buffer, cursor[c]) != (ssize_t)column_buffer;
+          cursor[c] += column_buffer;
+          used = 0;
+        }
+      }
+      fill[c] = used;
+    }
+    column = (column + count) % key_length;
+  }
+  if (failed || length < 0)
+    goto cleanup;
+
+  for (int c = 0; c < key_length; c++)
+  {
+    if (fill[c] > 0 && pwrite(output_fd, columns + (size_t)c * column_buffer, fill[c], cursor[c]) != (ssize_t)fill[c])
+      goto cleanup;
+  }
+  result = close(output_fd) != 0;
+  output_fd = -1;
+
+cleanup:
+  if (output_fd >= 0)
+    close(output_fd);
+  if (input_fd >= 0)
+    close(input_fd);
+  free(memory);
+  return result;
+}
+
+/**
+ * @brief Executa o modo two-pass: ./cipher_adfgvx --two-pass [entrada] [saída] [--buffer BYTES]
+ *
+ * Sem argumentos lê "./message.txt" e grava "./encrypted.txt". O arquivo inteiro é cifrado como uma
+ * única mensagem com memória constante (ver cipher_adfgvx_two_pass); --buffer define a memória dos
+ * buffers de coluna (padrão TWO_PASS_BUFFER_SIZE).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--two-pass".
+ * @param argv Argumentos após "--two-pass".
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int run_two_pass_mode(const polybius_square *polybius, char key[], int key_length, int argc, char *argv[])
+{
+  long long buffer_size = TWO_PASS_BUFFER_SIZE;
+
+  // "--buffer BYTES" pode vir depois dos caminhos (ou no lugar deles)
+  for (int i = 0; i + 1 < argc; i++)
+  {
+    if (strcmp(argv[i], "--buffer") == 0)
+    {
+      buffer_size = atoll(argv[i + 1]);
+      argc = i;
+      break;
+    }
+  }
+
+  const char *input_path = argc > 0 ? argv[0] : "./message.txt";
+  const char *output_path = argc > 1 ? argv[1] : "./encrypted.txt";
+
+  if (key_length <= 0 || buffer_size <= 0)
+  {
+    fprintf(stderr, "Usage: --two-pass [input] [output] [--buffer BYTES]\n");
+    return 1;
+  }
+
+  if (cipher_adfgvx_two_pass(polybius, key, key_length, input_path, output_path, (size_t)buffer_size) != 0)
+  {
+    perror("Error encrypting in two passes.");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Cifra um arquivo inteiro como uma única mensagem no formato compactado (ver adfgvx_encrypt_packed).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input_path Caminho da mensagem ("-" para stdin).
+ * @param output_path Caminho do texto cifrado compactado ("-" para stdout).
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int cipher_file_packed(const polybius_square *polybius, char key[], int key_length, const char *input_path, const char *output_path)
+{
+  FILE *input = strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "rb");
+  size_t message_length = 0, packed_length = 0;
+  int status = 1;
+  char schedule_memory[adfgvx_key_schedule_arena_size(key_length)];
+  adfgvx_arena schedule_arena;
+  adfgvx_key_schedule schedule;
+
+  if (input == NULL)
+  {
+    return 1;
+  }
+
+  char *message = read_whole_file(input, &message_length);
+  if (input != stdin)
+    fclose(input);
+
+  adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+  if (message == NULL || adfgvx_key_schedule_init(&schedule, &schedule_arena, key_length) != 0 ||
+      adfgvx_key_schedule_compile_square(&schedule, key, key_length, polybius->cells) != 0)
+  {
+    free(message);
+    return 1;
+  }
+
+  size_t capacity = adfgvx_packed_size(2 * polybius_count_valid(&schedule.polybius, message, message_length));
+  unsigned char *packed = malloc(capacity);
+  FILE *output = packed == NULL ? NULL : strcmp(output_path, "-") == 0 ? stdout : fopen(output_path, "wb");
+
+  if (output != NULL)
+  {
+    status = adfgvx_encrypt_packed(&schedule, message, message_length, packed, capacity, &packed_length) != 0 ||
+             fwrite(packed, 1, packed_length, output) != packed_length;
+    if (output != stdout)
+      status |= fclose(output) != 0;
+    else
+      status |= fflush(output) != 0;
+  }
+
+  free(packed);
+  free(message);
+  return status;
+}
+
+/**
+ * @brief Executa o modo compactado: ./cipher_adfgvx --packed [entrada] [saída]
+ *
+ * Sem argumentos lê "./message.txt" e grava "./encrypted.adfp". O arquivo inteiro é cifrado como uma
+ * única mensagem e gravado com um byte por par de símbolos (cabeçalho ADFGVX_PACKED_MAGIC); --decrypt
+ * reconhece o formato pelo cabeçalho.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--packed".
+ * @param argv Argumentos após "--packed".
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int run_packed_mode(const polybius_square *polybius, char key[], int key_length, int argc, char *argv[])
+{
+  const char *input_path = argc > 0 ? argv[0] : "./message.txt";
+  const char *output_path = argc > 1 ? argv[1] : "./encrypted.adfp";
+
+  if (key_length <= 0)
+  {
+    fprintf(stderr, "Error encrypting: invalid key.\n");
+    return 1;
+  }
+
+  if (cipher_file_packed(polybius, key, key_length, input_path, output_path) != 0)
+  {
+    perror("Error encrypting to the packed format.");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Confere se todos os bytes são símbolos ADFGVX.
+ */
+static int all_adfgvx_symbols(const char *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (symbol_rank[(unsigned char)data[i]] == 0)
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * @brief Decifra um arquivo inteiro como uma única mensagem, lendo cada par direto da sua posição.
+ *
+ * Reconhece três formatos: texto (símbolos ADFGVX; quebras de linha no final são ignoradas), o formato
+ * compactado (cabeçalho "ADFP") e a saída de --stream/--pipeline (blocos com cabeçalho de tamanho,
+ * decifrados um a um com adfgvx_decrypt_stream). Qualquer outra entrada (bytes fora de ADFGVX) é recusada. Os pares são
+ * divididos entre thread_count threads (ver adfgvx_parallel_decrypt).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input_path Caminho do texto cifrado ("-" para stdin).
+ * @param output_path Caminho da mensagem decifrada ("-" para stdout).
+ * @param thread_count Quantidade máxima de threads.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int decipher_file(const polybius_square *polybius, char key[], int key_length, const char *input_path, const char *output_path, int thread_count)
+{
+  FILE *input = strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "rb");
+  size_t symbol_count = 0;
+  int status = 1;
+  char schedule_memory[adfgvx_key_schedule_arena_size(key_length)];
+  adfgvx_arena schedule_arena;
+  adfgvx_key_schedule schedule;
+
+  if (input == NULL)
+  {
+    return 1;
+  }
+
+  adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+  if (adfgvx_key_schedule_init(&schedule, &schedule_arena, key_length) != 0 ||
+      adfgvx_key_schedule_compile_square(&schedule, key, key_length, polybius->cells) != 0)
+  {
+    if (input != stdin)
+      fclose(input);
+    return 1;
+  }
+
+  char *ciphertext = read_whole_file(input, &symbol_count);
+  if (input != stdin)
+    fclose(input);
+  if (ciphertext == NULL)
+  {
+    return 1;
+  }
+
+  // Formato compactado (cabeçalho "ADFP"): decifrado direto dos bytes, sem descompactar
+  size_t packed_size = symbol_count;
+  int packed = adfgvx_packed_read_header((const unsigned char *)ciphertext, packed_size, &symbol_count, NULL) == 0;
+  int framed = !packed && adfgvx_stream_check(ciphertext, symbol_count, NULL) == 0;
+
+  while (!packed && !framed && symbol_count > 0 && (ciphertext[symbol_count - 1] == '\n' || ciphertext[symbol_count - 1] == '\r'))
+    symbol_count--;
+
+  if (!packed && !framed && !all_adfgvx_symbols(ciphertext, symbol_count))
+  {
+    fprintf(stderr, "Error: the input is not ADFGVX ciphertext (text, packed or stream format).\n");
+    free(ciphertext);
+    errno = EINVAL;
+    return 1;
+  }
+
+  char *message = malloc(symbol_count / 2 + 1);
+  FILE *output = message == NULL ? NULL : strcmp(output_path, "-") == 0 ? stdout : fopen(output_path, "wb");
+
+  if (output != NULL)
+  {
+    size_t length = 0;
+    int decrypted = 1;
+
+    if (framed)
+      adfgvx_decrypt_stream(&schedule, ciphertext, symbol_count, message, symbol_count / 2 + 1, &length);
+    else if (!packed)
+      length = adfgvx_parallel_decrypt(&schedule, ciphertext, symbol_count, message, thread_count);
+    else if (adfgvx_decrypt_packed(&schedule, (const unsigned char *)ciphertext, packed_size, message, symbol_count / 2 + 1, &length) != 0)
+    {
+      fprintf(stderr, "Error: unsupported packed format version.\n");
+      errno = EINVAL;
+      decrypted = 0;
+    }
+
+    status = !decrypted || fwrite(message, 1, length, output) != length;
+    if (output != stdout)
+      status |= fclose(output) != 0;
+    else
+      status |= fflush(output) != 0;
+  }
+
+  free(message);
+  free(ciphertext);
+  return status;
+}
+
+/**
+ * @brief Executa o modo de decifragem: ./cipher_adfgvx --decrypt [entrada] [saída] [--threads N]
+ *
+ * Sem argumentos lê "./encrypted.txt" e grava "./decrypted.txt"; "-" usa stdin/stdout. O texto
+ * cifrado inteiro é decifrado como uma única mensagem, sem limite de capacidade, por padrão com uma
+ * thread por CPU (ver decipher_file).
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--decrypt".
+ * @param argv Argumentos após "--decrypt".
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int run_decrypt_mode(const polybius_square *polybius, char key[], int key_length, int argc, char *argv[])
+{
+  int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  // "--threads N" pode vir depois dos caminhos (ou no lugar deles)
+  for (int i = 0; i + 1 < argc; i++)
+  {
+    if (strcmp(argv[i], "--threads") == 0)
+    {
+      thread_count = atoi(argv[i + 1]);
+      argc = i;
+      break;
+    }
+  }
+
+  const char *input_path = argc > 0 ? argv[0] : "./encrypted.txt";
+  const char *output_path = argc > 1 ? argv[1] : "./decrypted.txt";
+
+  if (key_length <= 0)
+  {
+    fprintf(stderr, "Error decrypting: invalid key.\n");
+    return 1;
+  }
+  if (thread_count <= 0)
+  {
+    fprintf(stderr, "Usage: --decrypt [input] [output] [--threads N]\n");
+    return 1;
+  }
+
+  if (decipher_file(polybius, key, key_length, input_path, output_path, thread_count) != 0)
+  {
+    perror("Error decrypting.");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Cifra um arquivo inteiro com stdio: leitura completa, cifra em memória e escrita da saída.
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param input_path Caminho da entrada.
+ * @param output_path Caminho da saída.
+ * @param per_symbol 1 para escrever símbolo a símbolo com fputc (caminho original), 0 para um único fwrite.
+ * @param message_length Tamanho da entrada (saída, pode ser NULL).
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int cipher_file_stdio(char key[], int key_length, const char *input_path, const char *output_path, int per_symbol, size_t *message_length)
+{
+  FILE *input = fopen(input_path, "rb"), *output = fopen(output_path, "wb");
+  size_t length = 0;
+  char *message = input ? read_whole_file(input, &length) : NULL;
+  size_t symbol_count = message ? 2 * count_valid_characters(message, length) : 0;
+  char *encrypted = malloc(symbol_count ? symbol_count : 1);
+  int status = 0;
+
+  if (message == NULL || output == NULL || encrypted == NULL)
+  {
+    status = 1;
+  }
+  else
+  {
+    cipher_adfgvx_buffer(key, key_length, message, length, symbol_count, encrypted);
+    if (per_symbol)
+    {
+      for (size_t i = 0; i < symbol_count && status == 0; i++)
+        status = fputc(encrypted[i], output) == EOF;
+    }
+    else
+    {
+      status = fwrite(encrypted, 1, symbol_count, output) != symbol_count;
+    }
+  }
+
+  if (input)
+    fclose(input);
+  if (output)
+  {
+    if (ferror(output))
+      status = 1;
+    if (fclose(output) != 0)
+      status = 1;
+  }
+  free(message);
+  free(encrypted);
+
+  if (message_length != NULL)
+    *message_length = length;
+  return status;
+}
+
+/**
+ * @brief Compara os caminhos de E/S: fputc por símbolo (caminho original), fwrite único, mmap e
+ * duas passadas com memória constante; depois o formato compactado contra o texto em letras.
+ *
+ * ./cipher_adfgvx --bench-io <entrada> <saída>: cada caminho cifra a entrada inteira para o arquivo
+ * de saída; o tempo inclui leitura, cifra e escrita. Os resultados precisam ser idênticos. Em seguida
+ * cifra para "<saída>.adfp" no formato compactado, informa os bytes em disco e decifra os dois
+ * arquivos para "<saída>.dec" (as mensagens decifradas também precisam ser idênticas).
+ *
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--bench-io".
+ * @param argv Argumentos após "--bench-io".
+ * @return int 0 em caso de sucesso, 1 em caso de erro ou divergência.
+ */
+int run_bench_io_mode(char key[], int key_length, int argc, char *argv[])
+{
+  if (argc < 2 || key_length <= 0)
+  {
+    fprintf(stderr, "Usage: --bench-io <input> <output>\n");
+    return 1;
+  }
+
+  const char *paths[] = {"fputc", "fwrite", "mmap", "2-pass", "packed", "dec-text", "dec-packed"};
+  char *results[7] = {NULL};
+  size_t lengths[7] = {0};
+  size_t message_length = 0;
+  size_t path_length = strlen(argv[1]);
+  char packed_path[path_length + 6], decrypted_path[path_length + 5];
+  int status = 0;
+
+  snprintf(packed_path, sizeof(packed_path), "%s.adfp", argv[1]);
+  snprintf(decrypted_path, sizeof(decrypted_path), "%s.dec", argv[1]);
+
+  for (int path = 0; path < 7 && status == 0; path++)
+  {
+    const char *written_path = path == 4 ? packed_path : path > 4 ? decrypted_path : argv[1];
+    double start = monotonic_seconds();
+
+    if (path == 6)
+      status = decipher_file(&polybius_default_square, key, key_length, packed_path, decrypted_path, 1);
+    else if (path == 5)
+      status = decipher_file(&polybius_default_square, key, key_length, argv[1], decrypted_path, 1);
+    else if (path == 4)
+      status = cipher_file_packed(&polybius_default_square, key, key_length, argv[0], packed_path);
+    else if (path == 3)
+      status = cipher_adfgvx_two_pass(&polybius_default_square, key, key_length, argv[0], argv[1], TWO_PASS_BUFFER_SIZE);
+    else if (path == 2)
+      status = cipher_adfgvx_mapped(&polybius_default_square, key, key_length, argv[0], argv[1], 1);
+    else
+      status = cipher_file_stdio(key, key_length, argv[0], argv[1], path == 0, &message_length);
+
+    double elapsed = monotonic_seconds() - start;
+    FILE *written = fopen(written_path, "rb");
+    if (written == NULL || (results[path] = read_whole_file(written, &lengths[path])) == NULL)
+      status = 1;
+    if (written)
+      fclose(written);
+
+    if (status == 0)
+    {
+      printf("%-10s %10.3f ms %10.2f MB/s %12zu B\n", paths[path], elapsed * 1e3, message_length / (elapsed > 0 ? elapsed : 1e-9) / 1e6, lengths[path]);
+    }
+  }
+
+  for (int path = 1; path < 7 && status == 0; path++)
+  {
+    // O compactado é comparado pelo que decifra; as duas decifragens entre si
+    int reference = path == 6 ? 5 : 0;
+    if (path != 4 && path != 5 && (lengths[path] != lengths[reference] || memcmp(results[path], results[reference], lengths[reference]) != 0))
+    {
+      fprintf(stderr, "Output of '%s' differs from %s.\n", paths[path], paths[reference]);
+      status = 1;
+    }
+  }
+  if (status == 0)
+  {
+    printf("packed/text on disk: %.1f%%\n", 100.0 * lengths[4] / (lengths[0] ? lengths[0] : 1));
+  }
+
+  remove(packed_path);
+  remove(decrypted_path);
+  for (int path = 0; path < 7; path++)
+    free(results[path]);
+  return status;
+}
+
+/**
+ * @brief Lê o contador de ciclos da CPU (TSC em x86-64), ou 0 se não houver um.
+ */
+static unsigned long long bench_cycles(void)
+{
+#ifdef ADFGVX_X86_SIMD
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Preenche a mensagem do benchmark com uma mistura de caracteres, de forma determinística.
+ *
+ * - "valid": somente caracteres da matriz Polybius.
+ * - "text": texto em maiúsculas com espaços e pontuação e ~3% de bytes inválidos (minúsculas, quebras de linha).
+ * - "noisy50" e "noisy90": 50% e 90% de bytes fora da matriz.
+ *
+ * @param message Buffer da mensagem.
+ * @param size Quantidade de bytes.
+ * @param mix Nome da mistura.
+ */
+void bench_fill_message(char message[], size_t size, const char *mix)
+{
+  static const char text[] = "ETAOIN SHRDLU CMFWYP VBGKJQ XZ, 1234567.";
+  static const char invalid[] = "abcdefghijklmnopqrstuvwxyz\n\t!?@#89";
+  int invalid_percent = strcmp(mix, "text") == 0 ? 3 : strcmp(mix, "noisy50") == 0 ? 50 : strcmp(mix, "noisy90") == 0 ? 90 : 0;
+  unsigned int seed = 12345;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    seed = seed * 1103515245u + 12345u;
+    unsigned int r = seed >> 8;
+
+    if ((int)(r % 100) < invalid_percent)
+      message[i] = invalid[(r / 100) % (sizeof(invalid) - 1)];
+    else if (strcmp(mix, "valid") == 0)
+      message[i] = square[(r / 100) % 6][(r / 600) % 6];
+    else
+      message[i] = text[(r / 100) % (sizeof(text) - 1)];
+  }
+}
+
+static int bench_compare_ns(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Executa uma operação do benchmark (uma execução, medida pelo chamador).
+ *
+ * @param state Estado do benchmark.
+ * @param op Operação ("encrypt", "decrypt" ou "io").
+ * @param path Caminho: "direct" e "kernel" (encrypt), "direct" (decrypt), ou "fputc", "fwrite",
+ *             "mmap", "two-pass", "stream", "pipeline" e "decrypt" (io, de arquivo para arquivo).
+ * @param key Chave.
+ * @param key_length Comprimento da chave.
+ * @param size Tamanho da mensagem.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int bench_run_once(bench_state *state, const char *op, const char *path, char key[], int key_length, size_t size)
+{
+  char input_path[BATCH_PATH_LENGTH], output_path[BATCH_PATH_LENGTH], decrypted_path[BATCH_PATH_LENGTH];
+
+  if (strcmp(op, "encrypt") == 0 && strcmp(path, "direct") == 0)
+  {
+    state->symbol_count = 2 * count_valid_characters(state->message, size);
+    cipher_adfgvx_buffer(key, key_length, state->message, size, state->symbol_count, state->ciphertext);
+    return 0;
+  }
+
+  if (strcmp(op, "encrypt") == 0)
+  {
+    // Caminho do contexto: kernel SIMD em sequência linear seguido de gather_columns
+    int order[key_length];
+    size_t column_start[key_length];
+    state->symbol_count = state->ctx->kernel->encode(&polybius_default_square, state->message, (int)size, state->symbols);
+    compute_column_order(key, key_length, order);
+    compute_column_offsets(key_length, order, state->symbol_count, column_start);
+    gather_columns(state->symbols, 0, state->symbol_count, key_length, column_start, state->ciphertext);
+    return 0;
+  }
+
+  if (strcmp(op, "decrypt") == 0)
+  {
+    // O texto cifrado da última cifragem é decifrado sobre a própria mensagem
+    decipher_adfgvx_direct(key, key_length, state->ciphertext, state->symbol_count, state->message);
+    return 0;
+  }
+
+  snprintf(input_path, sizeof(input_path), "%s/adfgvx_bench.in", state->directory);
+  snprintf(output_path, sizeof(output_path), "%s/adfgvx_bench.out", state->directory);
+  snprintf(decrypted_path, sizeof(decrypted_path), "%s/adfgvx_bench.dec", state->directory);
+
+  if (strcmp(path, "fputc") == 0 || strcmp(path, "fwrite") == 0)
+    return cipher_file_stdio(key, key_length, input_path, output_path, strcmp(path, "fputc") == 0, NULL);
+  if (strcmp(path, "mmap") == 0)
+    return cipher_adfgvx_mapped(&polybius_default_square, key, key_length, input_path, output_path, 1);
+  if (strcmp(path, "two-pass") == 0)
+    return cipher_adfgvx_two_pass(&polybius_default_square, key, key_length, input_path, output_path, TWO_PASS_BUFFER_SIZE);
+  if (strcmp(path, "decrypt") == 0)
+    return decipher_file(&polybius_default_square, key, key_length, output_path, decrypted_path, 1);
+
+  FILE *input = fopen(input_path, "rb"), *output = fopen(output_path, "wb");
+  int status = input == NULL || output == NULL ||
+               (strcmp(path, "pipeline") == 0 ? cipher_adfgvx_pipeline(state->ctx, key, key_length, input, output, PIPELINE_CHUNKS, NULL)
+                                              : cipher_adfgvx_stream(state->ctx, key, key_length, input, output)) != 0;
+  if (input)
+    fclose(input);
+  if (output && fclose(output) != 0)
+    status = 1;
+  return status;
+}
+
+/**
+ * @brief Mede uma combinação: uma execução de aquecimento descartada e até max_runs execuções medidas.
+ *
+ * O número de execuções diminui com o tamanho (no mínimo 5), para que a varredura até 1 GB termine
+ * em tempo razoável. Guarda a mediana, o p99 (posto mais próximo) e os ciclos por byte da mediana.
+ *
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int bench_measure(bench_state *state, const char *op, const char *path, const char *mix, char key[], int key_length, size_t size)
+{
+  size_t budget = ((size_t)256 << 20) / (size ? size : 1);
+  int runs = budget < 5 ? 5 : budget > (size_t)state->max_runs ? state->max_runs : (int)budget;
+
+  if (bench_run_once(state, op, path, key, key_length, size) != 0)
+    return 1;
+
+  for (int i = 0; i < runs; i++)
+  {
+    unsigned long long cycles = bench_cycles();
+    double start = monotonic_seconds();
+
+    if (bench_run_once(state, op, path, key, key_length, size) != 0)
+      return 1;
+
+    state->samples[i] = (monotonic_seconds() - start) * 1e9;
+    state->cycles[i] = bench_cycles() - cycles;
+  }
+
+  // Os ciclos vêm da mesma execução que deu a mediana de tempo (não de uma ordenação separada)
+  double median_cycles = 0;
+  double sorted_samples[runs];
+  memcpy(sorted_samples, state->samples, sizeof(double) * runs);
+  qsort(sorted_samples, runs, sizeof(double), bench_compare_ns);
+  for (int i = 0; i < runs; i++)
+  {
+    if (state->samples[i] == sorted_samples[runs / 2])
+    {
+      median_cycles = (double)state->cycles[i];
+      break;
+    }
+  }
+  memcpy(state->samples, sorted_samples, sizeof(double) * runs);
+
+  if (state->result_count == state->result_capacity)
+  {
+    int capacity = state->result_capacity ? 2 * state->result_capacity : 64;
+    bench_result *grown = realloc(state->results, sizeof(bench_result) * capacity);
+    if (grown == NULL)
+      return 1;
+    state->results = grown;
+    state->result_capacity = capacity;
+  }
+
+  bench_result *result = &state->results[state->result_count++];
+  result->op = op;
+  result->path = path;
+  result->mix = mix;
+  result->size = size;
+  result->key_length = key_length;
+  result->runs = runs;
+  result->median_ns = state->samples[runs / 2];
+  result->p99_ns = state->samples[(int)((runs - 1) * 0.99 + 0.5)];
+  result->cycles_per_byte = median_cycles > 0 && size > 0 ? median_cycles / size : -1;
+
+  fprintf(stderr, "bench: %-7s %-8s %-7s %11zu B  k=%-4d %12.0f ns\n", op, path, mix, size, key_length, result->median_ns);
+  return 0;
+}
+
+/**
+ * @brief Procura a mediana da mesma combinação em um arquivo de baseline (saída anterior de --bench).
+ *
+ * @param baseline Conteúdo do arquivo de baseline.
+ * @param result Combinação procurada.
+ * @return double Mediana em ns na baseline, ou -1 se a combinação não existir.
+ */
+double bench_baseline_median(const char *baseline, const bench_result *result)
+{
+  const char *line = baseline;
+
+  while (line != NULL && *line != '\0')
+  {
+    char op[16], path[16], mix[16];
+    size_t size;
+    int key_length, runs;
+    double median_ns;
+
+    if (sscanf(line, " {\"op\": \"%15[^\"]\", \"path\": \"%15[^\"]\", \"mix\": \"%15[^\"]\", \"size\": %zu, \"key_length\": %d, \"runs\": %d, \"median_ns\": %lf",
+               op, path, mix, &size, &key_length, &runs, &median_ns) == 7 &&
+        strcmp(op, result->op) == 0 && strcmp(path, result->path) == 0 && strcmp(mix, result->mix) == 0 &&
+        size == result->size && key_length == result->key_length)
+    {
+      return median_ns;
+    }
+
+    line = strchr(line, '\n');
+    if (line != NULL)
+      line++;
+  }
+  return -1;
+}
+
+/**
+ * @brief Executa a suíte de benchmark: ./cipher_adfgvx --bench [opções] > resultado.json
+ *
+ * Varre tamanhos de mensagem de 64 B até --max-size (padrão 1 GB, multiplicando por 64), chaves de
+ * 2, 8, 64, 1024 e 4096 caracteres e misturas de caracteres com muitos bytes inválidos, para cifrar
+ * (escrita direta e kernel SIMD), decifrar e todos os caminhos de E/S (fputc, fwrite, mmap, stream e
+ * decifragem de arquivo, em --dir). Escreve JSON em stdout, um resultado por linha, com mediana,
+ * p99, bytes/s e ciclos/byte (TSC). Com --baseline, compara com uma execução anterior e marca as
+ * combinações mais lentas que a tolerância (--tolerance, em %, padrão 10).
+ *
+ * Opções: --max-size BYTES, --runs N (máximo de execuções medidas, padrão 101), --dir DIRETÓRIO
+ * (padrão /tmp), --baseline ARQUIVO, --tolerance PCT.
+ *
+ * @param ctx Contexto de cifra (usado pelo caminho stream).
+ * @param argc Quantidade de argumentos após "--bench".
+ * @param argv Argumentos após "--bench".
+ * @return int 0 em caso de sucesso, 1 em caso de erro ou de regressão em relação à baseline.
+ */
+int run_bench_mode(adfgvx_ctx *ctx, int argc, char *argv[])
+{
+  static const char *mixes[] = {"text", "valid", "noisy50", "noisy90"};
+  static const int key_lengths[] = {2, 8, 64, 1024, 4096};
+  static const char *io_paths[] = {"fputc", "fwrite", "stream", "pipeline", "two-pass", "mmap", "decrypt"};
+  size_t max_size = BENCH_MAX_SIZE;
+  const char *baseline_path = NULL;
+  double tolerance = BENCH_TOLERANCE;
+  bench_state state = {.ctx = ctx, .directory = "/tmp", .max_runs = 101};
+  char key[4097];
+  int status = 0;
+
+  for (int i = 0; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "--max-size") == 0)
+      max_size = strtoull(argv[i + 1], NULL, 10);
+    else if (strcmp(argv[i], "--runs") == 0)
+      state.max_runs = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--dir") == 0)
+      state.directory = argv[i + 1];
+    else if (strcmp(argv[i], "--baseline") == 0)
+      baseline_path = argv[i + 1];
+    else if (strcmp(argv[i], "--tolerance") == 0)
+      tolerance = atof(argv[i + 1]);
+  }
+
+  if (max_size < 64 || state.max_runs < 5)
+  {
+    fprintf(stderr, "Usage: --bench [--max-size BYTES>=64] [--runs N>=5] [--dir DIR] [--baseline FILE] [--tolerance PCT]\n");
+    return 1;
+  }
+
+  state.samples = malloc(sizeof(double) * state.max_runs);
+  state.cycles = malloc(sizeof(unsigned long long) * state.max_runs);
+  state.message = malloc(max_size + 1);
+  state.ciphertext = malloc(2 * max_size);
+  if (state.samples == NULL || state.cycles == NULL || state.message == NULL || state.ciphertext == NULL)
+  {
+    perror("Error allocating benchmark buffers.");
+    status = 1;
+  }
+
+  for (size_t size = 64; status == 0 && size <= max_size; size *= 64)
+  {
+    // O kernel usa contagens int: só participa enquanto o texto cifrado couber em um int
+    int kernel_fits = 2 * size < (size_t)1 << 31;
+    free(state.symbols);
+    state.symbols = kernel_fits ? malloc(2 * size) : NULL;
+
+    // Chaves variadas com a mistura "text", e misturas variadas com a chave de 8 caracteres
+    for (int combo = 0; status == 0 && combo < 8; combo++)
+    {
+      int key_length = combo < 5 ? key_lengths[combo] : 8;
+      const char *mix = combo < 5 ? mixes[0] : mixes[combo - 4];
+
+      for (int i = 0; i < key_length; i++)
+        key[i] = 'A' + (i * 7 + i / 26) % 26;
+      key[key_length] = '\0';
+
+      bench_fill_message(state.message, size, mix);
+      status |= bench_measure(&state, "encrypt", "direct", mix, key, key_length, size);
+      if (kernel_fits && state.symbols != NULL)
+        status |= bench_measure(&state, "encrypt", "kernel", mix, key, key_length, size);
+      status |= bench_measure(&state, "decrypt", "direct", mix, key, key_length, size);
+    }
+
+    // Caminhos de E/S de arquivo para arquivo, com a chave de 8 caracteres e a mistura "text"
+    char input_path[BATCH_PATH_LENGTH];
+    snprintf(input_path, sizeof(input_path), "%s/adfgvx_bench.in", state.directory);
+    bench_fill_message(state.message, size, "text");
+    FILE *input = status == 0 ? fopen(input_path, "wb") : NULL;
+    if (input == NULL || fwrite(state.message, 1, size, input) != size || fclose(input) != 0)
+      status = 1;
+
+    for (int path = 0; status == 0 && path < 7; path++)
+    {
+      // O caminho "decrypt" decifra a saída do caminho anterior (mmap)
+      status |= bench_measure(&state, "io", io_paths[path], "text", key, 8, size);
+    }
+  }
+  free(state.symbols);
+
+  char *baseline = NULL;
+  if (status == 0 && baseline_path != NULL)
+  {
+    FILE *file = fopen(baseline_path, "rb");
+    size_t length;
+    if (file == NULL || (baseline = read_whole_file(file, &length)) == NULL)
+    {
+      perror("Error reading benchmark baseline.");
+      status = 1;
+    }
+    else
+    {
+      // read_whole_file sempre deixa ao menos uma posição livre no final
+      baseline[length] = '\0';
+    }
+    if (file)
+      fclose(file);
+  }
+
+  int regressions = 0;
+  printf("{\n  \"kernel\": \"%s\",\n  \"tolerance_percent\": %.1f,\n  \"results\": [\n", ctx->kernel->name, tolerance);
+  for (int i = 0; i < state.result_count && status == 0; i++)
+  {
+    bench_result *r = &state.results[i];
+    double bytes_per_s = r->median_ns > 0 ? r->size / (r->median_ns / 1e9) : 0;
+
+    printf("    {\"op\": \"%s\", \"path\": \"%s\", \"mix\": \"%s\", \"size\": %zu, \"key_length\": %d, \"runs\": %d, \"median_ns\": %.0f, \"p99_ns\": %.0f, \"bytes_per_s\": %.0f, ",
+           r->op, r->path, r->mix, r->size, r->key_length, r->runs, r->median_ns, r->p99_ns, bytes_per_s);
+    if (r->cycles_per_byte >= 0)
+      printf("\"cycles_per_byte\": %.3f", r->cycles_per_byte);
+    else
+      printf("\"cycles_per_byte\": null");
+
+    double baseline_ns = baseline != NULL ? bench_baseline_median(baseline, r) : -1;
+    if (baseline_ns > 0)
+    {
+      int regression = r->median_ns > baseline_ns * (1 + tolerance / 100);
+      regressions += regression;
+      printf(", \"baseline_median_ns\": %.0f, \"regression\": %s", baseline_ns, regression ? "true" : "false");
+    }
+    printf("}%s\n", i + 1 < state.result_count ? "," : "");
+  }
+  printf("  ],\n  \"regressions\": %d\n}\n", regressions);
+
+  if (regressions > 0)
+  {
+    fprintf(stderr, "bench: %d regressions over %.1f%% against '%s'.\n", regressions, tolerance, baseline_path);
+    status = 1;
+  }
+
+  free(baseline);
+  free(state.results);
+  free(state.samples);
+  free(state.cycles);
+  free(state.message);
+  free(state.ciphertext);
+  return status;
+}
+
+/**
+ * @brief Escreve um inteiro de 32 bits em big-endian (cabeçalhos do modo daemon).
+ */
+static void daemon_put_u32(unsigned char *out, size_t value)
+{
+  out[0] = (unsigned char)(value >> 24);
+  out[1] = (unsigned char)(value >> 16);
+  out[2] = (unsigned char)(value >> 8);
+  out[3] = (unsigned char)value;
+}
+
+/**
+ * @brief Lê um inteiro de 32 bits em big-endian (cabeçalhos do modo daemon).
+ */
+static size_t daemon_get_u32(const unsigned char *in)
+{
+  return (size_t)in[0] << 24 | (size_t)in[1] << 16 | (size_t)in[2] << 8 | in[3];
+}
+
+/**
+ * @brief Garante que o buffer comporte `needed` bytes, dobrando a capacidade quando necessário.
+ *
+ * @return int 0 em caso de sucesso, 1 se faltar memória.
+ */
+static int daemon_reserve(char **buffer, size_t *capacity, size_t needed)
+{
+  size_t grown = *capacity ? *capacity : DAEMON_IO_BUFFER_SIZE;
+
+  if (needed <= *capacity)
+  {
+    return 0;
+  }
+  while (grown < needed)
+    grown *= 2;
+
+  char *memory = realloc(*buffer, grown);
+  if (memory == NULL)
+  {
+    return 1;
+  }
+  *buffer = memory;
+  *capacity = grown;
+  return 0;
+}
+
+/**
+ * @brief Escreve todo o buffer no descritor, repetindo após escritas parciais e interrupções.
+ *
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+static int write_all(int fd, const char *buffer, size_t length)
+{
+  while (length > 0)
+  {
+    ssize_t written = write(fd, buffer, length);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return 1;
+    buffer += written;
+    length -= written;
+  }
+  return 0;
+}
+
+/**
+ * @brief Atende uma requisição completa e acrescenta a resposta ao buffer de saída da conexão.
+ *
+ * A chave da requisição é buscada no cache de escalonamentos (compilada só na primeira vez); sem
+ * chave, usa a chave de "./key.txt" compilada na inicialização. Operação desconhecida, chave maior
+ * que a capacidade do cache ou cache cheio geram uma resposta com DAEMON_STATUS_ERROR e sem payload.
+ *
+ * @param server Estado do daemon.
+ * @param frame Requisição (cabeçalho, chave e payload).
+ * @param out Buffer de saída da conexão.
+ * @param out_capacity Capacidade do buffer de saída.
+ * @param out_used Bytes já ocupados no buffer de saída.
+ * @return int 0 em caso de sucesso, 1 se faltar memória.
+ */
+static int daemon_handle_request(daemon_server *server, const unsigned char *frame, char **out, size_t *out_capacity, size_t *out_used)
+{
+  int op = frame[0];
+  int key_length = frame[2] << 8 | frame[3];
+  size_t payload_length = daemon_get_u32(frame + 4);
+  const char *key = (const char *)frame + DAEMON_HEADER_SIZE;
+  const char *payload = key + key_length;
+  size_t capacity = op == DAEMON_OP_ENCRYPT ? 2 * payload_length + 1 : payload_length / 2 + 1;
+  size_t length = 0;
+  int status = DAEMON_STATUS_ERROR;
+
+  if (daemon_reserve(out, out_capacity, *out_used + DAEMON_HEADER_SIZE + capacity) != 0)
+  {
+    return 1;
+  }
+
+  const adfgvx_key_schedule *schedule = key_length == 0 ? server->default_schedule
+                                                        : adfgvx_schedule_acquire_square(&server->cache, key, key_length, server->cells);
+  char *response = *out + *out_used;
+
+  if (schedule != NULL && op == DAEMON_OP_ENCRYPT)
+    status = adfgvx_encrypt_scheduled(schedule, payload, payload_length, response + DAEMON_HEADER_SIZE, capacity, &length);
+  else if (schedule != NULL && op == DAEMON_OP_DECRYPT)
+    status = adfgvx_decrypt_scheduled(schedule, payload, payload_length, response + DAEMON_HEADER_SIZE, capacity, &length);
+  if (schedule != NULL && key_length > 0)
+    adfgvx_schedule_release(&server->cache, schedule);
+
+  if (status != DAEMON_STATUS_OK)
+  {
+    status = DAEMON_STATUS_ERROR;
+    length = 0;
+  }
+  memset(response, 0, DAEMON_HEADER_SIZE);
+  response[0] = (char)status;
+  daemon_put_u32((unsigned char *)response + 4, length);
+  *out_used += DAEMON_HEADER_SIZE + length;
+  return 0;
+}
+
+/**
+ * @brief Atende uma conexão até o cliente fechá-la.
+ *
+ * Todas as requisições completas de cada leitura são atendidas em ordem, e as respostas são enviadas
+ * juntas com uma única escrita, então um cliente pode enviar várias requisições sem esperar pelas
+ * respostas (pipelining). Um payload maior que DAEMON_MAX_PAYLOAD encerra a conexão.
+ *
+ * @param server Estado do daemon.
+ * @param fd Descritor da conexão.
+ */
+static void daemon_serve_connection(daemon_server *server, int fd)
+{
+  char *in = NULL, *out = NULL;
+  size_t in_capacity = 0, in_used = 0, out_capacity = 0;
+
+  if (daemon_reserve(&in, &in_capacity, DAEMON_IO_BUFFER_SIZE) != 0)
+  {
+    return;
+  }
+
+  for (;;)
+  {
+    ssize_t received = read(fd, in + in_used, in_capacity - in_used);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      break;
+    in_used += received;
+
+    size_t position = 0, out_used = 0, needed = 0;
+    int failed = 0;
+
+    while (!failed && in_used - position >= DAEMON_HEADER_SIZE)
+    {
+      const unsigned char *frame = (const unsigned char *)in + position;
+      size_t payload_length = daemon_get_u32(frame + 4);
+      size_t frame_size = DAEMON_HEADER_SIZE + (frame[2] << 8 | frame[3]) + payload_length;
+
+      if (payload_length > DAEMON_MAX_PAYLOAD)
+        failed = 1;
+      else if (in_used - position < frame_size)
+      {
+        needed = frame_size;
+        break;
+      }
+      else
+      {
+        failed = daemon_handle_request(server, frame, &out, &out_capacity, &out_used);
+        position += frame_size;
+      }
+    }
+
+    if (out_used > 0 && write_all(fd, out, out_used) != 0)
+      failed = 1;
+    if (failed)
+      break;
+
+    // Guarda o início da próxima requisição e aumenta o buffer se ela não couber
+    memmove(in, in + position, in_used - position);
+    in_used -= position;
+    if (daemon_reserve(&in, &in_capacity, needed > in_used ? needed : in_used + 1) != 0)
+      break;
+  }
+
+  free(in);
+  free(out);
+}
+
+/**
+ * @brief Thread do pool do daemon: aceita uma conexão por vez e a atende até ser fechada.
+ *
+ * A thread fica presa à conexão enquanto ela estiver aberta, mesmo ociosa; não há multiplexação. Se o
+ * cliente parar de ler as respostas, a escrita desiste após DAEMON_SEND_TIMEOUT segundos sem progresso e
+ * a conexão é fechada.
+ */
+static void *daemon_worker_main(void *arg)
+{
+  daemon_server *server = arg;
+
+  for (;;)
+  {
+    int fd = accept(server->listen_fd, NULL, NULL);
+    if (fd < 0 && errno == EINTR)
+      continue;
+    if (fd < 0)
+      break;
+
+    // Um cliente que não lê as respostas não prende a thread: a escrita falha após DAEMON_SEND_TIMEOUT sem progresso
+    struct timeval timeout = {.tv_sec = DAEMON_SEND_TIMEOUT};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    daemon_serve_connection(server, fd);
+    close(fd);
+  }
+  return NULL;
+}
+
+// Caminho do socket do daemon, removido ao receber SIGINT ou SIGTERM
+static const char *daemon_socket_path;
+
+static void daemon_handle_signal(int signal_number)
+{
+  (void)signal_number;
+  unlink(daemon_socket_path);
+  _exit(0);
+}
+
+/**
+ * @brief Cria um socket de domínio Unix e o conecta (cliente) ou o associa ao caminho e escuta (daemon).
+ *
+ * @param path Caminho do socket.
+ * @param listen_mode 1 para o daemon (bind e listen), 0 para o cliente (connect).
+ * @return int Descritor do socket, ou -1 em caso de erro.
+ */
+static int daemon_open_socket(const char *path, int listen_mode)
+{
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  int fd;
+
+  if (strlen(path) >= sizeof(address.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+  {
+    return -1;
+  }
+
+  if (listen_mode ? bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0
+                  : connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * @brief Executa o modo daemon: ./cipher_adfgvx --daemon <socket> [--threads N]
+ *
+ * Escuta em um socket de domínio Unix e atende requisições de cifragem e decifragem sem reiniciar o
+ * processo nem reler "./key.txt". Cada requisição tem um cabeçalho de DAEMON_HEADER_SIZE bytes:
+ * operação ('E' ou 'D'), um byte reservado, tamanho da chave (2 bytes big-endian, 0 para a chave de
+ * "./key.txt") e tamanho do payload (4 bytes big-endian), seguido da chave e do payload. Cada resposta
+ * tem o status (0 ou 1), três bytes reservados e o tamanho do payload (4 bytes big-endian), seguido do
+ * texto cifrado ou decifrado. As respostas de uma conexão saem na ordem das requisições.
+ *
+ * As conexões são atendidas por um pool de threads (por padrão uma por CPU), cada uma atendendo uma
+ * conexão por vez do accept até o fechamento (ver daemon_worker_main): no máximo N conexões são atendidas
+ * ao mesmo tempo, uma conexão ociosa ocupa a sua thread, e as demais esperam na fila do listen até que
+ * uma conexão atendida seja fechada. Clientes com muitas conexões simultâneas (como --load com
+ * --connections C) devem usar --threads >= C. As chaves ficam compiladas em um adfgvx_schedule_cache
+ * compartilhado; chaves maiores que --key-capacity são recusadas.
+ *
+ * @param ctx Contexto principal (capacidade de chave e matriz Polybius).
+ * @param key A chave de "./key.txt", usada nas requisições sem chave.
+ * @param key_length Comprimento da chave.
+ * @param argc Quantidade de argumentos após "--daemon".
+ * @param argv Argumentos após "--daemon".
+ * @return int 1 em caso de erro (o daemon só retorna se não conseguir atender).
+ */
+int run_daemon_mode(adfgvx_ctx *ctx, char key[], int key_length, int argc, char *argv[])
+{
+  daemon_server server = {.cells = ctx->polybius->cells};
+  int thread_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int key_capacity = ctx->key_capacity > key_length ? ctx->key_capacity : key_length;
+
+  if (argc > 2 && strcmp(argv[1], "--threads") == 0)
+  {
+    thread_count = atoi(argv[2]);
+  }
+  if (argc < 1 || key_length <= 0 || thread_count <= 0 || thread_count > ADFGVX_MAX_THREADS)
+  {
+    fprintf(stderr, "Usage: --daemon <socket> [--threads N]\n");
+    return 1;
+  }
+
+  // Cache de chaves com a chave padrão já compilada e reservada durante toda a execução
+  size_t arena_size = adfgvx_schedule_cache_arena_size(DAEMON_CACHE_ENTRIES, key_capacity);
+  void *arena_memory = malloc(arena_size);
+  adfgvx_arena arena;
+
+  if (arena_memory == NULL)
+  {
+    perror("Error allocating key cache.");
+    return 1;
+  }
+  adfgvx_arena_init(&arena, arena_memory, arena_size);
+  if (adfgvx_schedule_cache_init(&server.cache, &arena, DAEMON_CACHE_ENTRIES, key_capacity) != 0 ||
+      (server.default_schedule = adfgvx_schedule_acquire_square(&server.cache, key, key_length, server.cells)) == NULL)
+  {
+    fprintf(stderr, "Error compiling key.\n");
+    free(arena_memory);
+    return 1;
+  }
+
+  unlink(argv[0]);
+  server.listen_fd = daemon_open_socket(argv[0], 1);
+  if (server.listen_fd < 0)
+  {
+    perror("Error listening on socket.");
+    adfgvx_schedule_cache_destroy(&server.cache);
+    free(arena_memory);
+    return 1;
+  }
+
+  struct sigaction action = {.sa_handler = daemon_handle_signal};
+  daemon_socket_path = argv[0];
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(stderr, "Listening on '%s' with %d threads.\n", argv[0], thread_count);
+
+  pthread_t threads[ADFGVX_MAX_THREADS];
+  int started = 0;
+  while (started < thread_count && pthread_create(&threads[started], NULL, daemon_worker_main, &server) == 0)
+    started++;
+  for (int i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+
+  // As threads só terminam se accept falhar
+  perror(started > 0 ? "Error accepting connections." : "Error creating daemon threads.");
+  close(server.listen_fd);
+  unlink(argv[0]);
+  adfgvx_schedule_cache_destroy(&server.cache);
+  free(arena_memory);
+  return 1;
+}
+
+/**
+ * @brief Conexão do gerador de carga: mantém até `pipeline` requisições em andamento e mede a
+ * latência de cada uma (do envio até a chegada da resposta).
+ *
+ * O tamanho de cada resposta vem do seu cabeçalho: uma resposta de erro (sem payload) conta como falha
+ * sem desalinhar as seguintes. O envio e a leitura são intercalados com poll: o cliente só envia o que
+ * o socket aceita sem bloquear e lê as respostas enquanto o resto da janela sai, então uma janela maior
+ * que os buffers do socket não trava o cliente e o daemon esperando um pelo outro.
+ */
+static void *load_client_main(void *arg)
+{
+  load_client *client = arg;
+  size_t response_size = DAEMON_HEADER_SIZE + client->expected_length; // Resposta esperada (dimensiona o buffer)
+  size_t in_capacity = 0, in_used = 0, out_capacity = 0, out_used = 0, out_position = 0;
+  char *in = NULL, *out = NULL;
+  double *sent_at = malloc(sizeof(double) * client->pipeline);
+  int fd = daemon_open_socket(client->socket_path, 0);
+  int sent = 0;
+
+  if (fd < 0 || sent_at == NULL || daemon_reserve(&in, &in_capacity, response_size * client->pipeline) != 0 ||
+      daemon_reserve(&out, &out_capacity, client->request_size * client->pipeline) != 0)
+  {
+    client->failures = client->requests;
+    goto cleanup;
+  }
+
+  while (client->completed < client->requests)
+  {
+    // Completa a janela de requisições em andamento; os bytes ainda não enviados ficam no início de out
+    memmove(out, out + out_position, out_used - out_position);
+    out_used -= out_position;
+    out_position = 0;
+    double now = monotonic_seconds();
+    while (sent < client->requests && sent - client->completed < client->pipeline)
+    {
+      memcpy(out + out_used, client->request, client->request_size);
+      out_used += client->request_size;
+      sent_at[sent++ % client->pipeline] = now;
+    }
+
+    struct pollfd events = {.fd = fd, .events = POLLIN | (out_used > 0 ? POLLOUT : 0)};
+    if (poll(&events, 1, -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (events.revents & POLLOUT)
+    {
+      ssize_t written = send(fd, out, out_used, MSG_DONTWAIT);
+      if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        break;
+      if (written > 0)
+        out_position = (size_t)written;
+    }
+    if (!(events.revents & (POLLIN | POLLHUP | POLLERR)))
+      continue;
+
+    ssize_t received = read(fd, in + in_used, in_capacity - in_used);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      break;
+    in_used += received;
+
+    size_t position = 0, needed = 0;
+    now = monotonic_seconds();
+    while (in_used - position >= DAEMON_HEADER_SIZE)
+    {
+      const unsigned char *response = (const unsigned char *)in + position;
+      size_t length = daemon_get_u32(response + 4);
+
+      if (in_used - position < DAEMON_HEADER_SIZE + length)
+      {
+        needed = DAEMON_HEADER_SIZE + length;
+        break;
+      }
+      if (response[0] != DAEMON_STATUS_OK || length != client->expected_length)
+        client->failures++;
+      client->latencies[client->completed] = now - sent_at[client->completed % client->pipeline];
+      client->completed++;
+      position += DAEMON_HEADER_SIZE + length;
+    }
+
+    // Guarda o início da próxima resposta e aumenta o buffer se ela não couber
+    memmove(in, in + position, in_used - position);
+    in_used -= position;
+    if (daemon_reserve(&in, &in_capacity, needed > in_used ? needed : in_used + 1) != 0)
+      break;
+  }
+
+  client->failures += client->requests - client->completed;
+
+cleanup:
+  if (fd >= 0)
+    close(fd);
+  free(sent_at);
+  free(in);
+  free(out);
+  return NULL;
+}
+
+/**
+ * @brief Envia uma requisição e espera a resposta (usado pelo gerador de carga para preparar o texto cifrado).
+ *
+ * @return char* Payload da resposta (alocado; o chamador libera), ou NULL em caso de erro.
+ */
+static char *load_round_trip(const char *socket_path, const char *request, size_t request_size, size_t *length)
+{
+  unsigned char header[DAEMON_HEADER_SIZE];
+  char *payload = NULL;
+  size_t received = 0;
+  int fd = daemon_open_socket(socket_path, 0);
+
+  if (fd < 0 || write_all(fd, request, request_size) != 0)
+    goto cleanup;
+
+  while (received < DAEMON_HEADER_SIZE)
+  {
+    ssize_t count = read(fd, header + received, DAEMON_HEADER_SIZE - received);
+    if (count <= 0)
+      goto cleanup;
+    received += count;
+  }
+  *length = daemon_get_u32(header + 4);
+  if (header[0] != DAEMON_STATUS_OK || (payload = malloc(*length + 1)) == NULL)
+    goto cleanup;
+
+  for (received = 0; received < *length;)
+  {
+    ssize_t count = read(fd, payload + received, *length - received);
+    if (count <= 0)
+    {
+      free(payload);
+      payload = NULL;
+      break;
+    }
+    received += count;
+  }
+
+cleanup:
+  if (fd >= 0)
+    close(fd);
+  return payload;
+}
+
+/**
+ * @brief Monta uma requisição do modo daemon (sem chave: usa a chave do daemon).
+ *
+ * @return char* Requisição alocada (o chamador libera), ou NULL se faltar memória.
+ */
+static char *load_build_request(int op, const char *payload, size_t payload_length)
+{
+  char *request = malloc(DAEMON_HEADER_SIZE + payload_length);
+
+  if (request != NULL)
+  {
+    memset(request, 0, DAEMON_HEADER_SIZE);
+    request[0] = (char)op;
+    daemon_put_u32((unsigned char *)request + 4, payload_length);
+    memcpy(request + DAEMON_HEADER_SIZE, payload, payload_length);
+  }
+  return request;
+}
+
+/**
+ * @brief Executa o gerador de carga: ./cipher_adfgvx --load <socket> [--connections C] [--requests N]
+ * [--size BYTES] [--pipeline P] [--decrypt]
+ *
+ * Abre C conexões com um daemon, cada uma enviando N requisições com uma mensagem de BYTES bytes
+ * (mistura "text" do benchmark) e mantendo até P requisições em andamento. Ao final, informa em stdout
+ * requisições/s e os percentis de latência (p50, p90, p99, p99.9 e máximo). Com --decrypt, a mensagem é
+ * cifrada uma vez pelo próprio daemon e as requisições decifram o texto cifrado.
+ *
+ * @param argc Quantidade de argumentos após "--load".
+ * @param argv Argumentos após "--load".
+ * @return int 0 se todas as requisições foram atendidas, 1 caso contrário.
+ */
+int run_load_mode(int argc, char *argv[])
+{
+  int connections = 4, requests = 10000, pipeline = 16, op = DAEMON_OP_ENCRYPT;
+  size_t size = 256;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--decrypt") == 0)
+      op = DAEMON_OP_DECRYPT;
+    else if (i + 1 < argc && strcmp(argv[i], "--connections") == 0)
+      connections = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "--requests") == 0)
+      requests = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "--size") == 0)
+      size = strtoull(argv[++i], NULL, 10);
+    else if (i + 1 < argc && strcmp(argv[i], "--pipeline") == 0)
+      pipeline = atoi(argv[++i]);
+  }
+
+  if (argc < 1 || connections <= 0 || connections > ADFGVX_MAX_THREADS || requests <= 0 || pipeline <= 0 || size > DAEMON_MAX_PAYLOAD)
+  {
+    fprintf(stderr, "Usage: --load <socket> [--connections C] [--requests N] [--size BYTES] [--pipeline P] [--decrypt]\n");
+    return 1;
+  }
+
+  char *message = malloc(size + 1), *request = NULL, *ciphertext = NULL;
+  double *latencies = malloc(sizeof(double) * connections * requests);
+  load_client clients[ADFGVX_MAX_THREADS];
+  size_t payload_length = size, expected_length = 0;
+  int status = 1;
+
+  signal(SIGPIPE, SIG_IGN);
+  if (message == NULL || latencies == NULL)
+  {
+    perror("Error allocating load buffers.");
+    goto cleanup;
+  }
+  bench_fill_message(message, size, "text");
+  expected_length = 2 * count_valid_characters(message, size);
+
+  if (op == DAEMON_OP_DECRYPT)
+  {
+    // O texto cifrado vem do próprio daemon, com a chave dele
+    char *encrypt_request = load_build_request(DAEMON_OP_ENCRYPT, message, size);
+    ciphertext = encrypt_request ? load_round_trip(argv[0], encrypt_request, DAEMON_HEADER_SIZE + size, &payload_length) : NULL;
+    free(encrypt_request);
+    if (ciphertext == NULL)
+    {
+      perror("Error encrypting the load message.");
+      goto cleanup;
+    }
+    expected_length /= 2;
+  }
+
+  request = load_build_request(op, op == DAEMON_OP_DECRYPT ? ciphertext : message, payload_length);
+  if (request == NULL)
+  {
+    perror("Error allocating load buffers.");
+    goto cleanup;
+  }
+
+  double start = monotonic_seconds();
+  int started = 0;
+  for (; started < connections; started++)
+  {
+    clients[started] = (load_client){.socket_path = argv[0], .request = request, .request_size = DAEMON_HEADER_SIZE + payload_length,
+                                     .expected_length = expected_length, .requests = requests, .pipeline = pipeline,
+                                     .latencies = latencies + (size_t)started * requests};
+    if (pthread_create(&clients[started].thread, NULL, load_client_main, &clients[started]) != 0)
+      break;
+  }
+
+  int completed = 0, failures = 0;
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(clients[i].thread, NULL);
+    // Junta as latências de todas as conexões no início do vetor
+    memmove(latencies + completed, clients[i].latencies, sizeof(double) * clients[i].completed);
+    completed += clients[i].completed;
+    failures += clients[i].failures;
+  }
+  double elapsed = monotonic_seconds() - start;
+
+  if (completed == 0)
+  {
+    perror("Error connecting to the daemon.");
+    goto cleanup;
+  }
+  qsort(latencies, completed, sizeof(double), bench_compare_ns);
 
-#define MAX_MESSAGE_LENGTH 2560
-#define MAX_KEY_LENGTH 9
+  printf("connections: %d, pipeline: %d, size: %zu bytes, op: %s\n", started, pipeline, size, op == DAEMON_OP_ENCRYPT ? "encrypt" : "decrypt");
+  printf("requests: %d, failures: %d, elapsed: %.3f s, req/s: %.0f\n", completed, failures, elapsed, completed / elapsed);
+  printf("latency (us): p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+         latencies[(size_t)(completed * 0.50)] * 1e6, latencies[(size_t)(completed * 0.90)] * 1e6,
+         latencies[(size_t)(completed * 0.99)] * 1e6, latencies[(size_t)(completed * 0.999)] * 1e6, latencies[completed - 1] * 1e6);
+  status = failures != 0 || started < connections;
 
-const char symbols[6] = {'A', 'D', 'F', 'G', 'V', 'X'};
-const char square[6][6] = {
-    {'A', 'B', 'C', 'D', 'E', 'F'},
-    {'G', 'H', 'I', 'J', 'K', 'L'},
-    {'M', 'N', 'O', 'P', 'Q', 'R'},
-    {'S', 'T', 'U', 'V', 'W', 'X'},
-    {'Y', 'Z', ' ', ',', '.', '1'},
-    {'2', '3', '4', '5', '6', '7'}};
+cleanup:
+  free(message);
+  free(latencies);
+  free(request);
+  free(ciphertext);
+  return status;
+}
 
 /**
- * @brief Lê o conteúdo de um arquivo em um buffer.
+ * @brief Cifra message.txt pelo caminho original: matriz de colunas + transposição por trocas.
  *
- * @param filename Caminho para o arquivo a ser lido.
- * @param buffer Buffer onde o conteúdo será armazenado.
- * @param max_length Tamanho máximo permitido do buffer.
- * @return int 0 em caso de sucesso, 1 em caso de erro.
+ * A matriz é alocada uma vez no heap (e não na pilha), pois seu tamanho depende da capacidade.
+ *
+ * @param ctx Contexto de cifra (a mensagem já deve estar em ctx->message).
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @return int Quantidade de símbolos escritos em ctx->output, ou -1 se faltar memória.
  */
-int read_file(const char *filename, char *buffer, int max_length)
+int cipher_with_matrix(adfgvx_ctx *ctx, char key[], int key_length)
 {
-  FILE *file = fopen(filename, "r");
-  if (file == NULL)
+  int symbols_per_column[key_length]; // Contador de símbolos ADFGVX por coluna
+  memset(symbols_per_column, 0, sizeof(symbols_per_column));
+
+  // Calcula quantos símbolos cada coluna precisará no pior caso, fazendo um ceil para truncar para cima
+  int max_per_column = (2 * ctx->message_capacity + key_length - 1) / key_length;
+  adfgvx_stats_mark mark;
+
+  // Armazenar os símbolos após criptografia, e é utilizada na transposição para dar o resultado final
+  char (*encoded_symbol_matrix)[max_per_column] = malloc((size_t)key_length * max_per_column);
+  if (encoded_symbol_matrix == NULL)
   {
-    return 1;
+    return -1;
+  }
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    // A matriz de colunas é alocada além dos buffers do contexto
+    adfgvx_stats_buffer(ctx->stats, ctx->stats->peak_buffer_bytes + (size_t)key_length * max_per_column);
+    adfgvx_stats_start(&mark);
   }
 
-  fgets(buffer, max_length, file);
+  // Mesmas etapas de cipher_adfgvx, medidas separadamente
+  polybius_encode_to_columns(key_length, max_per_column, ctx->message, encoded_symbol_matrix, symbols_per_column);
 
-  fclose(file);
-  return 0;
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_ENCODE, &mark);
+    adfgvx_stats_start(&mark);
+  }
+
+  transpose_columns_by_key_order(key, key_length, max_per_column, encoded_symbol_matrix, symbols_per_column);
+
+  // Linearizar as colunas ordenadas
+  int symbol_count = 0;
+  for (int i = 0; i < key_length; i++)
+  {
+    memcpy(ctx->output + symbol_count, encoded_symbol_matrix[i], symbols_per_column[i]);
+    symbol_count += symbols_per_column[i];
+  }
+  ctx->output[symbol_count] = '\0';
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_TRANSPOSE, &mark);
+    ctx->stats->bytes_in += ctx->message_length;
+    ctx->stats->bytes_out += symbol_count;
+    ctx->stats->invalid_dropped += ctx->message_length - symbol_count / 2;
+  }
+
+  free(encoded_symbol_matrix);
+  return symbol_count;
 }
 
 /**
- * @brief Encontra os símbolos ADFGVX correspondentes a um caractere.
+ * @brief Cifra a mensagem no próprio buffer de saída do contexto, sem matriz de colunas e sem buffer auxiliar.
  *
- * @param c Caractere a ser cifrado.
- * @param row Ponteiro para armazenar o símbolo da linha.
- * @param col Ponteiro para armazenar o símbolo da coluna.
- * @return int Retorna 1 se o caractere foi encontrado, 0 caso contrário.
+ * A mensagem é lida direto em ctx->output (2 * message_capacity + 1 posições), codificada no lugar
+ * com polybius_encode_in_place e transposta no lugar com transpose_symbols_in_place; a memória extra
+ * é só a ordem e as posições das colunas (O(key_length)). Modo para alvos com pouca SRAM.
+ *
+ * @param ctx Contexto de cifra, com a mensagem já lida em ctx->output e o tamanho em ctx->message_length.
+ * @param key A chave usada na transposição.
+ * @param key_length Comprimento da chave.
+ * @return int Quantidade de símbolos, ou -1 se a chave exceder a capacidade.
  */
-int get_adfgvx_symbols(char c, char *row, char *col)
+int cipher_in_place(adfgvx_ctx *ctx, char key[], int key_length)
 {
-  for (int i = 0; i < 6; i++)
+  if (key_length <= 0 || key_length > ctx->key_capacity)
   {
-    for (int j = 0; j < 6; j++)
-    {
-      if (square[i][j] == c)
-      {
-        *row = symbols[i];
-        *col = symbols[j];
-        return 1;
-      }
-    }
+    return -1;
   }
-  return 0;
+
+  size_t column_start[key_length];
+  adfgvx_stats_mark mark;
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+    adfgvx_stats_start(&mark);
+
+  compute_column_order(key, key_length, ctx->order);
+  size_t symbol_count = polybius_encode_in_place(ctx->polybius, ctx->output, ctx->message_length);
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_ENCODE, &mark);
+    adfgvx_stats_start(&mark);
+  }
+
+  compute_column_offsets(key_length, ctx->order, symbol_count, column_start);
+  transpose_symbols_in_place(ctx->output, symbol_count, key_length, column_start);
+  ctx->output[symbol_count] = '\0';
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_TRANSPOSE, &mark);
+    ctx->stats->bytes_in += ctx->message_length;
+    ctx->stats->bytes_out += symbol_count;
+    ctx->stats->invalid_dropped += ctx->message_length - symbol_count / 2;
+  }
+  return (int)symbol_count;
 }
 
 /**
- * @brief Insere um símbolo ADFGVX na matriz de colunas.
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna
- * @param symbol Símbolo a ser inserido (row ou col).
- * @param symbol_count Contador global de símbolos (será incrementado).
- * @param encoded_symbol_matrix Matriz de saída contendo os símbolos organizados por coluna.
- * @param symbols_per_column Vetor com a quantidade de símbolos por coluna (será atualizado).
+ * @brief Remove as opções de capacidade (--capacity N e --key-capacity N) dos argumentos.
+ *
+ * @param argc Quantidade de argumentos (será atualizada).
+ * @param argv Argumentos (as opções reconhecidas são removidas).
+ * @param message_capacity Capacidade de mensagem (atualizada se a opção estiver presente).
+ * @param key_capacity Capacidade da chave (atualizada se a opção estiver presente).
+ * @return int 0 em caso de sucesso, 1 se algum valor for inválido.
  */
-void insert_symbol_to_column(int key_length, int max_per_column, char symbol, int *symbol_count, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+int parse_capacity_options(int *argc, char *argv[], int *message_capacity, int *key_capacity)
 {
-  int col_index = (*symbol_count) % key_length;
-  int write_pos = symbols_per_column[col_index];
+  int kept = 1;
+
+  for (int i = 1; i < *argc; i++)
+  {
+    int *target = NULL;
+
+    if (strcmp(argv[i], "--capacity") == 0)
+      target = message_capacity;
+    else if (strcmp(argv[i], "--key-capacity") == 0)
+      target = key_capacity;
+
+    if (target == NULL)
+    {
+      argv[kept++] = argv[i];
+      continue;
+    }
+
+    if (i + 1 >= *argc || (*target = atoi(argv[i + 1])) <= 0)
+    {
+      return 1;
+    }
+    i++;
+  }
 
-  encoded_symbol_matrix[col_index][write_pos] = symbol;
-  symbols_per_column[col_index]++;
-  (*symbol_count)++;
+  *argc = kept;
+  argv[kept] = NULL;
+  return 0;
 }
 
 /**
- * @brief Converte a mensagem em colunas de símbolos ADFGVX para cifra por transposição.
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna
- * @param message Mensagem original a ser cifrada.
- * @param encoded_symbol_matrix Matriz onde os símbolos cifrados serão armazenados por coluna.
- * @param symbols_per_column Vetor que armazena o número de elementos em cada coluna.
+ * @brief Remove as opções de matriz Polybius (--square ARQUIVO e --square-keyword PALAVRA) dos argumentos
+ * e monta a matriz escolhida.
+ *
+ * O arquivo contém os 36 caracteres da matriz, linha a linha, em uma única linha; a palavra-chave
+ * gera a matriz com polybius_square_from_keyword.
+ *
+ * @param argc Quantidade de argumentos (será atualizada).
+ * @param argv Argumentos (as opções reconhecidas são removidas).
+ * @param cells Matriz de saída (preenchida apenas se alguma opção estiver presente).
+ * @return int 1 se uma matriz foi montada, 0 se nenhuma opção estiver presente, -1 em caso de erro.
  */
-void polybius_encode_to_columns(int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+int parse_square_options(int *argc, char *argv[], char cells[POLYBIUS_CELLS])
 {
-  int i, symbol_count = 0;
+  int kept = 1, found = 0;
 
-  for (i = 0; message[i] != '\0'; i++)
+  for (int i = 1; i < *argc; i++)
   {
-    char row, col;
+    int from_file = strcmp(argv[i], "--square") == 0;
 
-    // Ignora caracteres que não estão na matriz Polybius
-    if (!get_adfgvx_symbols(message[i], &row, &col))
+    if (!from_file && strcmp(argv[i], "--square-keyword") != 0)
     {
+      argv[kept++] = argv[i];
       continue;
     }
 
-    insert_symbol_to_column(key_length, max_per_column, row, &symbol_count, encoded_symbol_matrix, symbols_per_column);
-    insert_symbol_to_column(key_length, max_per_column, col, &symbol_count, encoded_symbol_matrix, symbols_per_column);
+    if (i + 1 >= *argc)
+    {
+      return -1;
+    }
+
+    if (from_file)
+    {
+      char line[POLYBIUS_CELLS + 2] = {0};
+
+      if (read_file(argv[i + 1], line, sizeof(line)) != 0 || strcspn(line, "\r\n") != POLYBIUS_CELLS)
+      {
+        return -1;
+      }
+      memcpy(cells, line, POLYBIUS_CELLS);
+    }
+    else
+    {
+      polybius_square_from_keyword(argv[i + 1], strlen(argv[i + 1]), cells);
+    }
+    found = 1;
+    i++;
   }
+
+  *argc = kept;
+  argv[kept] = NULL;
+  return found;
 }
 
 /**
- * @brief Reorganiza as colunas da matriz com base na ordem alfabética da chave.
- * @param key A chave usada na transposição (array de caracteres).
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna
- * @param encoded_symbol_matrix Matriz com os dados cifrados por colunas.
- * @param symbols_per_column Vetor com o número de elementos em cada coluna.
+ * @brief Remove a opção "--stats" dos argumentos.
+ *
+ * @param argc Quantidade de argumentos (atualizada).
+ * @param argv Argumentos (a opção é removida).
+ * @return int 1 se a opção estava presente, 0 caso contrário.
  */
-void transpose_columns_by_key_order(char key[], int key_length, int max_per_column, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+int parse_stats_option(int *argc, char *argv[])
 {
-  int i, j, k;
-  char sorted_key[key_length];
-  int temp_count;
+  int kept = 1, found = 0;
 
-  // Copia a chave original para preservar sua ordem
-  for (i = 0; i < key_length; i++)
+  for (int i = 1; i < *argc; i++)
   {
-    sorted_key[i] = key[i];
+    if (strcmp(argv[i], "--stats") == 0)
+      found = 1;
+    else
+      argv[kept++] = argv[i];
   }
 
-  // Ordenação da chave e reorganização das colunas
-  for (i = 0; i < key_length - 1; i++)
+  *argc = kept;
+  argv[kept] = NULL;
+  return found;
+}
+
+/**
+ * @brief Escreve a instrumentação em JSON: tempo, ciclos e chamadas por etapa, bytes, caracteres
+ * descartados e picos de buffers e de pilha.
+ *
+ * @param output Arquivo de saída.
+ * @param ctx Contexto (informa o kernel).
+ * @param stats Instrumentação.
+ */
+void write_stats_json(FILE *output, const adfgvx_ctx *ctx, const adfgvx_stats *stats)
+{
+  static const char *stage_names[ADFGVX_STAGE_COUNT] = {"read", "encode", "transpose", "decode", "write"};
+
+  fprintf(output, "{\n  \"kernel\": \"%s\",\n  \"stages\": {\n", ctx->kernel->name);
+  for (int stage = 0; stage < ADFGVX_STAGE_COUNT; stage++)
   {
-    for (j = 0; j < key_length - i - 1; j++)
-    {
-      if (sorted_key[j] > sorted_key[j + 1])
-      {
-        // Troca os caracteres da chave ordenada
-        char tmp = sorted_key[j];
-        sorted_key[j] = sorted_key[j + 1];
-        sorted_key[j + 1] = tmp;
+    fprintf(output, "    \"%s\": {\"calls\": %lu, \"wall_ns\": %.0f, \"cycles\": %llu}%s\n", stage_names[stage], stats->calls[stage],
+            stats->seconds[stage] * 1e9, stats->cycles[stage], stage + 1 < ADFGVX_STAGE_COUNT ? "," : "");
+  }
+  fprintf(output, "  },\n  \"bytes_in\": %zu,\n  \"bytes_out\": %zu,\n  \"invalid_dropped\": %zu,\n", stats->bytes_in, stats->bytes_out, stats->invalid_dropped);
+  fprintf(output, "  \"peak_buffer_bytes\": %zu,\n  \"peak_stack_bytes\": %zu\n}\n", stats->peak_buffer_bytes, stats->peak_stack_bytes);
+}
 
-        // Troca símbolo por símbolo das colunas associadas (até max_per_column)
-        for (k = 0; k < max_per_column; k++)
-        {
-          char temp = encoded_symbol_matrix[j][k];
-          encoded_symbol_matrix[j][k] = encoded_symbol_matrix[j + 1][k];
-          encoded_symbol_matrix[j + 1][k] = temp;
-        }
+/**
+ * @brief Executa a busca de chaves: ./cipher_adfgvx --search <texto cifrado> --key-length K --crib TEXTO
+ * [--offset N] [--mismatches M] [--threads N] [--max-candidates C]
+ *
+ * Procura as ordens de colunas de uma chave de K caracteres compatíveis com o crib (trecho conhecido da
+ * mensagem, na posição N em caracteres válidos), aceitando até M símbolos diferentes (ver adfgvx_key_search).
+ * Escreve em stdout até C candidatos (ordem das colunas, uma chave equivalente quando K <= 26 e símbolos
+ * diferentes) e em stderr os nós avaliados, as permutações cobertas e as permutações/s.
+ *
+ * @param polybius Matriz Polybius (padrão ou própria).
+ * @param argc Quantidade de argumentos após "--search".
+ * @param argv Argumentos após "--search".
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
+ */
+int run_search_mode(const polybius_square *polybius, int argc, char *argv[])
+{
+  int key_length = 0, max_mismatches = 0, thread_count = 1, max_candidates = 64;
+  size_t crib_offset = 0, symbol_count = 0;
+  const char *crib = NULL;
 
-        // Troca o contador de elementos de cada coluna
-        temp_count = symbols_per_column[j];
-        symbols_per_column[j] = symbols_per_column[j + 1];
-        symbols_per_column[j + 1] = temp_count;
-      }
+  for (int i = 1; i + 1 < argc; i++)
+  {
+    if (strcmp(argv[i], "--key-length") == 0)
+      key_length = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--crib") == 0)
+      crib = argv[++i];
+    else if (strcmp(argv[i], "--offset") == 0)
+      crib_offset = strtoull(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "--mismatches") == 0)
+      max_mismatches = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--threads") == 0)
+      thread_count = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--max-candidates") == 0)
+      max_candidates = atoi(argv[++i]);
+  }
+
+  if (argc < 1 || crib == NULL || key_length < 2 || key_length > ADFGVX_SEARCH_MAX_KEY || thread_count <= 0 || max_candidates < 0)
+  {
+    fprintf(stderr, "Usage: --search <ciphertext> --key-length K --crib TEXT [--offset N] [--mismatches M] [--threads N] [--max-candidates C]\n");
+    return 1;
+  }
+
+  FILE *input = strcmp(argv[0], "-") == 0 ? stdin : fopen(argv[0], "rb");
+  char *ciphertext = input == NULL ? NULL : read_whole_file(input, &symbol_count);
+  if (input != NULL && input != stdin)
+    fclose(input);
+  if (ciphertext == NULL)
+  {
+    perror("Error reading the ciphertext.");
+    return 1;
+  }
+
+  while (symbol_count > 0 && (ciphertext[symbol_count - 1] == '\n' || ciphertext[symbol_count - 1] == '\r'))
+    symbol_count--;
+
+  adfgvx_key_candidate *candidates = malloc(sizeof(adfgvx_key_candidate) * (max_candidates + 1));
+  adfgvx_key_search_stats stats;
+  if (candidates == NULL)
+  {
+    perror("Error allocating the candidates.");
+    free(ciphertext);
+    return 1;
+  }
+
+  double start = monotonic_seconds();
+  int found = adfgvx_key_search(polybius, ciphertext, symbol_count, key_length, crib, strlen(crib), crib_offset,
+                                max_mismatches, thread_count, candidates, max_candidates, &stats);
+  double elapsed = monotonic_seconds() - start;
+
+  if (found < 0)
+  {
+    fprintf(stderr, "Error: invalid search (crib with characters outside the square, or beyond the ciphertext).\n");
+    free(candidates);
+    free(ciphertext);
+    return 1;
+  }
+
+  for (int i = 0; i < found && i < max_candidates; i++)
+  {
+    char key[ADFGVX_SEARCH_MAX_KEY + 1] = {0};
+
+    printf("order:");
+    for (int position = 0; position < key_length; position++)
+    {
+      printf(" %d", candidates[i].order[position]);
+      // A coluna original lida na posição `position` recebe a letra de posto `position`
+      if (key_length <= 26)
+        key[candidates[i].order[position]] = 'A' + position;
     }
+    printf("  key: %s  mismatches: %d\n", key_length <= 26 ? key : "-", candidates[i].mismatches);
   }
+
+  // A taxa é de nós avaliados: as permutações cobertas incluem as podadas sem avaliação e não viram taxa
+  fprintf(stderr, "candidates: %d, threads: %d, nodes: %llu, permutations covered: %.0f, elapsed: %.3f s, nodes/s: %.3g\n",
+          found, stats.thread_count, stats.nodes, stats.permutations, elapsed, stats.nodes / elapsed);
+
+  free(candidates);
+  free(ciphertext);
+  return 0;
 }
 
 /**
- * @brief Aplica a cifra ADFGVX: codifica os símbolos e faz a transposição das colunas.
- * @param key A chave usada na transposição (array de caracteres).
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna
- * @param message Mensagem de entrada.
- * @param encoded_symbol_matrix Matriz onde os símbolos codificados serão armazenados.
- * @param symbols_per_column Vetor com a contagem de elementos em cada coluna.
+ * @brief Lê a chave e executa o modo escolhido na linha de comando, usando o contexto já criado.
+ *
+ * @param ctx Contexto de cifra.
+ * @param cipher_key Buffer da chave com ctx->key_capacity + 1 posições.
+ * @param argc Quantidade de argumentos.
+ * @param argv Argumentos da linha de comando.
+ * @return int 0 em caso de sucesso, 1 em caso de erro.
  */
-void cipher_adfgvx(char key[], int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
+int run_cli(adfgvx_ctx *ctx, char cipher_key[], int argc, char *argv[])
 {
-  polybius_encode_to_columns(key_length, max_per_column, message, encoded_symbol_matrix, symbols_per_column);
-  transpose_columns_by_key_order(key, key_length, max_per_column, encoded_symbol_matrix, symbols_per_column);
+  adfgvx_stats_mark mark;
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    if (argc > 1 && strcmp(argv[1], "--matrix") != 0 && strcmp(argv[1], "--in-place") != 0)
+    {
+      fprintf(stderr, "Error: --stats is only available in the default, --matrix and --in-place modes.\n");
+      return 1;
+    }
+    adfgvx_stats_start(&mark);
+  }
+
+  // Modos que só usam a matriz padrão (ou não cifram localmente) recusam uma matriz própria
+  if (ctx->polybius != &polybius_default_square && argc > 1)
+  {
+    static const char *default_square_modes[] = {"--matrix", "--bench", "--bench-io", "--load"};
+    for (size_t i = 0; i < sizeof(default_square_modes) / sizeof(default_square_modes[0]); i++)
+    {
+      if (strcmp(argv[1], default_square_modes[i]) == 0)
+      {
+        fprintf(stderr, "Error: --square and --square-keyword are not available with %s.\n", argv[1]);
+        return 1;
+      }
+    }
+  }
+
+  // A busca de chaves não usa a chave do arquivo
+  if (argc > 1 && strcmp(argv[1], "--search") == 0)
+  {
+    return run_search_mode(ctx->polybius, argc - 2, argv + 2);
+  }
+
+  // Lê a chave de cifra do arquivo
+  if (read_file("./key.txt", cipher_key, ctx->key_capacity + 1) != 0)
+  {
+    perror("Error reading file './key.txt'.");
+    return 1;
+  }
+
+  // Define o tamanho da chave com base no conteúdo lido
+  int key_length = strlen(cipher_key);
+
+  if (argc > 1 && strcmp(argv[1], "--stream") == 0)
+  {
+    return run_stream_mode(ctx, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--batch") == 0)
+  {
+    return run_batch_mode(ctx, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--decrypt") == 0)
+  {
+    return run_decrypt_mode(ctx->polybius, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--packed") == 0)
+  {
+    return run_packed_mode(ctx->polybius, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--two-pass") == 0)
+  {
+    return run_two_pass_mode(ctx->polybius, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--mmap") == 0)
+  {
+    return run_mmap_mode(ctx->polybius, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+  {
+    return run_bench_mode(ctx, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--daemon") == 0)
+  {
+    return run_daemon_mode(ctx, cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--load") == 0)
+  {
+    return run_load_mode(argc - 2, argv + 2);
+  }
+
+  if (argc > 1 && strcmp(argv[1], "--bench-io") == 0)
+  {
+    return run_bench_io_mode(cipher_key, key_length, argc - 2, argv + 2);
+  }
+
+  int use_matrix = argc > 1 && strcmp(argv[1], "--matrix") == 0;
+  int use_in_place = argc > 1 && strcmp(argv[1], "--in-place") == 0;
+  int symbol_count;
+
+  // Lê a mensagem (no modo in-place, direto no buffer de saída, que recebe os símbolos no lugar)
+  char *message = use_in_place ? ctx->output : ctx->message;
+  if (read_file("./message.txt", message, ctx->message_capacity + 1) != 0)
+  {
+    perror("Error reading file './message.txt'.");
+    return 1;
+  }
+  ctx->message_length = strlen(message);
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+  {
+    // Buffers usados: só o buffer de saída, a chave e a ordem no modo in-place; a arena inteira nos demais
+    size_t key_bytes = ctx->key_capacity + 1 + sizeof(int) * ctx->key_capacity;
+    adfgvx_stats_buffer(ctx->stats, use_in_place ? 2 * (size_t)ctx->message_capacity + 1 + key_bytes
+                                                 : adfgvx_ctx_arena_size(ctx->message_capacity, ctx->key_capacity) + ctx->key_capacity + 1);
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_READ, &mark);
+  }
+
+  if (use_matrix)
+  {
+    symbol_count = cipher_with_matrix(ctx, cipher_key, key_length);
+  }
+  else if (use_in_place)
+  {
+    symbol_count = cipher_in_place(ctx, cipher_key, key_length);
+  }
+  else
+  {
+    // Cifra com escrita direta de cada símbolo na posição final, sem matriz de colunas
+    symbol_count = adfgvx_ctx_encrypt(ctx, cipher_key, key_length, ctx->message, ctx->message_length, ctx->output, 2 * ctx->message_capacity + 1);
+  }
+
+  if (symbol_count < 0)
+  {
+    fprintf(stderr, "Error encrypting: invalid key or capacity exceeded.\n");
+    return 1;
+  }
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+    adfgvx_stats_start(&mark);
+
+  // Salvar a mensagem cifrada em 'encrypted.txt'
+  FILE *encrypted_file = fopen("./encrypted.txt", "w");
+  if (encrypted_file == NULL)
+  {
+    perror("Error opening './encrypted.txt'.");
+    return 1;
+  }
+
+  // Escrever o texto cifrado, já na ordem das colunas transpostas
+  if (fwrite(ctx->output, 1, symbol_count, encrypted_file) != (size_t)symbol_count)
+  {
+    perror("Error writing './encrypted.txt'.");
+    fclose(encrypted_file);
+    return 1;
+  }
+  fclose(encrypted_file);
+
+  if (ADFGVX_STATS_ON(ctx->stats))
+    adfgvx_stats_stop(ctx->stats, ADFGVX_STAGE_WRITE, &mark);
+
+  return 0;
 }
 
 /**
@@ -205,70 +4099,98 @@ void cipher_adfgvx(char key[], int key_length, int max_per_column, char message[
  * Esta função executa todo o processo de cifragem baseado no algoritmo ADFGVX,
  * que consiste nas seguintes etapas:
  *
- * 1. Leitura da chave de transposição a partir do arquivo "./key.txt".
- * 2. Leitura da mensagem a ser cifrada a partir do arquivo "./message.txt".
- * 3. Conversão da mensagem em pares de símbolos (A, D, F, G, V, X) usando a matriz Polybius.
- * 4. Distribuição dos símbolos em colunas com base na chave.
- * 5. Transposição das colunas conforme a ordem alfabética da chave.
+ * 1. Criação do contexto de cifra, com todos os buffers reservados de uma única vez em uma arena.
+ * 2. Leitura da chave de transposição a partir do arquivo "./key.txt".
+ * 3. Leitura da mensagem a ser cifrada a partir do arquivo "./message.txt".
+ * 4. Contagem dos caracteres válidos, que fixa o tamanho e a posição de cada coluna no texto cifrado.
+ * 5. Conversão da mensagem em pares de símbolos (A, D, F, G, V, X) usando a matriz Polybius, escrevendo
+ *    cada símbolo direto na posição final da sua coluna (ordem alfabética da chave).
  * 6. Escrita da mensagem cifrada linearizada no arquivo "./encrypted.txt".
  *
+ * Com "--matrix" usa o caminho original (matriz de colunas + transposição por trocas), útil para
+ * comparar a latência dos dois caminhos; a saída é idêntica.
+ *
  * O algoritmo garante que a reorganização dos símbolos preserve a estrutura
  * reversível do processo de decodificação.
  *
  * @note O tamanho da chave é determinado dinamicamente a partir do conteúdo de "./key.txt".
  *       A chave deve estar em uma única linha, sem espaços extras ou quebras de linha desnecessárias.
+ * @note Com "--stream" a entrada é cifrada em blocos, sem limite de tamanho (ver run_stream_mode).
+ * @note Com "--decrypt" o texto cifrado é decifrado em uma única passada (ver run_decrypt_mode).
+ * @note Com "--mmap" o arquivo inteiro é cifrado como uma única mensagem (ver run_mmap_mode).
+ * @note Com "--bench" é executada a suíte de benchmark em JSON (ver run_bench_mode).
+ * @note Com "--batch" vários arquivos são cifrados em paralelo (ver run_batch_mode).
+ * @note "--capacity N" e "--key-capacity N" alteram os limites de mensagem e de chave
+ *       (padrão DEFAULT_MESSAGE_CAPACITY e DEFAULT_KEY_CAPACITY).
+ * @note "--square ARQUIVO" ou "--square-keyword PALAVRA" trocam a matriz Polybius no modo padrão e
+ *       nos modos --in-place, --decrypt, --stream, --batch, --two-pass, --packed, --mmap, --daemon e
+ *       --search; --matrix, --bench, --bench-io e --load recusam a opção.
  *
  * @return int Retorna 0 em caso de sucesso, ou 1 se houver erro na leitura ou escrita de arquivos.
  */
-int main()
+int main(int argc, char *argv[])
 {
-  char cipher_key[MAX_KEY_LENGTH], message[MAX_MESSAGE_LENGTH];
-  int symbols_per_column[MAX_KEY_LENGTH] = {0}; // Contador de símbolos ADFGVX por coluna
+  int message_capacity = DEFAULT_MESSAGE_CAPACITY, key_capacity = DEFAULT_KEY_CAPACITY;
+  char cells[POLYBIUS_CELLS];
+  polybius_square custom_square;
+  polybius_square_tables custom_tables;
+  adfgvx_stats stats = {0};
+  int use_stats = parse_stats_option(&argc, argv);
 
-  // Lê a chave de cifra do arquivo
-  if (read_file("./key.txt", cipher_key, MAX_KEY_LENGTH) != 0)
+  if (parse_capacity_options(&argc, argv, &message_capacity, &key_capacity) != 0)
   {
-    perror("Error reading file './key.txt'.");
+    fprintf(stderr, "Invalid capacity option.\n");
     return 1;
   }
- 
-  // Define o tamanho da chave com base no conteúdo lido
-  int key_length = strlen(cipher_key);
 
-  // Calcula quantos símbolos cada coluna precisará no pior caso, fazendo um ceil para truncar para cima
-  int max_per_column = (2 * MAX_MESSAGE_LENGTH + key_length - 1) / key_length;
+  // A matriz própria é compilada uma única vez, antes de qualquer mensagem
+  int has_square = parse_square_options(&argc, argv, cells);
+  if (has_square < 0 || (has_square && polybius_square_compile(&custom_square, &custom_tables, cells) != 0))
+  {
+    fprintf(stderr, "Invalid Polybius square: expected 36 distinct characters.\n");
+    return 1;
+  }
 
-  // Armazenar os símbolos após criptografia, e é utilizada na transposição para dar o resultado final
-  char encoded_symbol_matrix[key_length][max_per_column];
+  // Todos os buffers do contexto vêm de uma única alocação, feita antes de qualquer mensagem
+  size_t arena_size = adfgvx_ctx_arena_size(message_capacity, key_capacity) + key_capacity + 1;
+  void *arena_memory = malloc(arena_size);
+  adfgvx_arena arena;
+  adfgvx_ctx ctx;
 
-  // Lê a mensagem
-  if (read_file("./message.txt", message, MAX_MESSAGE_LENGTH) != 0)
+  if (arena_memory == NULL)
   {
-    perror("Error reading file './message.txt'.");
+    perror("Error allocating cipher context.");
+    return 1;
+  }
+  adfgvx_arena_init(&arena, arena_memory, arena_size);
+  char *cipher_key = adfgvx_arena_alloc(&arena, key_capacity + 1);
+  if (cipher_key == NULL || adfgvx_ctx_init(&ctx, &arena, message_capacity, key_capacity) != 0)
+  {
+    fprintf(stderr, "Error initializing cipher context.\n");
+    free(arena_memory);
     return 1;
   }
 
-  // Realizar a cifra ADFGVX, não cria nenhuma estrutura de dados adicional grande, utiliza apenas alguns controladores inteiros e a copia da key para ordenação
-  // Faz as transformações na symbols_per_column e encoded_symbol_matrix
-  cipher_adfgvx(cipher_key, key_length, max_per_column, message, encoded_symbol_matrix, symbols_per_column);
+  if (has_square)
+  {
+    ctx.polybius = &custom_square;
+  }
 
-  // Salvar a mensagem cifrada em 'encrypted.txt'
-  FILE *encrypted_file = fopen("./encrypted.txt", "w");
-  if (encrypted_file == NULL)
+  // A pilha é preenchida aqui, então o pico medido cobre tudo o que run_cli usar
+  if (use_stats)
   {
-    perror("Error opening './encrypted.txt'.");
-    return 1;
+    ctx.stats = &stats;
+    adfgvx_stats_stack_paint(&stats);
   }
 
-  // Escrever as colunas ordenadas no arquivo cifrado
-  for (int i = 0; i < key_length; i++)
+  int result = run_cli(&ctx, cipher_key, argc, argv);
+
+  if (use_stats && result == 0)
   {
-    for (int j = 0; j < symbols_per_column[i]; j++)
-    {
-      fputc(encoded_symbol_matrix[i][j], encrypted_file);
-    }
+    adfgvx_stats_stack_peak(&stats);
+    write_stats_json(stderr, &ctx, &stats);
   }
-  fclose(encrypted_file);
 
-  return 0;
+  free(arena_memory);
+  return result;
 }
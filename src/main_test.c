@@ -1,172 +1,16 @@
+#include "adfgvx_internal.h"
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 // ! COMMON DEFINES
-#define MAX_MESSAGE_LENGTH 2560
-#define MAX_KEY_LENGTH 9
-
-int read_file(const char *filename, char *buffer, int max_length)
-{
-  FILE *file = fopen(filename, "r");
-  if (file == NULL)
-  {
-    return 1;
-  }
-
-  fgets(buffer, max_length, file);
-
-  fclose(file);
-  return 0;
-}
-
-const char symbols[6] = {'A', 'D', 'F', 'G', 'V', 'X'};
-const char square[6][6] = {
-    {'A', 'B', 'C', 'D', 'E', 'F'},
-    {'G', 'H', 'I', 'J', 'K', 'L'},
-    {'M', 'N', 'O', 'P', 'Q', 'R'},
-    {'S', 'T', 'U', 'V', 'W', 'X'},
-    {'Y', 'Z', ' ', ',', '.', '1'},
-    {'2', '3', '4', '5', '6', '7'}};
+// Tamanho dos buffers usados pelos testes
+#define TEST_MESSAGE_LENGTH 2560
+#define TEST_KEY_LENGTH 9
 // ! END COMMON DEFINES
 
-// ! CIPHER FUNCTIONS
-/**
- * @brief Encontra os símbolos ADFGVX correspondentes a um caractere.
- *
- * @param c Caractere a ser cifrado.
- * @param row Ponteiro para armazenar o símbolo da linha.
- * @param col Ponteiro para armazenar o símbolo da coluna.
- * @return int Retorna 1 se o caractere foi encontrado, 0 caso contrário.
- */
-int get_adfgvx_symbols(char c, char *row, char *col)
-{
-  for (int i = 0; i < 6; i++)
-  {
-    for (int j = 0; j < 6; j++)
-    {
-      if (square[i][j] == c)
-      {
-        *row = symbols[i];
-        *col = symbols[j];
-        return 1;
-      }
-    }
-  }
-  return 0;
-}
-
-/**
- * @brief Insere um símbolo ADFGVX na matriz de colunas.
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna (para VLA).
- * @param symbol Símbolo a ser inserido (row ou col).
- * @param symbol_count Contador global de símbolos (será incrementado).
- * @param encoded_symbol_matrix Matriz de saída contendo os símbolos organizados por coluna.
- * @param symbols_per_column Vetor com a quantidade de símbolos por coluna (será atualizado).
- */
-void insert_symbol_to_column(int key_length, int max_per_column, char symbol, int *symbol_count, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
-{
-  int col_index = (*symbol_count) % key_length;
-  int write_pos = symbols_per_column[col_index];
-
-  encoded_symbol_matrix[col_index][write_pos] = symbol;
-  symbols_per_column[col_index]++;
-  (*symbol_count)++;
-}
-
-/**
- * @brief Converte a mensagem em colunas de símbolos ADFGVX para cifra por transposição.
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna (para VLA).
- * @param message Mensagem original a ser cifrada.
- * @param encoded_symbol_matrix Matriz onde os símbolos cifrados serão armazenados por coluna.
- * @param symbols_per_column Vetor que armazena o número de elementos em cada coluna.
- */
-void polybius_encode_to_columns(int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
-{
-  int i, symbol_count = 0;
-
-  for (i = 0; message[i] != '\0'; i++)
-  {
-    char row, col;
-
-    // Ignora caracteres que não estão na matriz Polybius
-    if (!get_adfgvx_symbols(message[i], &row, &col))
-    {
-      continue;
-    }
-
-    insert_symbol_to_column(key_length, max_per_column, row, &symbol_count, encoded_symbol_matrix, symbols_per_column);
-    insert_symbol_to_column(key_length, max_per_column, col, &symbol_count, encoded_symbol_matrix, symbols_per_column);
-  }
-}
-
-/**
- * @brief Reorganiza as colunas da matriz com base na ordem alfabética da chave.
- * @param key A chave usada na transposição (array de caracteres).
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna (para VLA).
- * @param encoded_symbol_matrix Matriz com os dados cifrados por colunas.
- * @param symbols_per_column Vetor com o número de elementos em cada coluna.
- */
-void transpose_columns_by_key_order(char key[], int key_length, int max_per_column, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
-{
-  int i, j, k;
-  char sorted_key[key_length];
-  int temp_count;
-
-  // Copia a chave original para preservar sua ordem
-  for (i = 0; i < key_length; i++)
-  {
-    sorted_key[i] = key[i];
-  }
-
-  // Ordenação da chave e reorganização das colunas
-  for (i = 0; i < key_length - 1; i++)
-  {
-    for (j = 0; j < key_length - i - 1; j++)
-    {
-      if (sorted_key[j] > sorted_key[j + 1])
-      {
-        // Troca os caracteres da chave ordenada
-        char tmp = sorted_key[j];
-        sorted_key[j] = sorted_key[j + 1];
-        sorted_key[j + 1] = tmp;
-
-        // Troca símbolo por símbolo das colunas associadas (até max_per_column)
-        for (k = 0; k < max_per_column; k++)
-        {
-          char temp = encoded_symbol_matrix[j][k];
-          encoded_symbol_matrix[j][k] = encoded_symbol_matrix[j + 1][k];
-          encoded_symbol_matrix[j + 1][k] = temp;
-        }
-
-        // Troca o contador de elementos de cada coluna
-        temp_count = symbols_per_column[j];
-        symbols_per_column[j] = symbols_per_column[j + 1];
-        symbols_per_column[j + 1] = temp_count;
-      }
-    }
-  }
-}
-
-/**
- * @brief Aplica a cifra ADFGVX: codifica os símbolos e faz a transposição das colunas.
- * @param key A chave usada na transposição (array de caracteres).
- * @param key_length Comprimento da chave.
- * @param max_per_column Número máximo de posições em cada coluna (para VLA).
- * @param message Mensagem de entrada.
- * @param encoded_symbol_matrix Matriz onde os símbolos codificados serão armazenados.
- * @param symbols_per_column Vetor com a contagem de elementos em cada coluna.
- */
-void cipher_adfgvx(char key[], int key_length, int max_per_column, char message[], char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[])
-{
-  polybius_encode_to_columns(key_length, max_per_column, message, encoded_symbol_matrix, symbols_per_column);
-  transpose_columns_by_key_order(key, key_length, max_per_column, encoded_symbol_matrix, symbols_per_column);
-}
-// ! END CIPHER FUNCTIONS
-
 // ! DECIPHER FUNCTIONS
 /**
  * @brief Retorna o índice de um símbolo ADFGVX dentro do vetor `symbols`.
@@ -176,155 +20,28 @@ void cipher_adfgvx(char key[], int key_length, int max_per_column, char message[
  */
 int symbol_index(char c)
 {
-    for (int i = 0; i < 6; i++)
-    {
-        if (symbols[i] == c)
-            return i;
-    }
-    return -1;
-}
-
-/**
- * @brief Reconstrói as colunas originais da cifra com base na chave de transposição.
- *
- * Esta função realiza o processo inverso da transposição, determinando a quantidade de
- * caracteres por coluna e reorganizando o texto cifrado linearizado nas colunas originais.
- *
- * @param input Texto cifrado linearizado.
- * @param key Chave usada na cifra.
- * @param key_length Comprimento da chave.
- * @param columns Matriz que armazenará as colunas reconstruídas.
- * @param col_counts Vetor que armazena o número de caracteres em cada coluna.
- */
-void reverse_transposition(char *input, char *key, int key_length, char columns[][MAX_MESSAGE_LENGTH], int col_counts[])
-{
-    int len = strlen(input);
-    int rows = len / key_length;
-    int extra = len % key_length;
-
-    // 1) monta o vetor “order” com os índices 0,1,2,...,key_length-1
-    int order[key_length];
-    for (int i = 0; i < key_length; i++)
-    {
-        order[i] = i;
-    }
-
-    // 2) ordena esse vetor “order” segundo key[i], para saber a ordem alfabética da chave
-    for (int i = 0; i < key_length - 1; i++)
-    {
-        for (int j = 0; j < key_length - i - 1; j++)
-        {
-            if (key[order[j]] > key[order[j + 1]])
-            {
-                int tmp = order[j];
-                order[j] = order[j + 1];
-                order[j + 1] = tmp;
-            }
-        }
-    }
-
-    // 3) determina quantos símbolos cada coluna (no índice original) vai ter
-    //    — a coluna “orig_index” recebeu rows+1 símbolos se orig_index < extra; senão, só rows.
-    for (int i = 0; i < key_length; i++)
-    {
-        int orig_index = order[i];
-        col_counts[orig_index] = rows + (orig_index < extra ? 1 : 0);
-    }
-
-    // 4) preenche cada “columns[orig_index]” lendo do texto cifrado linearizado
-    int pos = 0;
-    for (int i = 0; i < key_length; i++)
-    {
-        int col_index = order[i]; // a i-ésima coluna (na ordem alfabética) corresponde a columns[col_index]
-        for (int j = 0; j < col_counts[col_index]; j++)
-        {
-            columns[col_index][j] = input[pos++];
-        }
-    }
-}
-
-/**
- * @brief Reverte a organização em colunas, reconstruindo a sequência de símbolos linha a linha.
- *
- * Esta função recria a sequência de símbolos ADFGVX antes da transposição, percorrendo as colunas
- * reconstruídas linha por linha.
- *
- * @param columns Matriz contendo os dados em colunas.
- * @param col_counts Vetor com o número de elementos por coluna.
- * @param key_length Comprimento da chave.
- * @param output Buffer para armazenar a sequência reconstruída de símbolos ADFGVX.
- */
-void reverse_polybius(char columns[][MAX_MESSAGE_LENGTH], int col_counts[], int key_length, char *output)
-{
-    int max_rows = 0, pos = 0;
-
-    for (int i = 0; i < key_length; i++)
-    {
-        if (col_counts[i] > max_rows)
-            max_rows = col_counts[i];
-    }
-
-    for (int r = 0; r < max_rows; r++)
-    {
-        for (int c = 0; c < key_length; c++)
-        {
-            if (r < col_counts[c])
-            {
-                output[pos++] = columns[c][r];
-            }
-        }
-    }
-    output[pos] = '\0';
-}
-
-/**
- * @brief Decodifica pares de símbolos ADFGVX em caracteres da matriz Polybius.
- *
- * Para cada par de símbolos ADFGVX, encontra as coordenadas correspondentes na matriz
- * Polybius e extrai o caractere original.
- *
- * @param pairs Sequência de pares de símbolos ADFGVX.
- * @param message Buffer onde será armazenada a mensagem decodificada.
- */
-void decode_symbols(char *pairs, char *message)
-{
-    int len = strlen(pairs);
-    int msg_index = 0;
-
-    for (int i = 0; i < len; i += 2)
-    {
-        int row = symbol_index(pairs[i]);
-        int col = symbol_index(pairs[i + 1]);
-        if (row >= 0 && col >= 0)
-        {
-            message[msg_index++] = square[row][col];
-        }
-    }
-    message[msg_index] = '\0';
+    return symbol_rank[(unsigned char)c] - 1;
 }
 
 /**
  * @brief Função principal para decodificar a cifra ADFGVX.
  *
- * Executa a sequência de etapas para decifrar o texto cifrado:
- * 1. Reverte a transposição com base na chave.
- * 2. Reagrupa os símbolos em sua ordem original.
- * 3. Decodifica os pares ADFGVX na matriz Polybius.
+ * A posição de cada coluna é calculada a partir do tamanho do texto cifrado e da ordem da chave,
+ * e os pares são lidos direto do texto cifrado e decodificados em uma única passada
+ * (ver adfgvx_ctx_decrypt).
  *
- * @param encrypted_text Texto cifrado.
+ * @param ctx Contexto de cifra, cujos buffers são reutilizados (nenhuma matriz na pilha).
+ * @param encrypted_text Texto cifrado (no máximo 2 * ctx->message_capacity símbolos).
  * @param key Chave de cifra.
- * @param key_length Comprimento da chave.
+ * @param key_length Comprimento da chave (no máximo ctx->key_capacity).
  * @param output Buffer onde a mensagem decodificada será armazenada.
+ * @return int 0 em caso de sucesso, 1 se alguma capacidade do contexto for excedida.
  */
-void decipher_adfgvx(char *encrypted_text, char *key, int key_length, char *output)
+int decipher_adfgvx(adfgvx_ctx *ctx, char *encrypted_text, char *key, int key_length, char *output)
 {
-    char columns[key_length][MAX_MESSAGE_LENGTH];
-    int col_counts[MAX_KEY_LENGTH] = {0};
-    char rearranged[2 * MAX_MESSAGE_LENGTH];
+    int len = strlen(encrypted_text);
 
-    reverse_transposition(encrypted_text, key, key_length, columns, col_counts);
-    reverse_polybius(columns, col_counts, key_length, rearranged);
-    decode_symbols(rearranged, output);
+    return adfgvx_ctx_decrypt(ctx, key, key_length, encrypted_text, len, output, ctx->message_capacity + 1) < 0;
 }
 // ! END DECIPHER FUNCTIONS
 
@@ -368,8 +85,8 @@ void test_get_adfgvx_symbols()
 void test_insert_symbol_to_column()
 {
     int key_length = 3;
-    int max_per_column = MAX_MESSAGE_LENGTH;
-    char matrix[3][MAX_MESSAGE_LENGTH] = {{0}};
+    int max_per_column = TEST_MESSAGE_LENGTH;
+    char matrix[3][TEST_MESSAGE_LENGTH] = {{0}};
     int symbols_per_column[3] = {0};
     int symbol_count = 0;
 
@@ -396,9 +113,9 @@ void test_insert_symbol_to_column()
 void test_polybius_encode_to_columns()
 {
     int key_length = 2;
-    int max_per_column = MAX_MESSAGE_LENGTH;
+    int max_per_column = TEST_MESSAGE_LENGTH;
     char message[] = "AB";
-    char matrix[2][MAX_MESSAGE_LENGTH] = {{0}};
+    char matrix[2][TEST_MESSAGE_LENGTH] = {{0}};
     int symbols_per_column[2] = {0};
 
     polybius_encode_to_columns(key_length, max_per_column, message, matrix, symbols_per_column);
@@ -422,9 +139,9 @@ void test_transpose_columns_by_key_order()
 {
     char key[] = "CAB"; // ordem alfabética: A B C -> índices 2 1 0
     int key_length = 3;
-    int max_per_column = MAX_MESSAGE_LENGTH;
+    int max_per_column = TEST_MESSAGE_LENGTH;
 
-    char matrix[3][MAX_MESSAGE_LENGTH] = {
+    char matrix[3][TEST_MESSAGE_LENGTH] = {
         {'C', '1', '2'},
         {'A', '3', '4'},
         {'B', '5', '6'}};
@@ -449,34 +166,18 @@ void test_transpose_columns_by_key_order()
  * @note Usamos key UM e a messagem LUCAS previamente testadas tanto no site https://www.dcode.fr/adfgvx-cipher, quanto realizando a cifragem manualmente.
     Cifra: Lucas -> XF FA AD GA AG
  */
-void test_decipher(char key[], char original_message[])
+void test_decipher(adfgvx_ctx *ctx, char key[], char original_message[])
 {
     int key_length = strlen(key);
-    int max_per_column = (2 * MAX_MESSAGE_LENGTH + key_length - 1) / key_length;
-
-    // Declara VLA para armazenar os símbolos por coluna
-    char encoded_symbol_matrix[key_length][max_per_column];
-    int symbols_per_column[MAX_KEY_LENGTH] = {0};
-
-    // Cifrar a mensagem
-    cipher_adfgvx(key, key_length, max_per_column, original_message, encoded_symbol_matrix, symbols_per_column);
+    char encrypted[2 * TEST_MESSAGE_LENGTH];
+    char decrypted[TEST_MESSAGE_LENGTH];
 
-    // Linearizar mensagem cifrada
-    char encrypted[2 * MAX_MESSAGE_LENGTH];
-    int pos = 0;
-    for (int i = 0; i < key_length; i++)
-    {
-        for (int j = 0; j < symbols_per_column[i]; j++)
-        {
-            encrypted[pos] = encoded_symbol_matrix[i][j];
-            pos++;
-        }
-    }
-    encrypted[pos] = '\0';
+    // Cifrar a mensagem (o mesmo contexto é reutilizado entre os testes)
+    adfgvx_ctx_reset(ctx);
+    adfgvx_ctx_encrypt(ctx, key, key_length, original_message, strlen(original_message), encrypted, sizeof(encrypted));
 
     // Decifrar
-    char decrypted[MAX_MESSAGE_LENGTH];
-    decipher_adfgvx(encrypted, key, key_length, decrypted);
+    decipher_adfgvx(ctx, encrypted, key, key_length, decrypted);
 
     printf("\t\tMensagem original:   %.20s\n", original_message);
     printf("\t\tMensagem cifrada:    %.20s\n", encrypted);
@@ -499,13 +200,13 @@ void test_execution_time()
 {
     char key[] = "CHAVE123";
     int key_length = strlen(key);
-    char long_message[MAX_MESSAGE_LENGTH];
-    memset(long_message, 'A', MAX_MESSAGE_LENGTH - 1);
-    long_message[MAX_MESSAGE_LENGTH - 1] = '\0';
+    char long_message[TEST_MESSAGE_LENGTH];
+    memset(long_message, 'A', TEST_MESSAGE_LENGTH - 1);
+    long_message[TEST_MESSAGE_LENGTH - 1] = '\0';
 
-    int max_per_column = MAX_MESSAGE_LENGTH;
-    char encoded_symbol_matrix[MAX_KEY_LENGTH][MAX_MESSAGE_LENGTH];
-    int symbols_per_column[MAX_KEY_LENGTH] = {0};
+    int max_per_column = TEST_MESSAGE_LENGTH;
+    char encoded_symbol_matrix[TEST_KEY_LENGTH][TEST_MESSAGE_LENGTH];
+    int symbols_per_column[TEST_KEY_LENGTH] = {0};
 
     clock_t start = clock();
     cipher_adfgvx(key, key_length, max_per_column, long_message, encoded_symbol_matrix, symbols_per_column);
@@ -532,16 +233,16 @@ void test_invalid_character()
     char key[] = "UM";
     int key_length = strlen(key);
     char message[] = "L#UC%AS@!d";
-    int max_per_column = MAX_MESSAGE_LENGTH;
-    char encoded_symbol_matrix[MAX_KEY_LENGTH][MAX_MESSAGE_LENGTH];
-    int symbols_per_column[MAX_KEY_LENGTH] = {0};
+    int max_per_column = TEST_MESSAGE_LENGTH;
+    char encoded_symbol_matrix[TEST_KEY_LENGTH][TEST_MESSAGE_LENGTH];
+    int symbols_per_column[TEST_KEY_LENGTH] = {0};
 
     const char expected_cipher[] = "XFFAADGAAG";
 
     cipher_adfgvx(key, key_length, max_per_column, message, encoded_symbol_matrix, symbols_per_column);
 
     // Construir a mensagem cifrada linearizada
-    char actual_cipher[MAX_MESSAGE_LENGTH] = {0};
+    char actual_cipher[TEST_MESSAGE_LENGTH] = {0};
     int pos = 0;
     for (int i = 0; i < key_length; i++)
     {
@@ -567,50 +268,1997 @@ void test_invalid_character()
 }
 
 /**
- * @brief Função principal que executa os testes.
+ * @brief Verifica se as tabelas de consulta concordam com a matriz Polybius em todos os 256 bytes.
  */
-int main()
+void test_polybius_tables()
 {
-    printf("Executando testes do algoritmo ADFGVX...\n");
+    int errors = 0;
 
-    printf("\n-> Teste: get_adfgvx_symbols get C and reject get #\n");
-    test_get_adfgvx_symbols();
+    for (int c = 0; c < 256; c++)
+    {
+        int in_square = 0;
+        for (int i = 0; i < 6; i++)
+        {
+            for (int j = 0; j < 6; j++)
+            {
+                if (square[i][j] == (char)c)
+                {
+                    in_square = 1;
+                    unsigned short pair = polybius_forward[c];
+                    if (!(pair & POLYBIUS_VALID) || POLYBIUS_ROW(pair) != symbols[i] || POLYBIUS_COL(pair) != symbols[j] ||
+                        polybius_reverse[symbol_rank[(unsigned char)symbols[i]]][symbol_rank[(unsigned char)symbols[j]]] != (char)c)
+                    {
+                        errors++;
+                    }
+                }
+            }
+        }
 
-    printf("\n-> Teste: insert_symbol_to_column insert symbol correctly in the column\n");
-    test_insert_symbol_to_column();
+        if (!in_square && (polybius_forward[c] & POLYBIUS_VALID))
+        {
+            errors++;
+        }
+        int expected_index = -1;
+        for (int i = 0; i < 6; i++)
+        {
+            if (symbols[i] == (char)c)
+                expected_index = i;
+        }
+        if (symbol_index((char)c) != expected_index)
+        {
+            errors++;
+        }
+    }
 
-    printf("\n-> Teste: polybius_encode_to_columns\n");
-    test_polybius_encode_to_columns();
+    if (errors == 0)
+    {
+        printf("\tSucesso: Tabelas de consulta consistentes com a matriz Polybius.\n");
+    }
+    else
+    {
+        printf("\tErro: %d entradas inconsistentes nas tabelas de consulta.\n", errors);
+    }
+}
 
-    printf("\n-> Teste: transpose_columns_by_key_order\n");
-    test_transpose_columns_by_key_order();
+/**
+ * @brief Busca linear original na matriz Polybius, mantida apenas como referência para o teste de custo.
+ */
+int get_adfgvx_symbols_scan(char c, char *row, char *col)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = 0; j < 6; j++)
+        {
+            if (square[i][j] == c)
+            {
+                *row = symbols[i];
+                *col = symbols[j];
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
 
-    printf("\n-> Teste: Decrypting with known encrypting XFFAADGAAG \n");
-    test_decipher("UM", "LUCAS");
+/**
+ * @brief Microbenchmark: compara o custo por byte da busca linear na matriz com a consulta na tabela.
+ */
+void test_lookup_cost()
+{
+    static char text[1 << 20];
+    const char sample[] = "LOREM IPSUM DOLOR SIT AMET, CONSECTETUR 1234567 lorem@ipsum!";
+    int length = sizeof(text);
+    int repeats = 16;
+    volatile unsigned int sink = 0;
 
-    char message[MAX_MESSAGE_LENGTH] = {0};
-    // Ler a messagem
-    int is_file_read = read_file("./message.txt", message, MAX_MESSAGE_LENGTH);
-    if (is_file_read != 0)
+    for (int i = 0; i < length; i++)
     {
-        perror("Error reading file './message.txt'.");
-        return 1;
+        text[i] = sample[i % (sizeof(sample) - 1)];
     }
 
-    printf("\n-> Teste: Decrypting encrypted file \n");
-    test_decipher("SEMB2025", message);
+    clock_t start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        for (int i = 0; i < length; i++)
+        {
+            char row, col;
+            if (get_adfgvx_symbols_scan(text[i], &row, &col))
+                sink += row + col;
+        }
+    }
+    double scan_ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)length * repeats);
 
-    printf("\n-> Teste: Decrypting with medium text \n");
-    test_decipher("SEMB2025", "LOREM IPSUM DOLOR SIT AMET, COMMODO VOLUTPAT. CURABITUR HENDRERIT CURSUS JUSTO, EGET PHARETRA TELLUS VULPUTATE QUIS. PELLENTESQUE ET JUSTO LEO. MAECENAS A EGESTAS ENIM, AC ULTRICES RISUS. UT ET PLACERAT MASSA. LOREM IPSUM DOLOR SIT AMET, CONSECTETUR ADIPISCING ELIT. INTEGER FRINGILLA FINIBUS AUGUE ID SODALES. NULLAM NON FAUCIBUS ANTE. IN PORTTITOR, NIBH ET MATTIS FERMENTUM, VELIT SAPIEN ULLAMCORPER AUGUE, NEC EGESTAS EROS ARCU ID SEM. PELLENTESQUE EU FRINGILLA EX, ID BLANDIT TURPIS. QUISQUE ELIT DOLOR, PORTTITOR A SAPIEN VITAE, MOLESTIE DICTUM TELLUS. SED CONSECTETUR EST NIBH, UT DICTUM EROS EGESTAS SIT AMET. SUSPENDISSE GRAVIDA NEQUE NISL, AT PORTTITOR URNA PORTTITOR ID. NUNC SIT AMET SAPIEN MI. SED POSUERE BLANDIT ENIM AC LUCTUS. PHASELLUS FACILISIS EGET ODIO AC POSUERE. DUIS RUTRUM BIBENDUM ODIO, VITAE VARIUS IPSUM LACINIA A. CRAS QUIS PRETIUM ANTE. DUIS AT AUGUE UT DUI ORNARE MAXIMUS. UT ID LIGULA SED ELIT CONSEQUAT PRETIUM PULVINAR A NISI. PELLENTESQUE DAPIBUS FEUGIAT MAURIS, VEL EGESTAS TORTOR IMPERDIET NON. DONEC TRISTIQUE MASSA NEC EX ELEIFEND VESTIBULUM. VIVAMUS MATTIS SIT AMET VELIT VEL FACILISIS. NULLA FACILISI. DONEC COMMODO QUAM EGET TINCIDUNT HENDRERIT. PROIN MASSA PURUS, CONSECTETUR AC EGESTAS ET, FINIBUS A NEQUE. MAURIS VEL GRAVIDA NISI, ID ELEMENTUM DIAM. SED UT MI LECTUS. AENEAN SCELERISQUE IPSUM MAURIS, NON EUISMOD EST VEHICULA SIT AMET. ALIQUAM NON MAURIS LOREM. NULLA EGESTAS ID MI AC TEMPOR. MORBI A QUAM NON NUNC TEMPUS HENDRERIT. MORBI AT URNA IPSUM. PROIN RHONCUS AUCTOR PURUS AT VESTIBULUM. ETIAM ENIM IPSUM, TEMPUS VEL ELEMENTUM ET, FERMENTUM UT DUI. ETIAM AT QUAM SIT AMET NUNC TEMPUS CONSEQUAT IN ID IPSUM. INTEGER IN TEMPOR LACUS. QUISQUE TINCIDUNT LACINIA ERAT, SED TEMPOR VELIT LOBORTIS IN. PROIN LACINIA DOLOR ANTE, ET ULLAMCORPER ERAT PULVINAR A. MORBI SUSCIPIT DIGNISSIM EROS, UT EFFICITUR DIAM CONVALLIS NEC. INTEGER LAOREET MAURIS VEL TELLUS ELEMENTUM, QUIS PORTA FELIS GRAVIDA. UT AC PURUS QUIS NISI DICTUM CURSUS IN NEC PURUS. PELLENTESQUE A RUTRUM TURPIS, LAOREET LAOREET URNA. DONEC A TELLUS EGET LACUS ALIQUAM VOLUTPAT ID LAOREET SEM. MAURIS UT NEQUE FINIBUS, MATTIS LECTUS AT, VOLUTPAT ORCI. ALIQUAM ERAT VOLUTPAT. UT TINCIDUNT LIBERO IN ANTE PORTA, VITAE TEMPOR EROS RHONCUS. MAURIS ENIM TORTOR, PRETIUM IN ORCI ID, ULTRICES ALIQUET PURUS. NULLAM VEL CURSUS DUI. NAM PRETIUM ULLAMCORPER IPSUM ID CONSEQUAT. INTEGER A QUAM HENDRERIT, DAPIBUS METUS NEC.");
+    start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        for (int i = 0; i < length; i++)
+        {
+            char row, col;
+            if (get_adfgvx_symbols(text[i], &row, &col))
+                sink += row + col;
+        }
+    }
+    double table_ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ((double)length * repeats);
 
-    printf("\n-> Teste: Decrypting with long text \n");
-    test_decipher("SEMB2025", "LOREM IPSUM DOLOR SIT AMET, CONSECTETUR ADIPISCING ELIT. CURABITUR NISI EROS, MAXIMUS A FACILISIS ID, ACCUMSAN NEC TORTOR. MORBI FACILISIS MAGNA SIT AMET TURPIS COMMODO VOLUTPAT. CURABITUR HENDRERIT CURSUS JUSTO, EGET PHARETRA TELLUS VULPUTATE QUIS. PELLENTESQUE ET JUSTO LEO. MAECENAS A EGESTAS ENIM, AC ULTRICES RISUS. UT ET PLACERAT MASSA. LOREM IPSUM DOLOR SIT AMET, CONSECTETUR ADIPISCING ELIT. INTEGER FRINGILLA FINIBUS AUGUE ID SODALES. NULLAM NON FAUCIBUS ANTE. IN PORTTITOR, NIBH ET MATTIS FERMENTUM, VELIT SAPIEN ULLAMCORPER AUGUE, NEC EGESTAS EROS ARCU ID SEM. PELLENTESQUE EU FRINGILLA EX, ID BLANDIT TURPIS. QUISQUE ELIT DOLOR, PORTTITOR A SAPIEN VITAE, MOLESTIE DICTUM TELLUS. SED CONSECTETUR EST NIBH, UT DICTUM EROS EGESTAS SIT AMET. SUSPENDISSE GRAVIDA NEQUE NISL, AT PORTTITOR URNA PORTTITOR ID. NUNC SIT AMET SAPIEN MI. SED POSUERE BLANDIT ENIM AC LUCTUS. PHASELLUS FACILISIS EGET ODIO AC POSUERE. DUIS RUTRUM BIBENDUM ODIO, VITAE VARIUS IPSUM LACINIA A. CRAS QUIS PRETIUM ANTE. DUIS AT AUGUE UT DUI ORNARE MAXIMUS. UT ID LIGULA SED ELIT CONSEQUAT PRETIUM PULVINAR A NISI. PELLENTESQUE DAPIBUS FEUGIAT MAURIS, VEL EGESTAS TORTOR IMPERDIET NON. DONEC TRISTIQUE MASSA NEC EX ELEIFEND VESTIBULUM. VIVAMUS MATTIS SIT AMET VELIT VEL FACILISIS. NULLA FACILISI. DONEC COMMODO QUAM EGET TINCIDUNT HENDRERIT. PROIN MASSA PURUS, CONSECTETUR AC EGESTAS ET, FINIBUS A NEQUE. MAURIS VEL GRAVIDA NISI, ID ELEMENTUM DIAM. SED UT MI LECTUS. AENEAN SCELERISQUE IPSUM MAURIS, NON EUISMOD EST VEHICULA SIT AMET. ALIQUAM NON MAURIS LOREM. NULLA EGESTAS ID MI AC TEMPOR. MORBI A QUAM NON NUNC TEMPUS HENDRERIT. MORBI AT URNA IPSUM. PROIN RHONCUS AUCTOR PURUS AT VESTIBULUM. ETIAM ENIM IPSUM, TEMPUS VEL ELEMENTUM ET, FERMENTUM UT DUI. ETIAM AT QUAM SIT AMET NUNC TEMPUS CONSEQUAT IN ID IPSUM. INTEGER IN TEMPOR LACUS. QUISQUE TINCIDUNT LACINIA ERAT, SED TEMPOR VELIT LOBORTIS IN. PROIN LACINIA DOLOR ANTE, ET ULLAMCORPER ERAT PULVINAR A. MORBI SUSCIPIT DIGNISSIM EROS, UT EFFICITUR DIAM CONVALLIS NEC. INTEGER LAOREET MAURIS VEL TELLUS ELEMENTUM, QUIS PORTA FELIS GRAVIDA. UT AC PURUS QUIS NISI DICTUM CURSUS IN NEC PURUS. PELLENTESQUE A RUTRUM TURPIS, LAOREET LAOREET URNA. DONEC A TELLUS EGET LACUS ALIQUAM VOLUTPAT ID LAOREET SEM. MAURIS UT NEQUE FINIBUS, MATTIS LECTUS AT, VOLUTPAT ORCI. ALIQUAM ERAT VOLUTPAT. UT TINCIDUNT LIBERO IN ANTE PORTA, VITAE TEMPOR EROS RHONCUS. MAURIS ENIM TORTOR, PRETIUM IN ORCI ID, ULTRICES ALIQUET PURUS. NULLAM VEL CURSUS DUI. NAM PRETIUM ULLAMCORPER IPSUM ID CONSEQUAT. INTEGER A QUAM HENDRERIT, DAPIBUS METUS NEC.");
+    printf("\t\tCusto por byte: busca na matriz %.2f ns, tabela %.2f ns\n", scan_ns, table_ns);
 
-    printf("\n-> Teste: Execution Time\n");
-    test_execution_time();
+    if (table_ns <= scan_ns)
+    {
+        printf("\tSucesso: Consulta na tabela não é mais lenta que a busca na matriz.\n");
+    }
+    else
+    {
+        printf("\tErro: Consulta na tabela mais lenta que a busca na matriz.\n");
+    }
+}
 
-    printf("\n-> Teste: Invalid characters \n");
-    test_invalid_character();
+/**
+ * @brief Lineariza a saída de cipher_adfgvx (matriz de colunas) para comparação.
+ */
+int linearize_columns(int key_length, int max_per_column, char encoded_symbol_matrix[key_length][max_per_column], int symbols_per_column[], char output[])
+{
+    int pos = 0;
+    for (int i = 0; i < key_length; i++)
+    {
+        for (int j = 0; j < symbols_per_column[i]; j++)
+        {
+            output[pos++] = encoded_symbol_matrix[i][j];
+        }
+    }
+    output[pos] = '\0';
+    return pos;
+}
+
+/**
+ * @brief Verifica se a transposição com escrita direta gera o mesmo texto cifrado da matriz de colunas.
+ *
+ * Inclui chaves com letras repetidas (desempate estável) e mensagens com caracteres inválidos.
+ */
+void test_cipher_adfgvx_direct()
+{
+    char *keys[] = {"UM", "CAB", "SEMB2025", "AAAA", "BANANA", "Z"};
+    char *messages[] = {"LUCAS", "L#UC%AS@!d", "", "ATTACK AT DAWN, 1234567.", "X"};
+    int errors = 0;
+
+    for (int k = 0; k < (int)(sizeof(keys) / sizeof(keys[0])); k++)
+    {
+        for (int m = 0; m < (int)(sizeof(messages) / sizeof(messages[0])); m++)
+        {
+            int key_length = strlen(keys[k]);
+            int max_per_column = (2 * TEST_MESSAGE_LENGTH + key_length - 1) / key_length;
+            char encoded_symbol_matrix[key_length][max_per_column];
+            int symbols_per_column[TEST_KEY_LENGTH] = {0};
+            char expected[2 * TEST_MESSAGE_LENGTH], actual[2 * TEST_MESSAGE_LENGTH];
+
+            cipher_adfgvx(keys[k], key_length, max_per_column, messages[m], encoded_symbol_matrix, symbols_per_column);
+            int expected_count = linearize_columns(key_length, max_per_column, encoded_symbol_matrix, symbols_per_column, expected);
+            int actual_count = cipher_adfgvx_direct(keys[k], key_length, messages[m], actual);
+
+            if (expected_count != actual_count || strcmp(expected, actual) != 0)
+            {
+                printf("\t\tDivergência com chave %s e mensagem '%s': %s != %s\n", keys[k], messages[m], actual, expected);
+                errors++;
+            }
+        }
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Escrita direta idêntica à transposição por matriz.\n");
+    }
+    else
+    {
+        printf("\tErro: %d combinações divergentes.\n", errors);
+    }
+}
+
+/**
+ * @brief Compara a latência de cifragem da matriz de colunas com a da escrita direta.
+ */
+void test_direct_latency()
+{
+    char key[] = "CHAVE123";
+    int key_length = strlen(key);
+    int repeats = 2000;
+    char message[TEST_MESSAGE_LENGTH];
+    char encrypted[2 * TEST_MESSAGE_LENGTH];
+    int max_per_column = (2 * TEST_MESSAGE_LENGTH + key_length - 1) / key_length;
+    char encoded_symbol_matrix[key_length][max_per_column];
+    int symbols_per_column[TEST_KEY_LENGTH];
+    volatile int sink = 0;
+
+    memset(message, 'A', TEST_MESSAGE_LENGTH - 1);
+    message[TEST_MESSAGE_LENGTH - 1] = '\0';
+
+    clock_t start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        memset(symbols_per_column, 0, sizeof(symbols_per_column));
+        cipher_adfgvx(key, key_length, max_per_column, message, encoded_symbol_matrix, symbols_per_column);
+        sink += encoded_symbol_matrix[0][0];
+    }
+    double matrix_us = (double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / repeats;
+
+    start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        sink += cipher_adfgvx_direct(key, key_length, message, encrypted);
+    }
+    double direct_us = (double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / repeats;
+
+    // Caminho do contexto: kernel Polybius da CPU + leitura das colunas na ordem da chave
+    static char arena_memory[1 << 15];
+    adfgvx_arena arena;
+    adfgvx_ctx ctx;
+    adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+    adfgvx_ctx_init(&ctx, &arena, TEST_MESSAGE_LENGTH, TEST_KEY_LENGTH);
+
+    start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        sink += adfgvx_ctx_encrypt(&ctx, key, key_length, message, TEST_MESSAGE_LENGTH - 1, encrypted, sizeof(encrypted));
+    }
+    double ctx_us = (double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / repeats;
+
+    printf("\t\tLatência por mensagem de %d caracteres: matriz %.2f us, escrita direta %.2f us, contexto (kernel %s) %.2f us\n",
+           TEST_MESSAGE_LENGTH - 1, matrix_us, direct_us, ctx.kernel->name, ctx_us);
+
+    if (direct_us <= matrix_us)
+    {
+        printf("\tSucesso: Escrita direta não é mais lenta que a matriz de colunas.\n");
+    }
+    else
+    {
+        printf("\tErro: Escrita direta mais lenta que a matriz de colunas.\n");
+    }
+}
+
+/**
+ * @brief Verifica a reutilização do contexto: várias mensagens sem realocação e limites de capacidade.
+ */
+void test_ctx_reuse()
+{
+    char arena_memory[4096];
+    adfgvx_arena arena;
+    adfgvx_ctx ctx;
+    char *messages[] = {"LUCAS", "ATTACK AT DAWN, 1234567.", "L#UC%AS@!d"};
+    char expected[64], actual[64];
+    int errors = 0;
+
+    adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+    if (adfgvx_ctx_init(&ctx, &arena, 32, 8) != 0)
+    {
+        printf("\tErro: Contexto não coube na arena.\n");
+        return;
+    }
+    size_t used_after_init = arena.used;
+
+    for (int round = 0; round < 1000; round++)
+    {
+        char *message = messages[round % 3];
+        adfgvx_ctx_reset(&ctx);
+        int count = adfgvx_ctx_encrypt(&ctx, "SEMB2025", 8, message, strlen(message), actual, sizeof(actual));
+        int expected_count = cipher_adfgvx_direct("SEMB2025", 8, message, expected);
+
+        if (count != expected_count || strcmp(actual, expected) != 0)
+            errors++;
+    }
+
+    // Nenhuma alocação nova depois da inicialização
+    if (arena.used != used_after_init)
+        errors++;
+
+    // Mensagem, chave e saída maiores que as capacidades são rejeitadas
+    char long_message[40];
+    memset(long_message, 'A', sizeof(long_message));
+    if (adfgvx_ctx_encrypt(&ctx, "SEMB2025", 8, long_message, sizeof(long_message), actual, sizeof(actual)) != -1 ||
+        adfgvx_ctx_encrypt(&ctx, "SEMB20251", 9, "LUCAS", 5, actual, sizeof(actual)) != -1 ||
+        adfgvx_ctx_encrypt(&ctx, "UM", 2, "LUCAS", 5, actual, 10) != -1)
+    {
+        errors++;
+    }
+
+    // Arena pequena demais
+    adfgvx_arena small;
+    adfgvx_arena_init(&small, arena_memory, 64);
+    if (adfgvx_ctx_init(&ctx, &small, 32, 8) == 0)
+        errors++;
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Contexto reutilizado sem alocações e capacidades respeitadas.\n");
+    }
+    else
+    {
+        printf("\tErro: %d falhas na reutilização do contexto.\n", errors);
+    }
+}
+
+/**
+ * @brief Compara cada kernel Polybius suportado com o kernel escalar e mede a vazão em GB/s.
+ *
+ * A entrada mistura caracteres válidos, inválidos e bytes acima de 0x7F, com tamanhos que não são
+ * múltiplos do vetor; a decodificação inclui blocos com símbolos inválidos.
+ */
+void test_polybius_kernels()
+{
+    static char message[1 << 22], expected[2 * (1 << 22)], actual[2 * (1 << 22)];
+    static char expected_text[1 << 22], actual_text[1 << 22];
+    int length = sizeof(message);
+    int errors = 0;
+    unsigned int seed = 12345;
+
+    for (int i = 0; i < length; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        // 7 em cada 8 bytes vêm da matriz; o restante é ruído (inclusive bytes acima de 0x7F)
+        message[i] = (seed >> 16) % 8 ? (&square[0][0])[(seed >> 8) % 36] : (char)(seed >> 20);
+    }
+
+    for (int k = 0; k < polybius_kernel_count; k++)
+    {
+        const polybius_kernel *kernel = &polybius_kernels[k];
+        if (!polybius_kernel_supported(kernel))
+        {
+            printf("\t\tKernel %-7s não suportado nesta CPU\n", kernel->name);
+            continue;
+        }
+
+        // Correção em tamanhos pequenos e em posições desalinhadas
+        for (int n = 0; n < 200; n++)
+        {
+            int expected_count = polybius_encode_scalar(&polybius_default_square, message + n, n, expected);
+            int actual_count = kernel->encode(&polybius_default_square, message + n, n, actual);
+            if (expected_count != actual_count || memcmp(expected, actual, expected_count) != 0)
+                errors++;
+
+            expected_count = polybius_decode_scalar(&polybius_default_square, message + n, n / 2, expected_text);
+            actual_count = kernel->decode(&polybius_default_square, message + n, n / 2, actual_text);
+            if (expected_count != actual_count || memcmp(expected_text, actual_text, expected_count) != 0)
+                errors++;
+        }
+
+        // Vazão de codificação na mensagem completa (a primeira chamada só aquece os buffers)
+        kernel->encode(&polybius_default_square, message, length, actual);
+        clock_t start = clock();
+        int symbol_count = kernel->encode(&polybius_default_square, message, length, actual);
+        double encode_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (symbol_count != polybius_encode_scalar(&polybius_default_square, message, length, expected) || memcmp(expected, actual, symbol_count) != 0)
+            errors++;
+
+        // Vazão de decodificação sobre os símbolos válidos gerados acima
+        kernel->decode(&polybius_default_square, expected, symbol_count / 2, actual_text);
+        start = clock();
+        int char_count = kernel->decode(&polybius_default_square, expected, symbol_count / 2, actual_text);
+        double decode_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (char_count != polybius_decode_scalar(&polybius_default_square, expected, symbol_count / 2, expected_text) || memcmp(expected_text, actual_text, char_count) != 0)
+            errors++;
+
+        printf("\t\tKernel %-7s codificação %.2f GB/s, decodificação %.2f GB/s\n", kernel->name,
+               length / (encode_seconds > 0 ? encode_seconds : 1e-9) / 1e9,
+               symbol_count / (decode_seconds > 0 ? decode_seconds : 1e-9) / 1e9);
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Todos os kernels suportados equivalem ao escalar (kernel escolhido: %s).\n", polybius_select_kernel()->name);
+    }
+    else
+    {
+        printf("\tErro: %d divergências entre os kernels.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica a decifragem em uma única passada (decipher_adfgvx_direct) com chaves de vários tamanhos.
+ *
+ * Chaves de tamanho ímpar fazem pares de símbolos atravessarem o fim de uma linha, e letras repetidas
+ * testam o desempate da ordenação. Caracteres fora da matriz Polybius somem da mensagem decifrada.
+ */
+void test_decipher_direct()
+{
+    char *keys[] = {"K", "UM", "ABA", "SEMB2025", "ZYXWVUTSR"};
+    char message[] = "ATTACK AT DAWN, 1234567. $ignored# THE QUICK BROWN FOX";
+    char expected[sizeof(message)];
+    char encrypted[2 * sizeof(message)];
+    char decrypted[sizeof(message)];
+    int expected_length = 0, errors = 0;
+
+    for (int i = 0; message[i] != '\0'; i++)
+    {
+        char row, col;
+        if (get_adfgvx_symbols(message[i], &row, &col))
+            expected[expected_length++] = message[i];
+    }
+    expected[expected_length] = '\0';
+
+    for (int k = 0; k < (int)(sizeof(keys) / sizeof(keys[0])); k++)
+    {
+        int key_length = strlen(keys[k]);
+        int symbol_count = cipher_adfgvx_direct(keys[k], key_length, message, encrypted);
+        size_t length = decipher_adfgvx_direct(keys[k], key_length, encrypted, symbol_count, decrypted);
+
+        if (length != (size_t)expected_length || strcmp(decrypted, expected) != 0)
+        {
+            printf("\t\tChave '%s': '%s'\n", keys[k], decrypted);
+            errors++;
+        }
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: decipher_adfgvx_direct recupera a mensagem com todas as chaves.\n");
+    }
+    else
+    {
+        printf("\tErro: %d chaves falharam na decifragem.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica a API pública: adfgvx_encrypt/adfgvx_decrypt e as variantes batch com a mesma chave.
+ *
+ * O texto cifrado precisa ser igual ao do contexto, e uma saída pequena demais no batch só afeta a
+ * própria mensagem.
+ */
+void test_library_api(adfgvx_ctx *ctx)
+{
+    char key[] = "SEMB2025";
+    const char *messages[] = {"LUCAS", "ATTACK AT DAWN, 1234567.", "ignored_only", "THE QUICK BROWN FOX"};
+    size_t message_lengths[4], output_lengths[4], decrypted_lengths[4];
+    size_t capacities[4] = {64, 64, 64, 8};
+    char encrypted[4][64], decrypted[4][64], expected[64];
+    char *outputs[4] = {encrypted[0], encrypted[1], encrypted[2], encrypted[3]};
+    char *decrypted_outputs[4] = {decrypted[0], decrypted[1], decrypted[2], decrypted[3]};
+    int errors = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        message_lengths[i] = strlen(messages[i]);
+    }
+
+    // Mensagem única: mesmo resultado do contexto, e ida e volta
+    size_t length = 0, plain_length = 0;
+    char single[64], plain[64];
+    int expected_count = adfgvx_ctx_encrypt(ctx, key, strlen(key), messages[1], message_lengths[1], expected, sizeof(expected));
+    if (adfgvx_encrypt(key, strlen(key), messages[1], message_lengths[1], single, sizeof(single), &length) != 0 ||
+        (int)length != expected_count || strcmp(single, expected) != 0)
+        errors++;
+    if (adfgvx_decrypt(key, strlen(key), single, length, plain, sizeof(plain), &plain_length) != 0 || strcmp(plain, messages[1]) != 0)
+        errors++;
+    if (adfgvx_encrypt(key, strlen(key), messages[1], message_lengths[1], single, length, NULL) == 0)
+        errors++;
+
+    // Batch: a última saída é pequena demais e deve ser a única falha
+    if (adfgvx_encrypt_batch(key, strlen(key), 4, messages, message_lengths, outputs, capacities, output_lengths) != 1 || output_lengths[3] != 0)
+        errors++;
+    if (adfgvx_decrypt_batch(key, strlen(key), 3, (const char *const *)outputs, output_lengths, decrypted_outputs, capacities, decrypted_lengths) != 0)
+        errors++;
+    if (strcmp(decrypted[0], "LUCAS") != 0 || strcmp(decrypted[1], messages[1]) != 0 || decrypted_lengths[2] != 0)
+        errors++;
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: API pública (única e batch) equivale ao contexto e recupera as mensagens.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações da API pública falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica chaves longas: ordenação por contagem contra a inserção original, e a transposição em
+ * blocos contra a escrita/leitura direta de um símbolo por vez, com k = 8, 64, 1024 e 4096.
+ *
+ * Também mede o tempo de cada caminho (cifrar e decifrar) para uma mensagem de 1 MB.
+ */
+void test_long_keys()
+{
+    static const int key_lengths[] = {8, 64, 1024, 4096};
+    static char message[1 << 20], reference[2 << 20], blocked[2 << 20], decrypted[(1 << 20) + 1];
+    static char key[4097];
+    static int order[4096], expected_order[4096];
+    static size_t cursor[4096];
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+    {
+        // Texto com ~6% de bytes inválidos, para que os símbolos não fiquem alinhados às linhas
+        message[i] = i % 17 == 3 ? '#' : square[(i * 7) % 6][(i * 13 / 5) % 6];
+    }
+
+    for (int t = 0; t < 4; t++)
+    {
+        int k = key_lengths[t];
+
+        // Letras repetidas e bytes acima de 0x7F testam o desempate e o sinal da comparação
+        for (int i = 0; i < k; i++)
+            key[i] = (char)(i % 5 == 0 ? 0xC3 : 'A' + (i * 31) % 26);
+        key[k] = '\0';
+
+        for (int i = 0; i < k; i++)
+        {
+            int j = i;
+            while (j > 0 && key[expected_order[j - 1]] > key[i])
+            {
+                expected_order[j] = expected_order[j - 1];
+                j--;
+            }
+            expected_order[j] = i;
+        }
+        compute_column_order(key, k, order);
+        if (memcmp(order, expected_order, sizeof(int) * k) != 0)
+        {
+            printf("\t\tk=%d: ordem das colunas diferente da ordenação por inserção\n", k);
+            errors++;
+        }
+
+        size_t symbol_count = adfgvx_encrypted_length(message, sizeof(message));
+
+        clock_t start = clock();
+        compute_column_offsets(k, order, symbol_count, cursor);
+        scatter_symbols(&polybius_default_square, k, message, sizeof(message), cursor, reference);
+        double direct_ms = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+
+        start = clock();
+        cipher_adfgvx_buffer(key, k, message, sizeof(message), symbol_count, blocked);
+        double blocked_ms = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+
+        start = clock();
+        compute_column_offsets(k, order, symbol_count, cursor);
+        size_t direct_length = gather_decode_symbols(&polybius_default_square, k, reference, symbol_count, cursor, decrypted);
+        double decrypt_direct_ms = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+
+        start = clock();
+        size_t length = decipher_adfgvx_direct(key, k, blocked, symbol_count, decrypted);
+        double decrypt_blocked_ms = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+
+        if (memcmp(reference, blocked, symbol_count) != 0 || length != direct_length || length != symbol_count / 2)
+        {
+            printf("\t\tk=%d: transposição em blocos diverge da escrita direta\n", k);
+            errors++;
+        }
+
+        printf("\t\tk=%4d: cifrar um símbolo por vez %.2f ms, biblioteca %.2f ms; decifrar um símbolo por vez %.2f ms, biblioteca %.2f ms\n",
+               k, direct_ms, blocked_ms, decrypt_direct_ms, decrypt_blocked_ms);
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Chaves longas geram o mesmo texto cifrado e a mesma ordem das colunas.\n");
+    }
+    else
+    {
+        printf("\tErro: %d divergências com chaves longas.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica o cache de escalonamentos: acertos e faltas, ordem LRU de reaproveitamento, entradas
+ * reservadas que não são reaproveitadas, permutação inversa e resultado igual ao caminho com a chave.
+ */
+void test_schedule_cache()
+{
+    static char arena_memory[1 << 14];
+    const char *keys[] = {"SEMB2025", "LUCAS", "MARCUS", "IFCE"};
+    const char message[] = "ATTACK AT DAWN, 1234567.";
+    char expected[64], encrypted[64], decrypted[64];
+    size_t expected_length = 0, length = 0;
+    adfgvx_arena arena;
+    adfgvx_schedule_cache cache;
+    int errors = 0;
+
+    adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+    if (adfgvx_schedule_cache_arena_size(2, 8) > sizeof(arena_memory) || adfgvx_schedule_cache_init(&cache, &arena, 2, 8) != 0)
+    {
+        printf("\tErro: Falha ao inicializar o cache de escalonamentos.\n");
+        return;
+    }
+
+    // Falta, acerto e resultado igual ao caminho que recebe a chave
+    const adfgvx_key_schedule *first = adfgvx_schedule_acquire(&cache, keys[0], strlen(keys[0]));
+    const adfgvx_key_schedule *again = adfgvx_schedule_acquire(&cache, keys[0], strlen(keys[0]));
+    if (first == NULL || again != first || cache.hits != 1 || cache.misses != 1)
+        errors++;
+    for (int i = 0; first != NULL && i < first->key_length; i++)
+    {
+        if (first->rank[first->order[i]] != i)
+            errors++;
+    }
+    adfgvx_encrypt(keys[0], strlen(keys[0]), message, strlen(message), expected, sizeof(expected), &expected_length);
+    if (first == NULL || adfgvx_encrypt_scheduled(first, message, strlen(message), encrypted, sizeof(encrypted), &length) != 0 ||
+        length != expected_length || strcmp(encrypted, expected) != 0)
+        errors++;
+    if (first == NULL || adfgvx_decrypt_scheduled(first, encrypted, length, decrypted, sizeof(decrypted), NULL) != 0 || strcmp(decrypted, message) != 0)
+        errors++;
+    adfgvx_schedule_release(&cache, first);
+    adfgvx_schedule_release(&cache, again);
+
+    // LRU: com SEMB2025 e LUCAS no cache, usar SEMB2025 de novo faz MARCUS reaproveitar a entrada de LUCAS
+    adfgvx_schedule_release(&cache, adfgvx_schedule_acquire(&cache, keys[1], strlen(keys[1])));
+    adfgvx_schedule_release(&cache, adfgvx_schedule_acquire(&cache, keys[0], strlen(keys[0])));
+    adfgvx_schedule_release(&cache, adfgvx_schedule_acquire(&cache, keys[2], strlen(keys[2])));
+    unsigned long misses = cache.misses;
+    adfgvx_schedule_release(&cache, adfgvx_schedule_acquire(&cache, keys[0], strlen(keys[0])));
+    if (cache.misses != misses)
+        errors++;
+    adfgvx_schedule_release(&cache, adfgvx_schedule_acquire(&cache, keys[1], strlen(keys[1])));
+    if (cache.misses != misses + 1)
+        errors++;
+
+    // Entradas reservadas não são reaproveitadas; com todas reservadas, a aquisição falha
+    const adfgvx_key_schedule *pinned_a = adfgvx_schedule_acquire(&cache, keys[0], strlen(keys[0]));
+    const adfgvx_key_schedule *pinned_b = adfgvx_schedule_acquire(&cache, keys[1], strlen(keys[1]));
+    if (pinned_a == NULL || pinned_b == NULL || adfgvx_schedule_acquire(&cache, keys[3], strlen(keys[3])) != NULL)
+        errors++;
+    adfgvx_schedule_release(&cache, pinned_b);
+    const adfgvx_key_schedule *replaced = adfgvx_schedule_acquire(&cache, keys[3], strlen(keys[3]));
+    if (replaced != pinned_b || pinned_a->key_length != (int)strlen(keys[0]) || memcmp(pinned_a->key, keys[0], pinned_a->key_length) != 0)
+        errors++;
+    adfgvx_schedule_release(&cache, pinned_a);
+    adfgvx_schedule_release(&cache, replaced);
+
+    // Chave maior que a capacidade do cache
+    if (adfgvx_schedule_acquire(&cache, "LONGERKEY", 9) != NULL)
+        errors++;
+
+    adfgvx_schedule_cache_destroy(&cache);
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Cache de escalonamentos com acertos, ordem LRU e entradas reservadas corretos.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações do cache de escalonamentos falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica matrizes Polybius próprias: derivação por palavra-chave, compilação das tabelas,
+ * kernels vetoriais contra o escalar, ida e volta com escalonamento e cache, matrizes com outros
+ * caracteres e matrizes inválidas. Também compara a vazão do kernel escolhido com as duas matrizes.
+ */
+void test_custom_square()
+{
+    static char message[1 << 20], symbols_default[2 << 20], symbols_custom[2 << 20], expected[2 << 20], text[(1 << 20) + 1];
+    static char schedule_memory[1 << 12], cache_memory[1 << 13];
+    const char sample[] = "ATTACK AT DAWN, 1234567.";
+    const char *alphanumeric = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    const polybius_kernel *selected = polybius_select_kernel();
+    char cells[POLYBIUS_CELLS], encrypted[64], default_encrypted[64], decrypted[64];
+    polybius_square keyword_square, alnum_square, invalid_square;
+    polybius_square_tables keyword_tables, alnum_tables, invalid_tables;
+    int errors = 0;
+
+    // Palavra-chave: letras sem repetição primeiro, depois o restante da matriz padrão
+    polybius_square_from_keyword("PRIVACY PRIVACY", 15, cells);
+    if (memcmp(cells, "PRIVACY BDEFGHJKLMNOQSTUWXZ,.1234567", POLYBIUS_CELLS) != 0)
+        errors++;
+    if (polybius_square_compile(&keyword_square, &keyword_tables, cells) != 0 || !keyword_square.default_alphabet ||
+        polybius_square_compile(&alnum_square, &alnum_tables, alphanumeric) != 0 || alnum_square.default_alphabet)
+        errors++;
+    if (polybius_square_compile(&invalid_square, &invalid_tables, "AACDEFGHIJKLMNOPQRSTUVWXYZ0123456789") == 0)
+        errors++;
+
+    for (int i = 0; i < (int)sizeof(message); i++)
+    {
+        message[i] = i % 23 == 5 ? '#' : (&square[0][0])[(i * 7 + i / 36) % 36];
+    }
+
+    // Kernels vetoriais contra o escalar, nas duas matrizes próprias
+    const polybius_square *squares[] = {&keyword_square, &alnum_square};
+    for (int q = 0; q < 2; q++)
+    {
+        int expected_count = polybius_encode_scalar(squares[q], message, 4099, expected);
+
+        for (int k = 0; k < polybius_kernel_count; k++)
+        {
+            const polybius_kernel *kernel = &polybius_kernels[k];
+            if (!polybius_kernel_supported(kernel))
+                continue;
+
+            int count = kernel->encode(squares[q], message, 4099, symbols_custom);
+            int length = kernel->decode(squares[q], symbols_custom, count / 2, text);
+            int expected_length = polybius_decode_scalar(squares[q], expected, expected_count / 2, text + 4099);
+
+            if (count != expected_count || memcmp(symbols_custom, expected, count) != 0 || length != expected_length ||
+                memcmp(text, text + 4099, length) != 0)
+                errors++;
+        }
+    }
+
+    // Escalonamento com matriz própria: ida e volta, e texto diferente da matriz padrão
+    adfgvx_arena arena;
+    adfgvx_key_schedule schedule;
+    size_t length = 0;
+
+    adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+    adfgvx_key_schedule_init(&schedule, &arena, 8);
+    adfgvx_encrypt("SEMB2025", 8, sample, strlen(sample), default_encrypted, sizeof(default_encrypted), NULL);
+    if (adfgvx_key_schedule_compile_square(&schedule, "SEMB2025", 8, cells) != 0 ||
+        adfgvx_encrypt_scheduled(&schedule, sample, strlen(sample), encrypted, sizeof(encrypted), &length) != 0 ||
+        strcmp(encrypted, default_encrypted) == 0 ||
+        adfgvx_decrypt_scheduled(&schedule, encrypted, length, decrypted, sizeof(decrypted), NULL) != 0 || strcmp(decrypted, sample) != 0)
+        errors++;
+
+    // Matriz alfanumérica: espaço, vírgula e ponto ficam fora da matriz
+    if (adfgvx_key_schedule_compile_square(&schedule, "SEMB2025", 8, alphanumeric) != 0 ||
+        adfgvx_encrypt_scheduled(&schedule, "ATTACK AT 1200", 14, encrypted, sizeof(encrypted), &length) != 0 ||
+        adfgvx_decrypt_scheduled(&schedule, encrypted, length, decrypted, sizeof(decrypted), NULL) != 0 || strcmp(decrypted, "ATTACKAT1200") != 0)
+        errors++;
+
+    // A matriz padrão passada explicitamente usa as tabelas de tempo de compilação
+    if (adfgvx_key_schedule_compile_square(&schedule, "SEMB2025", 8, &square[0][0]) != 0 || schedule.polybius.forward != polybius_forward ||
+        adfgvx_key_schedule_compile_square(&schedule, "SEMB2025", 8, "AACDEFGHIJKLMNOPQRSTUVWXYZ0123456789") == 0)
+        errors++;
+
+    // Cache: a mesma chave com matrizes diferentes ocupa entradas diferentes
+    adfgvx_schedule_cache cache;
+    adfgvx_arena_init(&arena, cache_memory, sizeof(cache_memory));
+    if (adfgvx_schedule_cache_init(&cache, &arena, 4, 8) == 0)
+    {
+        const adfgvx_key_schedule *plain = adfgvx_schedule_acquire(&cache, "SEMB2025", 8);
+        const adfgvx_key_schedule *keyed = adfgvx_schedule_acquire_square(&cache, "SEMB2025", 8, cells);
+        const adfgvx_key_schedule *again = adfgvx_schedule_acquire_square(&cache, "SEMB2025", 8, cells);
+        const adfgvx_key_schedule *same = adfgvx_schedule_acquire_square(&cache, "SEMB2025", 8, &square[0][0]);
+
+        if (plain == NULL || keyed == NULL || plain == keyed || again != keyed || same != plain || cache.misses != 2)
+            errors++;
+        adfgvx_schedule_release(&cache, plain);
+        adfgvx_schedule_release(&cache, keyed);
+        adfgvx_schedule_release(&cache, again);
+        adfgvx_schedule_release(&cache, same);
+        adfgvx_schedule_cache_destroy(&cache);
+    }
+    else
+    {
+        errors++;
+    }
+
+    // Vazão do kernel escolhido: matriz padrão contra a matriz da palavra-chave
+    double seconds[2];
+    const polybius_square *timed[] = {&polybius_default_square, &keyword_square};
+    char *outputs[] = {symbols_default, symbols_custom};
+    int counts[2];
+    for (int q = 0; q < 2; q++)
+    {
+        selected->encode(timed[q], message, sizeof(message), outputs[q]);
+        clock_t start = clock();
+        for (int r = 0; r < 8; r++)
+            counts[q] = selected->encode(timed[q], message, sizeof(message), outputs[q]);
+        seconds[q] = (double)(clock() - start) / CLOCKS_PER_SEC / 8;
+    }
+    if (counts[0] != counts[1])
+        errors++;
+    printf("\t\tKernel %s: matriz padrão %.2f GB/s, matriz com palavra-chave %.2f GB/s\n", selected->name,
+           sizeof(message) / (seconds[0] > 0 ? seconds[0] : 1e-9) / 1e9, sizeof(message) / (seconds[1] > 0 ? seconds[1] : 1e-9) / 1e9);
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Matrizes próprias compiladas equivalem ao escalar e recuperam as mensagens.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações de matrizes próprias falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica a cifragem e a decifragem paralelas de uma única mensagem contra o caminho serial,
+ * com várias chaves e quantidades de threads, incluindo texto cifrado com símbolos inválidos e
+ * quantidade ímpar de símbolos. Também informa o tempo com 1 e 4 threads.
+ */
+void test_parallel()
+{
+    static const int key_lengths[] = {8, 64, 1024};
+    static const int thread_counts[] = {1, 2, 4, 7};
+    static char message[(4 << 20) + 13], expected[8 << 20], encrypted[8 << 20];
+    static char serial[(4 << 20) + 1], decrypted[(4 << 20) + 1], key[1025];
+    static char schedule_memory[1 << 16];
+    size_t expected_length = 0, length = 0;
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+    {
+        // ~6% de bytes inválidos, para que os trechos das threads tenham quantidades diferentes de símbolos
+        message[i] = i % 17 == 3 ? '#' : square[(i * 7) % 6][(i * 13 / 5) % 6];
+    }
+
+    for (int t = 0; t < 3; t++)
+    {
+        int k = key_lengths[t];
+        adfgvx_arena arena;
+        adfgvx_key_schedule schedule;
+
+        for (int i = 0; i < k; i++)
+            key[i] = (char)('A' + (i * 31) % 26);
+
+        adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+        if (adfgvx_key_schedule_init(&schedule, &arena, k) != 0 || adfgvx_key_schedule_compile(&schedule, key, k) != 0 ||
+            adfgvx_encrypt_scheduled(&schedule, message, sizeof(message), expected, sizeof(expected), &expected_length) != 0)
+        {
+            errors++;
+            continue;
+        }
+
+        size_t serial_length = decipher_adfgvx_ordered(&schedule.polybius, schedule.order, k, expected, expected_length, serial);
+        for (int n = 0; n < 4; n++)
+        {
+            if (adfgvx_encrypt_parallel(&schedule, message, sizeof(message), encrypted, sizeof(encrypted), &length, thread_counts[n]) != 0 ||
+                length != expected_length || memcmp(encrypted, expected, length) != 0)
+                errors++;
+            if (adfgvx_decrypt_parallel(&schedule, encrypted, expected_length, decrypted, sizeof(decrypted), &length, thread_counts[n]) != 0 ||
+                length != serial_length || memcmp(decrypted, serial, length + 1) != 0)
+                errors++;
+        }
+
+        // Símbolos inválidos em vários pontos e um símbolo sem par no final
+        memcpy(encrypted, expected, expected_length);
+        for (size_t i = 0; i < expected_length; i += 99991)
+            encrypted[i] = 'Z';
+        serial_length = decipher_adfgvx_ordered(&schedule.polybius, schedule.order, k, encrypted, expected_length - 1, serial);
+        for (int n = 0; n < 4; n++)
+        {
+            length = adfgvx_parallel_decrypt(&schedule, encrypted, expected_length - 1, decrypted, thread_counts[n]);
+            if (length != serial_length || memcmp(decrypted, serial, length + 1) != 0)
+                errors++;
+        }
+    }
+
+    // Capacidade insuficiente
+    adfgvx_arena arena;
+    adfgvx_key_schedule schedule;
+    adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+    adfgvx_key_schedule_init(&schedule, &arena, 8);
+    adfgvx_key_schedule_compile(&schedule, "SEMB2025", 8);
+    if (adfgvx_encrypt_parallel(&schedule, "ATTACK", 6, encrypted, 12, NULL, 2) == 0 ||
+        adfgvx_decrypt_parallel(&schedule, expected, 12, decrypted, 6, NULL, 2) == 0)
+        errors++;
+
+    // Tempo de parede com 1 e 4 threads (o ganho depende da quantidade de CPUs)
+    double seconds[2];
+    for (int n = 0; n < 2; n++)
+    {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        adfgvx_encrypt_parallel(&schedule, message, sizeof(message), encrypted, sizeof(encrypted), &length, n == 0 ? 1 : 4);
+        adfgvx_decrypt_parallel(&schedule, encrypted, length, decrypted, sizeof(decrypted), NULL, n == 0 ? 1 : 4);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds[n] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    printf("\tCifrar + decifrar %zu bytes: 1 thread %.4f s, 4 threads %.4f s\n", sizeof(message), seconds[0], seconds[1]);
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Cifragem e decifragem paralelas idênticas ao caminho serial.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações da cifragem/decifragem paralela falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Função que usa 64 KB de pilha, para verificar a medição do pico de pilha.
+ */
+__attribute__((noinline)) static int use_stack(int seed)
+{
+    volatile char buffer[1 << 16];
+
+    for (size_t i = 0; i < sizeof(buffer); i += 64)
+        buffer[i] = (char)(seed + i);
+    return buffer[seed % sizeof(buffer)];
+}
+
+/**
+ * @brief Thread que mede o próprio pico de pilha, com o seu adfgvx_stats, durante test_stats.
+ */
+static void *measure_stack_thread(void *arg)
+{
+    adfgvx_stats *stats = arg;
+
+    adfgvx_stats_stack_paint(stats);
+    use_stack(3);
+    adfgvx_stats_stack_peak(stats);
+    return NULL;
+}
+
+/**
+ * @brief Verifica a instrumentação: contadores de etapas, bytes e descartes com o contexto, nenhum
+ * efeito com a instrumentação desligada, pico de buffers e pico de pilha.
+ */
+void test_stats()
+{
+    char arena_memory[4096], encrypted[64], decrypted[64];
+    const char message[] = "L#UC%AS@!d ATTACK";
+    adfgvx_stats stats = {0}, untouched = {0};
+    adfgvx_arena arena;
+    adfgvx_ctx ctx;
+    int errors = 0;
+
+    adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+    if (adfgvx_ctx_init(&ctx, &arena, 32, 8) != 0 || ctx.stats != NULL)
+    {
+        printf("\tErro: Contexto sem instrumentação desligada.\n");
+        return;
+    }
+
+    // Desligada: nada é registrado
+    adfgvx_ctx_encrypt(&ctx, "SEMB2025", 8, message, strlen(message), encrypted, sizeof(encrypted));
+    if (memcmp(&stats, &untouched, sizeof(stats)) != 0)
+        errors++;
+
+    // Ligada: "L#UC%AS@!d ATTACK" tem 17 bytes, 5 fora da matriz e 12 válidos
+    ctx.stats = &stats;
+    int symbol_count = adfgvx_ctx_encrypt(&ctx, "SEMB2025", 8, message, strlen(message), encrypted, sizeof(encrypted));
+    if (symbol_count != 24 || stats.calls[ADFGVX_STAGE_ENCODE] != 1 || stats.calls[ADFGVX_STAGE_TRANSPOSE] != 1 ||
+        stats.bytes_in != 17 || stats.bytes_out != 24 || stats.invalid_dropped != 5 || stats.seconds[ADFGVX_STAGE_ENCODE] < 0)
+        errors++;
+
+    encrypted[3] = 'Z';
+    int length = adfgvx_ctx_decrypt(&ctx, "SEMB2025", 8, encrypted, symbol_count, decrypted, sizeof(decrypted));
+    // Um símbolo inválido descarta um par na decifragem
+    if (length != 11 || stats.calls[ADFGVX_STAGE_DECODE] != 1 || stats.calls[ADFGVX_STAGE_TRANSPOSE] != 2 ||
+        stats.bytes_in != 17 + 24 || stats.bytes_out != 24 + 11 || stats.invalid_dropped != 5 + 1)
+        errors++;
+
+    adfgvx_stats_buffer(&stats, 100);
+    adfgvx_stats_buffer(&stats, 50);
+    if (stats.peak_buffer_bytes != 100)
+        errors++;
+
+    // Pico de pilha: uma chamada com 64 KB de variáveis locais, medida ao mesmo tempo em outra thread
+    adfgvx_stats thread_stats = {0};
+    pthread_t thread;
+    int thread_started = pthread_create(&thread, NULL, measure_stack_thread, &thread_stats) == 0;
+    adfgvx_stats_stack_paint(&stats);
+    use_stack(7);
+    size_t peak = adfgvx_stats_stack_peak(&stats);
+    if (thread_started)
+        pthread_join(thread, NULL);
+    if (peak < (1 << 16) || peak > ADFGVX_STACK_PAINT_SIZE || stats.peak_stack_bytes != peak)
+        errors++;
+    if (!thread_started || thread_stats.peak_stack_bytes < (1 << 16) || thread_stats.peak_stack_bytes > ADFGVX_STACK_PAINT_SIZE)
+        errors++;
+    // Sem preenchimento não há medição
+    if (adfgvx_stats_stack_peak(&untouched) != 0 || untouched.peak_stack_bytes != 0)
+        errors++;
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Instrumentação com etapas, bytes, descartes e picos corretos (pilha: %zu bytes).\n", peak);
+    }
+    else
+    {
+        printf("\tErro: %d verificações da instrumentação falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica a cifragem no próprio buffer contra a escrita direta, com vários tamanhos, chaves e
+ * uma matriz própria, e compara RAM e tempo com a matriz de colunas nos tamanhos de mensagem usados.
+ */
+void test_in_place()
+{
+    static const size_t sizes[] = {64, 256, 2560, 1 << 16};
+    static const int key_lengths[] = {1, 5, 8, 64, 1024};
+    static char message[1 << 16], buffer[(2 << 16) + 1], expected[(2 << 16) + 1], key[1025];
+    static int order[1024];
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+        message[i] = i % 13 == 5 ? 'a' : square[(i * 5) % 6][(i * 11 / 3) % 6];
+
+    for (int s = 0; s < 4; s++)
+    {
+        for (int t = 0; t < 5; t++)
+        {
+            int k = key_lengths[t];
+            for (int i = 0; i < k; i++)
+                key[i] = (char)('A' + (i * 17) % 26);
+
+            compute_column_order(key, k, order);
+            cipher_adfgvx_ordered(&polybius_default_square, order, k, message, sizes[s], 2 * count_valid_characters(message, sizes[s]), expected);
+            memcpy(buffer, message, sizes[s]);
+            size_t count = cipher_adfgvx_in_place(&polybius_default_square, order, k, buffer, sizes[s]);
+
+            if (count != 2 * count_valid_characters(message, sizes[s]) || memcmp(buffer, expected, count) != 0 || buffer[count] != '\0')
+                errors++;
+        }
+    }
+
+    // Matriz própria e mensagem vazia
+    char cells[POLYBIUS_CELLS];
+    polybius_square custom;
+    polybius_square_tables tables;
+    polybius_square_from_keyword("PRIVACY", 7, cells);
+    polybius_square_compile(&custom, &tables, cells);
+    compute_column_order("SEMB2025", 8, order);
+    cipher_adfgvx_ordered(&custom, order, 8, message, 2560, 2 * polybius_count_valid(&custom, message, 2560), expected);
+    memcpy(buffer, message, 2560);
+    if (cipher_adfgvx_in_place(&custom, order, 8, buffer, 2560) != 2 * polybius_count_valid(&custom, message, 2560) ||
+        memcmp(buffer, expected, 2 * polybius_count_valid(&custom, message, 2560)) != 0 ||
+        cipher_adfgvx_in_place(&custom, order, 8, buffer, 0) != 0)
+        errors++;
+
+    // RAM e tempo por mensagem, chave de 8 caracteres: matriz de colunas (mensagem, saída e matriz) x no lugar
+    compute_column_order("SEMB2025", 8, order);
+    for (int s = 0; s < 3; s++)
+    {
+        size_t n = sizes[s];
+        int max_per_column = (int)((2 * n + 7) / 8);
+        char (*matrix)[max_per_column] = malloc((size_t)8 * max_per_column);
+        int symbols_per_column[8];
+        double seconds[2];
+        int rounds = 2000;
+
+        for (int path = 0; path < 2; path++)
+        {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int r = 0; r < rounds; r++)
+            {
+                memcpy(buffer, message, n);
+                buffer[n] = '\0';
+                if (path == 0)
+                {
+                    memset(symbols_per_column, 0, sizeof(symbols_per_column));
+                    cipher_adfgvx("SEMB2025", 8, max_per_column, buffer, matrix, symbols_per_column);
+                }
+                else
+                {
+                    cipher_adfgvx_in_place(&polybius_default_square, order, 8, buffer, n);
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            seconds[path] = ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9) / rounds;
+        }
+        free(matrix);
+
+        printf("\t%zu bytes: matriz %zu B de RAM, %.2f us | no lugar %zu B de RAM, %.2f us\n", n,
+               (n + 1) + (2 * n + 1) + (size_t)8 * max_per_column, seconds[0] * 1e6,
+               (2 * n + 1) + 8 * (sizeof(int) + sizeof(size_t)), seconds[1] * 1e6);
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Cifragem no próprio buffer idêntica à escrita direta.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações da cifragem no próprio buffer falharam.\n", errors);
+    }
+}
+
+// Ordena candidatos da busca de chaves pela ordem das colunas, para comparar resultados de execuções diferentes
+static int compare_candidates(const void *a, const void *b)
+{
+    return memcmp(((const adfgvx_key_candidate *)a)->order, ((const adfgvx_key_candidate *)b)->order, sizeof(int) * ADFGVX_SEARCH_MAX_KEY);
+}
+
+// Próxima permutação em ordem lexicográfica; 0 quando `order` já é a última
+static int next_permutation(int order[], int n)
+{
+    int i = n - 2;
+    while (i >= 0 && order[i] > order[i + 1])
+        i--;
+    if (i < 0)
+        return 0;
+
+    int j = n - 1;
+    while (order[j] < order[i])
+        j--;
+    int swap = order[i];
+    order[i] = order[j];
+    order[j] = swap;
+    for (int l = i + 1, r = n - 1; l < r; l++, r--)
+    {
+        swap = order[l];
+        order[l] = order[r];
+        order[r] = swap;
+    }
+    return 1;
+}
+
+/**
+ * @brief Verifica a busca de chaves por crib: a ordem verdadeira está entre os candidatos, os resultados
+ * não dependem da quantidade de threads e parâmetros inválidos são recusados. Compara a taxa de
+ * permutações/s com a decifragem completa de cada permutação (k = 8) e informa o tempo com 1, 2 e 4 threads.
+ */
+void test_key_search()
+{
+    static const int key_lengths[] = {8, 10};
+    static const char *keys[] = {"SEMB2025", "CRYPTOGRAM"};
+    static const int thread_counts[] = {1, 2, 4};
+    static char message[2001], encrypted[4002], decrypted[2001];
+    static char schedule_memory[1 << 12];
+    static adfgvx_key_candidate candidates[3][256];
+    const char *crib = "THE QUICK BROWN FOX ";
+    size_t crib_length = strlen(crib), crib_offset = 731, length = 0;
+    adfgvx_key_search_stats stats[3];
+    double seconds[3];
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message) - 1; i++)
+        message[i] = square[(i * 7) % 6][(i * 13 / 5) % 6];
+    memcpy(message + crib_offset, crib, crib_length);
+
+    for (int t = 0; t < 2; t++)
+    {
+        int k = key_lengths[t], found[3];
+        adfgvx_arena arena;
+        adfgvx_key_schedule schedule;
+
+        adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+        if (adfgvx_key_schedule_init(&schedule, &arena, k) != 0 || adfgvx_key_schedule_compile(&schedule, keys[t], k) != 0 ||
+            adfgvx_encrypt_scheduled(&schedule, message, sizeof(message) - 1, encrypted, sizeof(encrypted), &length) != 0)
+        {
+            errors++;
+            continue;
+        }
+
+        for (int n = 0; n < 3; n++)
+        {
+            struct timespec start, end;
+
+            memset(candidates[n], 0, sizeof(candidates[n]));
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            found[n] = adfgvx_key_search(&polybius_default_square, encrypted, length, k, crib, crib_length, crib_offset, 2,
+                                         thread_counts[n], candidates[n], 256, &stats[n]);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            seconds[n] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+            if (found[n] <= 0 || found[n] > 256 || found[n] != found[0] || stats[n].permutations != stats[0].permutations)
+            {
+                errors++;
+                found[n] = 0;
+                continue;
+            }
+            qsort(candidates[n], found[n], sizeof(adfgvx_key_candidate), compare_candidates);
+            if (memcmp(candidates[n], candidates[0], sizeof(adfgvx_key_candidate) * found[n]) != 0)
+                errors++;
+        }
+
+        // A ordem verdadeira, sem nenhum símbolo diferente
+        int true_order = 0;
+        for (int i = 0; i < found[0]; i++)
+            true_order |= memcmp(candidates[0][i].order, schedule.order, sizeof(int) * k) == 0 && candidates[0][i].mismatches == 0;
+        if (!true_order)
+            errors++;
+
+        printf("\tk = %d: %d candidatos, %llu nós, %.0f permutações cobertas; 1 thread %.4f s (%.3g nós/s), 2 threads %.4f s, 4 threads %.4f s\n",
+               k, found[0], stats[0].nodes, stats[0].permutations, seconds[0], stats[0].nodes / seconds[0], seconds[1], seconds[2]);
+
+        if (k == 8)
+        {
+            // Referência: decifra a mensagem inteira para cada uma das 8! permutações e confere o crib
+            int order[8] = {0, 1, 2, 3, 4, 5, 6, 7}, naive_found = 0;
+            struct timespec start, end;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            do
+            {
+                decipher_adfgvx_ordered(&polybius_default_square, order, k, encrypted, length, decrypted);
+                naive_found += memcmp(decrypted + crib_offset, crib, crib_length) == 0;
+            } while (next_permutation(order, k));
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            double naive_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            printf("\tk = 8, decifragem completa de cada permutação: %.4f s (%.3g perm/s), %.0fx mais lenta\n",
+                   naive_seconds, 40320 / naive_seconds, naive_seconds / seconds[0]);
+
+            // Toda permutação que decifra o crib exatamente também é aceita pela busca
+            int exact = 0;
+            for (int i = 0; i < found[0]; i++)
+                exact += candidates[0][i].mismatches == 0;
+            if (naive_found == 0 || exact != naive_found)
+                errors++;
+        }
+    }
+
+    // Escalabilidade: crib curto e tolerante (k = 12), com muitos nós e candidatos; só as contagens são comparadas
+    int heavy_found[3];
+    for (int n = 0; n < 3; n++)
+    {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        heavy_found[n] = adfgvx_key_search(&polybius_default_square, encrypted, length, 12, crib, 5, crib_offset, 2,
+                                           thread_counts[n], candidates[n], 0, &stats[n]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds[n] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        if (heavy_found[n] != heavy_found[0] || stats[n].nodes != stats[0].nodes)
+            errors++;
+    }
+    printf("\tk = 12, crib de 5 caracteres: %d candidatos, %llu nós; 1 thread %.4f s (%.3g nós/s), 2 threads %.4f s, 4 threads %.4f s\n",
+           heavy_found[0], stats[0].nodes, seconds[0], stats[0].nodes / seconds[0], seconds[1], seconds[2]);
+
+    // Parâmetros inválidos: crib fora da matriz, além do texto cifrado, chave longa demais
+    if (adfgvx_key_search(&polybius_default_square, encrypted, length, 8, "ATT#CK", 6, 0, 0, 1, candidates[0], 256, NULL) != -1 ||
+        adfgvx_key_search(&polybius_default_square, encrypted, length, 8, crib, crib_length, length, 0, 1, candidates[0], 256, NULL) != -1 ||
+        adfgvx_key_search(&polybius_default_square, encrypted, length, ADFGVX_SEARCH_MAX_KEY + 1, crib, crib_length, 0, 0, 1, candidates[0], 256, NULL) != -1)
+        errors++;
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Ordem verdadeira encontrada, com os mesmos candidatos em 1, 2 e 4 threads.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações da busca de chaves falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica a cifragem incremental: depois de cada acréscimo (de tamanhos variados, com bytes inválidos)
+ * o texto cifrado é igual ao da mensagem inteira cifrada de uma vez, e os segmentos de colunas alteradas
+ * reconstroem o texto cifrado a partir do anterior. Informa o tempo de um acréscimo de uma linha com a
+ * mensagem pequena e grande, contra recifrar a mensagem inteira.
+ */
+void test_appender()
+{
+    static const int key_lengths[] = {1, 8, 13, 1024};
+    static const char *line = "2026-10-16 12:00:01 SERVICE RESTARTED, STATUS OK. #42\n";
+    static char journal[1 << 20], expected[(2 << 20) + 1], ciphertext[(2 << 20) + 1], previous[(2 << 20) + 1];
+    static char arena_memory[(2 << 20) + (1 << 16)], schedule_memory[1 << 16], key[1025];
+    adfgvx_column_segment segments[1024];
+    size_t journal_length = 0, expected_length = 0, length = 0, previous_length = 0;
+    int errors = 0;
+
+    for (int t = 0; t < 4; t++)
+    {
+        int k = key_lengths[t];
+        adfgvx_arena arena, schedule_arena;
+        adfgvx_key_schedule schedule;
+        adfgvx_appender appender;
+
+        for (int i = 0; i < k; i++)
+            key[i] = (char)('A' + (i * 31) % 26);
+
+        adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+        adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+        if (adfgvx_key_schedule_init(&schedule, &schedule_arena, k) != 0 || adfgvx_key_schedule_compile(&schedule, key, k) != 0 ||
+            adfgvx_appender_init(&appender, &arena, &schedule, 2 << 20) != 0)
+        {
+            errors++;
+            continue;
+        }
+
+        journal_length = 0;
+        previous_length = 0;
+        for (int step = 0; step < 200; step++)
+        {
+            // Acréscimos de 0 a ~5000 bytes, alguns maiores que um bloco de codificação
+            size_t piece = (size_t)(step * 997) % (step % 10 == 0 ? 9000 : 300);
+            for (size_t i = 0; i < piece; i++)
+                journal[journal_length + i] = line[(journal_length + i) % strlen(line)];
+
+            if (adfgvx_appender_append(&appender, journal + journal_length, piece) < 0)
+            {
+                errors++;
+                break;
+            }
+            journal_length += piece;
+
+            adfgvx_encrypt_scheduled(&schedule, journal, journal_length, expected, sizeof(expected), &expected_length);
+            if (adfgvx_appender_ciphertext(&appender, ciphertext, sizeof(ciphertext), &length) != 0 ||
+                length != expected_length || memcmp(ciphertext, expected, length + 1) != 0)
+                errors++;
+
+            // Reconstrói o texto cifrado atual a partir do anterior e dos segmentos, coluna a coluna
+            int count = adfgvx_appender_changes(&appender, segments);
+            size_t from = 0, to = 0;
+            for (int i = 0, s = 0; i < k; i++)
+            {
+                int column = schedule.order[i];
+                size_t old_length = adfgvx_key_schedule_column_length(&schedule, previous_length, column);
+
+                memcpy(previous + (previous_length + 1) + to, previous + from, old_length);
+                from += old_length;
+                to += old_length;
+                if (s < count && segments[s].column == column)
+                {
+                    if (segments[s].column_offset != old_length || segments[s].ciphertext_offset != to)
+                        errors++;
+                    memcpy(previous + (previous_length + 1) + to, segments[s].symbols, segments[s].length);
+                    to += segments[s++].length;
+                }
+            }
+            memmove(previous, previous + previous_length + 1, to);
+            previous_length = to;
+            if (previous_length != expected_length || memcmp(previous, expected, previous_length) != 0)
+                errors++;
+            adfgvx_appender_commit(&appender);
+            if (adfgvx_appender_changes(&appender, segments) != 0)
+                errors++;
+        }
+
+        // Capacidade: o acréscimo que não cabe é recusado sem alterar nada
+        size_t before = appender.symbol_count;
+        memset(journal, 'A', sizeof(journal));
+        if (adfgvx_appender_append(&appender, journal, 1 << 20) != -1 || appender.symbol_count != before ||
+            adfgvx_appender_ciphertext(&appender, ciphertext, before, NULL) == 0)
+            errors++;
+
+        // Reinício: a mesma cifragem incremental serve para uma nova mensagem
+        adfgvx_appender_reset(&appender);
+        adfgvx_appender_append(&appender, "ATTACK AT DAWN", 14);
+        adfgvx_encrypt_scheduled(&schedule, "ATTACK AT DAWN", 14, expected, sizeof(expected), &expected_length);
+        if (adfgvx_appender_ciphertext(&appender, ciphertext, sizeof(ciphertext), &length) != 0 || length != expected_length ||
+            memcmp(ciphertext, expected, length) != 0)
+            errors++;
+    }
+
+    // Custo de acrescentar uma linha: com 1 KB e com ~1 MB de mensagem, contra recifrar tudo
+    adfgvx_arena arena, schedule_arena;
+    adfgvx_key_schedule schedule;
+    adfgvx_appender appender;
+    adfgvx_arena_init(&schedule_arena, schedule_memory, sizeof(schedule_memory));
+    adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+    adfgvx_key_schedule_init(&schedule, &schedule_arena, 8);
+    adfgvx_key_schedule_compile(&schedule, "SEMB2025", 8);
+    adfgvx_appender_init(&appender, &arena, &schedule, 2 << 20);
+
+    size_t sizes[] = {1024, sizeof(journal) - 2048};
+    for (int n = 0; n < 2; n++)
+    {
+        struct timespec start, end;
+        const int appends = 1000;
+        size_t line_length = strlen(line);
+
+        for (size_t i = 0; i < sizes[n] + appends * line_length && i < sizeof(journal); i++)
+            journal[i] = line[i % line_length];
+        adfgvx_appender_reset(&appender);
+        adfgvx_appender_append(&appender, journal, sizes[n]);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < appends; i++)
+        {
+            adfgvx_appender_append(&appender, line, line_length);
+            adfgvx_appender_changes(&appender, segments);
+            adfgvx_appender_commit(&appender);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double append_us = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / 1e3 / appends;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < 10; i++)
+            adfgvx_encrypt_scheduled(&schedule, journal, sizes[n] + line_length, expected, sizeof(expected), NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double full_us = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / 1e3 / 10;
+
+        printf("\tMensagem de %zu bytes + 1 linha: acréscimo %.2f us, recifrar tudo %.2f us\n", sizes[n], append_us, full_us);
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Acréscimos e segmentos iguais à cifragem da mensagem inteira.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações da cifragem incremental falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica o formato compactado: kernels de compactação iguais ao escalar (ida e volta, símbolos
+ * e bytes inválidos), cifragem compactada igual ao texto cifrado compactado, decifragem direta e
+ * cabeçalho (igual com outra chave, versão desconhecida, dados truncados). Informa bytes e MB/s contra o texto em letras.
+ */
+void test_packed()
+{
+    static const int key_lengths[] = {1, 8, 64, 1024};
+    static char message[(4 << 20) + 7], text[(8 << 20) + 16], symbols[(8 << 20) + 16], decrypted[(4 << 20) + 8], expected[(4 << 20) + 8];
+    static unsigned char packed[(4 << 20) + 64], reference[(4 << 20) + 64];
+    static char schedule_memory[1 << 16], key[1025];
+    size_t text_length = 0, packed_length = 0, length = 0, expected_length = 0;
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+        message[i] = i % 23 == 5 ? '\n' : square[(i * 7) % 6][(i * 13 / 5) % 6];
+
+    // Kernels: todos os tamanhos de 0 a 300 (pares e ímpares) e um bloco grande
+    for (size_t i = 0; i < sizeof(text); i++)
+        text[i] = "ADFGVX"[(i * 7 + i / 5) % 6];
+    for (int k = 0; k < polybius_kernel_count; k++)
+    {
+        const polybius_kernel *kernel = &polybius_kernels[k];
+        if (!polybius_kernel_supported(kernel))
+            continue;
+
+        for (int n = 0; n <= 300; n++)
+        {
+            int bytes = kernel->pack(text + n, n, packed);
+            if (bytes != (n + 1) / 2 || polybius_pack_scalar(text + n, n, reference) != bytes || memcmp(packed, reference, bytes) != 0 ||
+                kernel->unpack(packed, n, symbols) != n || memcmp(symbols, text + n, n) != 0)
+                errors++;
+        }
+
+        int big = 1 << 20;
+        if (kernel->pack(text, big, packed) != big / 2 || kernel->unpack(packed, big, symbols) != big || memcmp(symbols, text, big) != 0)
+            errors++;
+
+        // Um símbolo inválido no meio de um bloco vetorial e um byte acima de 35
+        text[4099] = 'B';
+        packed[2049] = 36;
+        if (kernel->pack(text, 8192, reference) != -1 || kernel->unpack(packed, 8192, symbols) != -1)
+            errors++;
+        text[4099] = 'A';
+    }
+
+    for (int t = 0; t < 4; t++)
+    {
+        int k = key_lengths[t];
+        adfgvx_arena arena;
+        adfgvx_key_schedule schedule;
+
+        for (int i = 0; i < k; i++)
+            key[i] = (char)('A' + (i * 31) % 26);
+
+        adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+        if (adfgvx_key_schedule_init(&schedule, &arena, k) != 0 || adfgvx_key_schedule_compile(&schedule, key, k) != 0)
+        {
+            errors++;
+            continue;
+        }
+
+        for (size_t size = 0; size < sizeof(message); size = size * 9 + 1)
+        {
+            adfgvx_encrypt_scheduled(&schedule, message, size, text, sizeof(text), &text_length);
+            if (adfgvx_encrypt_packed(&schedule, message, size, packed, sizeof(packed), &packed_length) != 0 ||
+                packed_length != adfgvx_packed_size(text_length))
+            {
+                errors++;
+                continue;
+            }
+
+            // O corpo é exatamente o texto cifrado em letras compactado
+            polybius_pack_scalar(text, (int)text_length, reference);
+            if (memcmp(packed + ADFGVX_PACKED_HEADER_SIZE, reference, packed_length - ADFGVX_PACKED_HEADER_SIZE) != 0)
+                errors++;
+
+            adfgvx_decrypt_scheduled(&schedule, text, text_length, expected, sizeof(expected), &expected_length);
+            if (adfgvx_decrypt_packed(&schedule, packed, packed_length, decrypted, sizeof(decrypted), &length) != 0 ||
+                length != expected_length || memcmp(decrypted, expected, length + 1) != 0)
+                errors++;
+        }
+
+        // O cabeçalho só traz a versão do formato, nada derivado da chave: outra chave gera o mesmo cabeçalho
+        adfgvx_encrypt_packed(&schedule, "ATTACK AT DAWN", 14, packed, sizeof(packed), &packed_length);
+        adfgvx_key_schedule other;
+        unsigned char other_packed[64];
+        unsigned int format_version = 0;
+        size_t header_symbols = 0;
+        adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+        adfgvx_key_schedule_init(&other, &arena, 8);
+        adfgvx_key_schedule_compile(&other, "OTHERKEY", 8);
+        adfgvx_encrypt_packed(&other, "ATTACK AT DAWN", 14, other_packed, sizeof(other_packed), NULL);
+        if (memcmp(packed, other_packed, ADFGVX_PACKED_HEADER_SIZE) != 0 ||
+            adfgvx_packed_read_header(packed, packed_length, &header_symbols, &format_version) != 0 ||
+            format_version != ADFGVX_PACKED_VERSION || header_symbols != adfgvx_encrypted_length("ATTACK AT DAWN", 14))
+            errors++;
+
+        // Dados truncados, outra versão e outro formato são recusados
+        adfgvx_packed_write_header(other_packed, header_symbols, ADFGVX_PACKED_VERSION + 1);
+        if (adfgvx_decrypt_packed(&schedule, other_packed, packed_length, decrypted, sizeof(decrypted), NULL) == 0 ||
+            adfgvx_decrypt_packed(&schedule, packed, packed_length - 1, decrypted, sizeof(decrypted), NULL) == 0 ||
+            adfgvx_decrypt_packed(&schedule, (const unsigned char *)"ADFGVXADFGVXADFGVX", 18, decrypted, sizeof(decrypted), NULL) == 0 ||
+            adfgvx_encrypt_packed(&schedule, "ATTACK AT DAWN", 14, packed, packed_length - 1, NULL) == 0)
+            errors++;
+    }
+
+    // Tamanho e vazão com 4 MB e chave de 8 caracteres: letras x compactado, cifrar e decifrar
+    adfgvx_arena arena;
+    adfgvx_key_schedule schedule;
+    adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+    adfgvx_key_schedule_init(&schedule, &arena, 8);
+    adfgvx_key_schedule_compile(&schedule, "SEMB2025", 8);
+
+    double seconds[4];
+    for (int n = 0; n < 4; n++)
+    {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (n == 0)
+            adfgvx_encrypt_scheduled(&schedule, message, sizeof(message), text, sizeof(text), &text_length);
+        else if (n == 1)
+            adfgvx_encrypt_packed(&schedule, message, sizeof(message), packed, sizeof(packed), &packed_length);
+        else if (n == 2)
+            adfgvx_decrypt_scheduled(&schedule, text, text_length, decrypted, sizeof(decrypted), NULL);
+        else
+            adfgvx_decrypt_packed(&schedule, packed, packed_length, decrypted, sizeof(decrypted), NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds[n] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    printf("\t%zu bytes: letras %zu B, compactado %zu B (%.0f%%)\n", sizeof(message), text_length, packed_length, 100.0 * packed_length / text_length);
+    printf("\tCifrar: letras %.0f MB/s, compactado %.0f MB/s | Decifrar: letras %.0f MB/s, compactado %.0f MB/s\n",
+           sizeof(message) / seconds[0] / 1e6, sizeof(message) / seconds[1] / 1e6, sizeof(message) / seconds[2] / 1e6, sizeof(message) / seconds[3] / 1e6);
+
+    const polybius_kernel *selected = polybius_select_kernel();
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 10; i++)
+    {
+        selected->pack(text, (int)text_length, packed);
+        selected->unpack(packed, (int)text_length, symbols);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("\tKernel %s: compactar + descompactar %.2f GB/s de símbolos\n", selected->name,
+           10.0 * text_length / ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9) / 1e9);
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Formato compactado idêntico ao texto cifrado, com decifragem direta.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações do formato compactado falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica o formato do modo stream: blocos cifrados um a um com o cabeçalho de tamanho voltam à
+ * mensagem com adfgvx_decrypt_stream, e texto em letras, dados truncados e blocos vazios são recusados.
+ */
+void test_stream_format()
+{
+    static char message[3 * DEFAULT_MESSAGE_CAPACITY + 100], stream[2 * sizeof(message) + 64], decrypted[sizeof(message) + 1];
+    char schedule_memory[4096];
+    adfgvx_arena arena;
+    adfgvx_key_schedule schedule;
+    size_t stream_length = 0, symbol_count = 0, length = 0;
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+        message[i] = square[(i * 7) % 6][(i * 13 / 5) % 6];
+
+    adfgvx_arena_init(&arena, schedule_memory, sizeof(schedule_memory));
+    adfgvx_key_schedule_init(&schedule, &arena, 8);
+    adfgvx_key_schedule_compile(&schedule, "SEMB2025", 8);
+
+    // Como o --stream: blocos de até DEFAULT_MESSAGE_CAPACITY caracteres, cada um com o seu cabeçalho
+    for (size_t offset = 0; offset < sizeof(message); offset += DEFAULT_MESSAGE_CAPACITY)
+    {
+        size_t chunk = sizeof(message) - offset < DEFAULT_MESSAGE_CAPACITY ? sizeof(message) - offset : DEFAULT_MESSAGE_CAPACITY;
+        size_t chunk_symbols = 0;
+
+        adfgvx_encrypt_scheduled(&schedule, message + offset, chunk, stream + stream_length + ADFGVX_STREAM_HEADER_SIZE,
+                                 sizeof(stream) - stream_length - ADFGVX_STREAM_HEADER_SIZE, &chunk_symbols);
+        adfgvx_stream_write_header((unsigned char *)stream + stream_length, chunk_symbols);
+        stream_length += ADFGVX_STREAM_HEADER_SIZE + chunk_symbols;
+    }
+
+    if (adfgvx_stream_check(stream, stream_length, &symbol_count) != 0 || symbol_count != 2 * sizeof(message) ||
+        adfgvx_decrypt_stream(&schedule, stream, stream_length, decrypted, sizeof(decrypted), &length) != 0 ||
+        length != sizeof(message) || memcmp(decrypted, message, sizeof(message)) != 0)
+        errors++;
+
+    // Texto em letras, dados truncados, bloco vazio e saída pequena demais são recusados
+    char text[64];
+    size_t text_length = 0;
+    unsigned char empty[ADFGVX_STREAM_HEADER_SIZE];
+    adfgvx_encrypt_scheduled(&schedule, "ATTACK AT DAWN", 14, text, sizeof(text), &text_length);
+    adfgvx_stream_write_header(empty, 0);
+    if (adfgvx_stream_check(text, text_length, NULL) == 0 || adfgvx_stream_check(stream, stream_length - 1, NULL) == 0 ||
+        adfgvx_stream_check((const char *)empty, sizeof(empty), NULL) == 0 ||
+        adfgvx_decrypt_stream(&schedule, stream, stream_length, decrypted, sizeof(message) / 2, NULL) == 0)
+        errors++;
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Blocos do modo stream decifrados de volta à mensagem original.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações do formato do modo stream falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica a representação interna com índices (0 a 5) no lugar das letras ADFGVX: a mesma saída da
+ * cifragem e da decifragem em letras, com a matriz padrão e com palavra-chave, a conversão entre as duas formas,
+ * o descarte de índices inválidos nos kernels e a vazão comparada com 4 MB.
+ */
+void test_symbol_indices()
+{
+    static const int key_lengths[] = {1, 8, 31, 32, 1024};
+    static char message[(4 << 20) + 7], text[(8 << 20) + 16], indices[(8 << 20) + 16], symbols[(8 << 20) + 16];
+    static char decrypted[(4 << 20) + 8], expected[(4 << 20) + 8], key[1025];
+    static int order[1024];
+    polybius_square keyword_square, view;
+    polybius_square_tables keyword_tables;
+    char cells[POLYBIUS_CELLS];
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+        message[i] = i % 23 == 5 ? '\n' : square[(i * 7) % 6][(i * 13 / 5) % 6];
+
+    polybius_square_from_keyword("PRIVACIDADE", 11, cells);
+    polybius_square_compile(&keyword_square, &keyword_tables, cells);
+    const polybius_square *squares[] = {&polybius_default_square, &keyword_square};
+
+    for (int q = 0; q < 2; q++)
+    {
+        polybius_square_index_view(squares[q], &view);
+
+        for (int t = 0; t < 5; t++)
+        {
+            int k = key_lengths[t];
+            for (int i = 0; i < k; i++)
+                key[i] = (char)('A' + (i * 31) % 26);
+            compute_column_order(key, k, order);
+
+            for (size_t size = 0; size < sizeof(message); size = size * 9 + 1)
+            {
+                size_t count = 0;
+                for (size_t i = 0; i < size; i++)
+                    count += (squares[q]->forward[(unsigned char)message[i]] & POLYBIUS_VALID) ? 2 : 0;
+
+                // A visão com índices, convertida na saída, produz exatamente o texto cifrado em letras
+                cipher_adfgvx_ordered(squares[q], order, k, message, size, count, text);
+                cipher_adfgvx_ordered(&view, order, k, message, size, count, indices);
+                symbols_from_indices(indices, count, symbols);
+                if (memcmp(symbols, text, count) != 0)
+                    errors++;
+
+                indices_from_symbols(text, count, symbols);
+                if (memcmp(symbols, indices, count) != 0)
+                    errors++;
+
+                size_t expected_length = decipher_adfgvx_ordered(squares[q], order, k, text, count, expected);
+                size_t length = decipher_adfgvx_indices(squares[q], order, k, indices, count, decrypted);
+                if (length != expected_length || memcmp(decrypted, expected, length + 1) != 0)
+                    errors++;
+            }
+        }
+    }
+
+    // Kernels: índices inválidos (acima de 5) descartam o par, como símbolos inválidos nas letras
+    for (size_t i = 0; i < 1 << 20; i++)
+        indices[i] = (char)((i * 7 + i / 5) % 6);
+    indices[4099] = 6;
+    indices[70001] = (char)255;
+    for (int k = 0; k < polybius_kernel_count; k++)
+    {
+        const polybius_kernel *kernel = &polybius_kernels[k];
+        if (!polybius_kernel_supported(kernel))
+            continue;
+
+        for (int n = 0; n <= 300; n++)
+        {
+            int length = kernel->decode_indices(&keyword_square, indices + 4000, n, decrypted);
+            if (polybius_decode_indices_scalar(&keyword_square, indices + 4000, n, expected) != length || memcmp(decrypted, expected, length) != 0)
+                errors++;
+        }
+
+        indices[4099] = indices[70001] = 0;
+        symbols_from_indices(indices, 1 << 20, symbols);
+        indices[4099] = 6;
+        indices[70001] = (char)255;
+        symbols[4099] = symbols[70001] = 'B';
+        int length = kernel->decode_indices(&keyword_square, indices, 1 << 19, decrypted);
+        if (kernel->decode(&keyword_square, symbols, 1 << 19, expected) != length || length != (1 << 19) - 2 || memcmp(decrypted, expected, length) != 0)
+            errors++;
+    }
+
+    // Vazão com 4 MB e chave de 8 caracteres: letras x índices, cifrar e decifrar
+    compute_column_order("SEMB2025", 8, order);
+    size_t count = 0;
+    for (size_t i = 0; i < sizeof(message); i++)
+        count += (polybius_forward[(unsigned char)message[i]] & POLYBIUS_VALID) ? 2 : 0;
+    polybius_square_index_view(&polybius_default_square, &view);
+
+    double seconds[4];
+    for (int n = 0; n < 4; n++)
+    {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (n == 0)
+            cipher_adfgvx_ordered(&polybius_default_square, order, 8, message, sizeof(message), count, text);
+        else if (n == 1)
+            cipher_adfgvx_ordered(&view, order, 8, message, sizeof(message), count, indices);
+        else if (n == 2)
+            decipher_adfgvx_ordered(&polybius_default_square, order, 8, text, count, decrypted);
+        else
+            decipher_adfgvx_indices(&polybius_default_square, order, 8, indices, count, decrypted);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds[n] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    printf("\tCifrar: letras %.0f MB/s, índices %.0f MB/s | Decifrar: letras %.0f MB/s, índices %.0f MB/s\n",
+           sizeof(message) / seconds[0] / 1e6, sizeof(message) / seconds[1] / 1e6, sizeof(message) / seconds[2] / 1e6, sizeof(message) / seconds[3] / 1e6);
+
+    const polybius_kernel *selected = polybius_select_kernel();
+    for (int n = 0; n < 2; n++)
+    {
+        struct timespec start, end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < 10; i++)
+        {
+            if (n == 0)
+                selected->decode(&polybius_default_square, text, (int)(count / 2), decrypted);
+            else
+                selected->decode_indices(&polybius_default_square, indices, (int)(count / 2), decrypted);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds[n] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+    printf("\tKernel %s: decodificar letras %.2f GB/s, índices %.2f GB/s de símbolos\n", selected->name, 10.0 * count / seconds[0] / 1e9,
+           10.0 * count / seconds[1] / 1e9);
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Representação por índices idêntica ao texto cifrado em letras após a conversão.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações da representação por índices falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Verifica o plano de rodadas (adfgvx_round_plan): com 1 a 4 chaves, cifrar e decifrar pelo mapa composto
+ * dá o mesmo resultado das transposições aplicadas uma a uma, e mede as duas formas com 1 MB de mensagem.
+ */
+void test_rounds()
+{
+    static const int key_lengths[] = {1, 8, 13, 64, 1024};
+    static char message[(1 << 20) + 7], expected[(2 << 20) + 16], scratch[(2 << 20) + 16], text[(2 << 20) + 16], decrypted[(1 << 20) + 8];
+    static char schedule_memory[8][1 << 14], plan_memory[(2 << 20) * 8 + 256], keys[8][1025];
+    adfgvx_key_schedule schedules[8];
+    const adfgvx_key_schedule *rounds[8];
+    adfgvx_round_plan plan;
+    adfgvx_arena arena;
+    int errors = 0;
+
+    for (size_t i = 0; i < sizeof(message); i++)
+        message[i] = i % 23 == 5 ? '\n' : square[(i * 7) % 6][(i * 13 / 5) % 6];
+
+    adfgvx_arena_init(&arena, plan_memory, sizeof(plan_memory));
+    if (adfgvx_round_plan_init(&plan, &arena, 2 << 20) != 0)
+        errors++;
+
+    // Oito chaves diferentes (comprimentos variados); a rodada r usa a chave r
+    for (int r = 0; r < 8; r++)
+    {
+        int k = key_lengths[(r * 3 + 1) % 5];
+        for (int i = 0; i < k; i++)
+            keys[r][i] = (char)('A' + (i * 31 + r * 7) % 26);
+
+        adfgvx_arena arena_r;
+        adfgvx_arena_init(&arena_r, schedule_memory[r], sizeof(schedule_memory[r]));
+        adfgvx_key_schedule_init(&schedules[r], &arena_r, k);
+        adfgvx_key_schedule_compile(&schedules[r], keys[r], k);
+        rounds[r] = &schedules[r];
+    }
+
+    for (int round_count = 1; round_count <= 4; round_count++)
+    {
+        for (size_t size = 0; size < sizeof(message); size = size * 9 + 1)
+        {
+            // Referência: codifica e aplica cada rodada como uma passada completa de transposição
+            size_t count = polybius_encode_scalar(&polybius_default_square, message, (int)size, expected);
+            for (int r = 0; r < round_count; r++)
+            {
+                size_t column_start[rounds[r]->key_length];
+                compute_column_offsets(rounds[r]->key_length, rounds[r]->order, count, column_start);
+                gather_columns(expected, 0, count, rounds[r]->key_length, column_start, scratch);
+                memcpy(expected, scratch, count);
+            }
+
+            if (adfgvx_round_plan_compile(&plan, rounds, round_count, count) != 0 ||
+                adfgvx_round_plan_encrypt(&plan, &polybius_default_square, message, size, text) != 0 ||
+                memcmp(text, expected, count) != 0 || text[count] != '\0')
+            {
+                errors++;
+                continue;
+            }
+
+            // Com uma rodada, o mesmo texto cifrado do escalonamento
+            size_t length = 0;
+            if (round_count == 1)
+            {
+                adfgvx_encrypt_scheduled(rounds[0], message, size, scratch, sizeof(scratch), &length);
+                if (length != count || memcmp(scratch, text, count) != 0)
+                    errors++;
+            }
+
+            length = adfgvx_round_plan_decrypt(&plan, &polybius_default_square, text, decrypted);
+            size_t valid = 0;
+            for (size_t i = 0; i < size; i++)
+                if (polybius_forward[(unsigned char)message[i]] & POLYBIUS_VALID)
+                    valid += decrypted[valid] == message[i];
+            if (length != count / 2 || valid != length)
+                errors++;
+        }
+    }
+
+    // Mensagem com outro tamanho e plano maior que a capacidade são recusados
+    adfgvx_round_plan_compile(&plan, rounds, 2, 20);
+    if (adfgvx_round_plan_encrypt(&plan, &polybius_default_square, "ATTACK AT DAWN", 14, text) != -1 ||
+        adfgvx_round_plan_encrypt(&plan, &polybius_default_square, "ATTACK", 6, text) != -1 ||
+        adfgvx_round_plan_compile(&plan, rounds, 2, (2 << 20) + 2) == 0 || adfgvx_round_plan_compile(&plan, rounds, 0, 20) == 0)
+        errors++;
+
+    // Custo com 1 MB: passadas separadas crescem com as rodadas. O plano composto é uma passada só, mas a partir
+    // de 2 rodadas o mapa se espalha pelo texto inteiro e cada escrita cai em outra linha de cache; o custo
+    // sobe até se estabilizar, e fica abaixo das passadas separadas só com várias rodadas
+    size_t count = polybius_encode_scalar(&polybius_default_square, message, sizeof(message), expected);
+    for (int round_count = 1; round_count <= 8; round_count *= 2)
+    {
+        double seconds[3] = {1e9, 1e9, 1e9};
+
+        // Melhor de 3 execuções de cada caminho
+        for (int run = 0; run < 3; run++)
+        {
+            struct timespec start, end;
+            double elapsed;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            polybius_encode_scalar(&polybius_default_square, message, sizeof(message), text);
+            for (int r = 0; r < round_count; r++)
+            {
+                size_t column_start[rounds[r]->key_length];
+                compute_column_offsets(rounds[r]->key_length, rounds[r]->order, count, column_start);
+                gather_columns(text, 0, count, rounds[r]->key_length, column_start, scratch);
+                memcpy(text, scratch, count);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            seconds[0] = elapsed < seconds[0] ? elapsed : seconds[0];
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            adfgvx_round_plan_compile(&plan, rounds, round_count, count);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            seconds[1] = elapsed < seconds[1] ? elapsed : seconds[1];
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            adfgvx_round_plan_encrypt(&plan, &polybius_default_square, message, sizeof(message), scratch);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            seconds[2] = elapsed < seconds[2] ? elapsed : seconds[2];
+        }
+
+        if (memcmp(scratch, text, count) != 0)
+            errors++;
+        printf("\t%d rodada(s): passadas separadas %.2f ms, plano composto %.2f ms (compilação %.2f ms, uma vez por tamanho)\n",
+               round_count, seconds[0] * 1e3, seconds[2] * 1e3, seconds[1] * 1e3);
+    }
+
+    if (errors == 0)
+    {
+        printf("\tSucesso: Rodadas compostas idênticas às transposições aplicadas uma a uma.\n");
+    }
+    else
+    {
+        printf("\tErro: %d verificações das rodadas compostas falharam.\n", errors);
+    }
+}
+
+/**
+ * @brief Função principal que executa os testes.
+ */
+int main()
+{
+    static char arena_memory[1 << 16];
+    adfgvx_arena arena;
+    adfgvx_ctx ctx;
+
+    adfgvx_arena_init(&arena, arena_memory, sizeof(arena_memory));
+    if (adfgvx_ctx_init(&ctx, &arena, TEST_MESSAGE_LENGTH, TEST_KEY_LENGTH) != 0)
+    {
+        printf("Erro: Não foi possível criar o contexto de cifra.\n");
+        return 1;
+    }
+
+    printf("Executando testes do algoritmo ADFGVX...\n");
+
+    printf("\n-> Teste: get_adfgvx_symbols get C and reject get #\n");
+    test_get_adfgvx_symbols();
+
+    printf("\n-> Teste: insert_symbol_to_column insert symbol correctly in the column\n");
+    test_insert_symbol_to_column();
+
+    printf("\n-> Teste: polybius_encode_to_columns\n");
+    test_polybius_encode_to_columns();
+
+    printf("\n-> Teste: transpose_columns_by_key_order\n");
+    test_transpose_columns_by_key_order();
+
+    printf("\n-> Teste: Decrypting with known encrypting XFFAADGAAG \n");
+    test_decipher(&ctx, "UM", "LUCAS");
+
+    char message[TEST_MESSAGE_LENGTH] = {0};
+    // Ler a messagem
+    int is_file_read = read_file("./message.txt", message, TEST_MESSAGE_LENGTH);
+    if (is_file_read != 0)
+    {
+        perror("Error reading file './message.txt'.");
+        return 1;
+    }
+
+    printf("\n-> Teste: Decrypting encrypted file \n");
+    test_decipher(&ctx, "SEMB2025", message);
+
+    printf("\n-> Teste: Decrypting with medium text \n");
+    test_decipher(&ctx, "SEMB2025", "LOREM IPSUM DOLOR SIT AMET, COMMODO VOLUTPAT. CURABITUR HENDRERIT CURSUS JUSTO, EGET PHARETRA TELLUS VULPUTATE QUIS. PELLENTESQUE ET JUSTO LEO. MAECENAS A EGESTAS ENIM, AC ULTRICES RISUS. UT ET PLACERAT MASSA. LOREM IPSUM DOLOR SIT AMET, CONSECTETUR ADIPISCING ELIT. INTEGER FRINGILLA FINIBUS AUGUE ID SODALES. NULLAM NON FAUCIBUS ANTE. IN PORTTITOR, NIBH ET MATTIS FERMENTUM, VELIT SAPIEN ULLAMCORPER AUGUE, NEC EGESTAS EROS ARCU ID SEM. PELLENTESQUE EU FRINGILLA EX, ID BLANDIT TURPIS. QUISQUE ELIT DOLOR, PORTTITOR A SAPIEN VITAE, MOLESTIE DICTUM TELLUS. SED CONSECTETUR EST NIBH, UT DICTUM EROS EGESTAS SIT AMET. SUSPENDISSE GRAVIDA NEQUE NISL, AT PORTTITOR URNA PORTTITOR ID. NUNC SIT AMET SAPIEN MI. SED POSUERE BLANDIT ENIM AC LUCTUS. PHASELLUS FACILISIS EGET ODIO AC POSUERE. DUIS RUTRUM BIBENDUM ODIO, VITAE VARIUS IPSUM LACINIA A. CRAS QUIS PRETIUM ANTE. DUIS AT AUGUE UT DUI ORNARE MAXIMUS. UT ID LIGULA SED ELIT CONSEQUAT PRETIUM PULVINAR A NISI. PELLENTESQUE DAPIBUS FEUGIAT MAURIS, VEL EGESTAS TORTOR IMPERDIET NON. DONEC TRISTIQUE MASSA NEC EX ELEIFEND VESTIBULUM. VIVAMUS MATTIS SIT AMET VELIT VEL FACILISIS. NULLA FACILISI. DONEC COMMODO QUAM EGET TINCIDUNT HENDRERIT. PROIN MASSA PURUS, CONSECTETUR AC EGESTAS ET, FINIBUS A NEQUE. MAURIS VEL GRAVIDA NISI, ID ELEMENTUM DIAM. SED UT MI LECTUS. AENEAN SCELERISQUE IPSUM MAURIS, NON EUISMOD EST VEHICULA SIT AMET. ALIQUAM NON MAURIS LOREM. NULLA EGESTAS ID MI AC TEMPOR. MORBI A QUAM NON NUNC TEMPUS HENDRERIT. MORBI AT URNA IPSUM. PROIN RHONCUS AUCTOR PURUS AT VESTIBULUM. ETIAM ENIM IPSUM, TEMPUS VEL ELEMENTUM ET, FERMENTUM UT DUI. ETIAM AT QUAM SIT AMET NUNC TEMPUS CONSEQUAT IN ID IPSUM. INTEGER IN TEMPOR LACUS. QUISQUE TINCIDUNT LACINIA ERAT, SED TEMPOR VELIT LOBORTIS IN. PROIN LACINIA DOLOR ANTE, ET ULLAMCORPER ERAT PULVINAR A. MORBI SUSCIPIT DIGNISSIM EROS, UT EFFICITUR DIAM CONVALLIS NEC. INTEGER LAOREET MAURIS VEL TELLUS ELEMENTUM, QUIS PORTA FELIS GRAVIDA. UT AC PURUS QUIS NISI DICTUM CURSUS IN NEC PURUS. PELLENTESQUE A RUTRUM TURPIS, LAOREET LAOREET URNA. DONEC A TELLUS EGET LACUS ALIQUAM VOLUTPAT ID LAOREET SEM. MAURIS UT NEQUE FINIBUS, MATTIS LECTUS AT, VOLUTPAT ORCI. ALIQUAM ERAT VOLUTPAT. UT TINCIDUNT LIBERO IN ANTE PORTA, VITAE TEMPOR EROS RHONCUS. MAURIS ENIM TORTOR, PRETIUM IN ORCI ID, ULTRICES ALIQUET PURUS. NULLAM VEL CURSUS DUI. NAM PRETIUM ULLAMCORPER IPSUM ID CONSEQUAT. INTEGER A QUAM HENDRERIT, DAPIBUS METUS NEC.");
+
+    printf("\n-> Teste: Decrypting with long text \n");
+    test_decipher(&ctx, "SEMB2025", "LOREM IPSUM DOLOR SIT AMET, CONSECTETUR ADIPISCING ELIT. CURABITUR NISI EROS, MAXIMUS A FACILISIS ID, ACCUMSAN NEC TORTOR. MORBI FACILISIS MAGNA SIT AMET TURPIS COMMODO VOLUTPAT. CURABITUR HENDRERIT CURSUS JUSTO, EGET PHARETRA TELLUS VULPUTATE QUIS. PELLENTESQUE ET JUSTO LEO. MAECENAS A EGESTAS ENIM, AC ULTRICES RISUS. UT ET PLACERAT MASSA. LOREM IPSUM DOLOR SIT AMET, CONSECTETUR ADIPISCING ELIT. INTEGER FRINGILLA FINIBUS AUGUE ID SODALES. NULLAM NON FAUCIBUS ANTE. IN PORTTITOR, NIBH ET MATTIS FERMENTUM, VELIT SAPIEN ULLAMCORPER AUGUE, NEC EGESTAS EROS ARCU ID SEM. PELLENTESQUE EU FRINGILLA EX, ID BLANDIT TURPIS. QUISQUE ELIT DOLOR, PORTTITOR A SAPIEN VITAE, MOLESTIE DICTUM TELLUS. SED CONSECTETUR EST NIBH, UT DICTUM EROS EGESTAS SIT AMET. SUSPENDISSE GRAVIDA NEQUE NISL, AT PORTTITOR URNA PORTTITOR ID. NUNC SIT AMET SAPIEN MI. SED POSUERE BLANDIT ENIM AC LUCTUS. PHASELLUS FACILISIS EGET ODIO AC POSUERE. DUIS RUTRUM BIBENDUM ODIO, VITAE VARIUS IPSUM LACINIA A. CRAS QUIS PRETIUM ANTE. DUIS AT AUGUE UT DUI ORNARE MAXIMUS. UT ID LIGULA SED ELIT CONSEQUAT PRETIUM PULVINAR A NISI. PELLENTESQUE DAPIBUS FEUGIAT MAURIS, VEL EGESTAS TORTOR IMPERDIET NON. DONEC TRISTIQUE MASSA NEC EX ELEIFEND VESTIBULUM. VIVAMUS MATTIS SIT AMET VELIT VEL FACILISIS. NULLA FACILISI. DONEC COMMODO QUAM EGET TINCIDUNT HENDRERIT. PROIN MASSA PURUS, CONSECTETUR AC EGESTAS ET, FINIBUS A NEQUE. MAURIS VEL GRAVIDA NISI, ID ELEMENTUM DIAM. SED UT MI LECTUS. AENEAN SCELERISQUE IPSUM MAURIS, NON EUISMOD EST VEHICULA SIT AMET. ALIQUAM NON MAURIS LOREM. NULLA EGESTAS ID MI AC TEMPOR. MORBI A QUAM NON NUNC TEMPUS HENDRERIT. MORBI AT URNA IPSUM. PROIN RHONCUS AUCTOR PURUS AT VESTIBULUM. ETIAM ENIM IPSUM, TEMPUS VEL ELEMENTUM ET, FERMENTUM UT DUI. ETIAM AT QUAM SIT AMET NUNC TEMPUS CONSEQUAT IN ID IPSUM. INTEGER IN TEMPOR LACUS. QUISQUE TINCIDUNT LACINIA ERAT, SED TEMPOR VELIT LOBORTIS IN. PROIN LACINIA DOLOR ANTE, ET ULLAMCORPER ERAT PULVINAR A. MORBI SUSCIPIT DIGNISSIM EROS, UT EFFICITUR DIAM CONVALLIS NEC. INTEGER LAOREET MAURIS VEL TELLUS ELEMENTUM, QUIS PORTA FELIS GRAVIDA. UT AC PURUS QUIS NISI DICTUM CURSUS IN NEC PURUS. PELLENTESQUE A RUTRUM TURPIS, LAOREET LAOREET URNA. DONEC A TELLUS EGET LACUS ALIQUAM VOLUTPAT ID LAOREET SEM. MAURIS UT NEQUE FINIBUS, MATTIS LECTUS AT, VOLUTPAT ORCI. ALIQUAM ERAT VOLUTPAT. UT TINCIDUNT LIBERO IN ANTE PORTA, VITAE TEMPOR EROS RHONCUS. MAURIS ENIM TORTOR, PRETIUM IN ORCI ID, ULTRICES ALIQUET PURUS. NULLAM VEL CURSUS DUI. NAM PRETIUM ULLAMCORPER IPSUM ID CONSEQUAT. INTEGER A QUAM HENDRERIT, DAPIBUS METUS NEC.");
+
+    printf("\n-> Teste: Execution Time\n");
+    test_execution_time();
+
+    printf("\n-> Teste: Invalid characters \n");
+    test_invalid_character();
+
+    printf("\n-> Teste: Polybius lookup tables\n");
+    test_polybius_tables();
+
+    printf("\n-> Teste: Lookup cost per byte (matrix scan vs table)\n");
+    test_lookup_cost();
+
+    printf("\n-> Teste: cipher_adfgvx_direct matches the column matrix\n");
+    test_cipher_adfgvx_direct();
+
+    printf("\n-> Teste: Encrypt latency (column matrix vs direct scatter)\n");
+    test_direct_latency();
+
+    printf("\n-> Teste: adfgvx_ctx reuse and capacities\n");
+    test_ctx_reuse();
+
+    printf("\n-> Teste: Polybius SIMD kernels vs scalar (GB/s)\n");
+    test_polybius_kernels();
+
+    printf("\n-> Teste: Single-pass decryption with several key lengths\n");
+    test_decipher_direct();
+
+    printf("\n-> Teste: Library API (adfgvx_encrypt/adfgvx_decrypt and batch)\n");
+    test_library_api(&ctx);
+
+    printf("\n-> Teste: Long keys (counting sort and cache-blocked transposition)\n");
+    test_long_keys();
+
+    printf("\n-> Teste: Key schedule LRU cache\n");
+    test_schedule_cache();
+
+    printf("\n-> Teste: Custom and keyword Polybius squares\n");
+    test_custom_square();
+
+    printf("\n-> Teste: Parallel encrypt/decrypt of a single message\n");
+    test_parallel();
+
+    printf("\n-> Teste: Per-stage instrumentation (adfgvx_stats)\n");
+    test_stats();
+
+    printf("\n-> Teste: In-place encoding and transposition (O(key_length) extra RAM)\n");
+    test_in_place();
+
+    printf("\n-> Teste: Multithreaded crib-based key search\n");
+    test_key_search();
+
+    printf("\n-> Teste: Incremental append (adfgvx_appender)\n");
+    test_appender();
+
+    printf("\n-> Teste: Packed binary ciphertext format\n");
+    test_packed();
+
+    printf("\n-> Teste: Stream format round trip (--stream -> --decrypt)\n");
+    test_stream_format();
+
+    printf("\n-> Teste: Index-based internal symbol representation\n");
+    test_symbol_indices();
+
+    printf("\n-> Teste: Fused multi-round transposition (composed permutations)\n");
+    test_rounds();
 
     return 0;
 }
\ No newline at end of file